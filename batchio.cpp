@@ -0,0 +1,392 @@
+#include <batchio.h>
+#include <stats.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+namespace {
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_FAST_POLL)
+
+// Submission queue size of the ring of each thread; a window of files takes two entries per file
+const unsigned ringEntries = 256;
+
+/**
+ * A minimal io_uring: the submission and completion rings mapped from the kernel, filled
+ * and drained by the one thread owning it.
+ */
+class Ring
+{
+public:
+    explicit Ring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            return;
+        }
+        fd_ = fd;
+        // The open and close operations came with Linux 5.6, fast poll with 5.7
+        if ((params.features & IORING_FEAT_FAST_POLL) == 0) {
+            release();
+            return;
+        }
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+        sqRing_ = map(sqRingSize_, IORING_OFF_SQ_RING);
+        cqRing_ = singleMap ? sqRing_ : map(cqRingSize_, IORING_OFF_CQ_RING);
+        sqes_ = static_cast<io_uring_sqe*>(map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+        if (sqRing_ == nullptr || cqRing_ == nullptr || sqes_ == nullptr) {
+            release();
+            return;
+        }
+
+        char* sq = static_cast<char*>(sqRing_);
+        char* cq = static_cast<char*>(cqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        tail_ = *sqTail_;
+        entries_ = params.sq_entries;
+    }
+
+    ~Ring() {
+        release();
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    bool valid() const { return entries_ > 0; }
+    unsigned capacity() const { return entries_; }
+
+    /**
+     * Queues a cleared submission entry; at most capacity() may be queued before run().
+     */
+    io_uring_sqe* add() {
+        unsigned index = tail_ & sqMask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray_[index] = index;
+        ++tail_;
+        ++queued_;
+        return sqe;
+    }
+
+    /**
+     * Submits the queued entries and waits for all their completions, passing the user data
+     * and the result of each to complete. Returns false (and the ring is no longer valid)
+     * if the kernel refused the submission.
+     */
+    bool run(const std::function<void(uint64_t, int)>& complete) {
+        __atomic_store_n(sqTail_, tail_, __ATOMIC_RELEASE);
+        unsigned unsubmitted = queued_;
+        unsigned waiting = queued_;
+        queued_ = 0;
+        while (waiting > 0) {
+            long submitted = ::syscall(__NR_io_uring_enter, fd_, unsubmitted, waiting, IORING_ENTER_GETEVENTS,
+                                       nullptr, 0);
+            if (submitted < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                release();
+                return false;
+            }
+            unsubmitted -= std::min(unsubmitted, static_cast<unsigned>(submitted));
+
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                complete(cqe.user_data, cqe.res);
+                --waiting;
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    void* map(std::size_t size, off_t offset) {
+        void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    void release() {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, entries_ * sizeof(io_uring_sqe));
+        }
+        if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+            ::munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_ != nullptr) {
+            ::munmap(sqRing_, sqRingSize_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        sqes_ = nullptr;
+        sqRing_ = cqRing_ = nullptr;
+        fd_ = -1;
+        entries_ = 0;
+    }
+
+    int fd_ = -1;
+    unsigned entries_ = 0;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    std::size_t sqRingSize_ = 0;
+    std::size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned tail_ = 0;
+    unsigned queued_ = 0;
+};
+
+/**
+ * Returns the ring of the calling thread, created on first use, or nullptr.
+ */
+Ring* threadRing() {
+    thread_local std::unique_ptr<Ring> ring(new Ring(ringEntries));
+    return ring->valid() ? ring.get() : nullptr;
+}
+
+/**
+ * Runs the files through the ring, a window at a time: one submission opens every file
+ * of the window, a second one reads (or writes) each opened file, hard-linked to its close
+ * so that the close runs even when the transfer fails. Returns false if the ring failed.
+ */
+bool transferFiles(Ring& ring, std::vector<FileRequest>& files, bool write) {
+    const std::size_t window = ring.capacity() / 2;
+    std::vector<int> fds;
+    for (std::size_t first = 0; first < files.size(); first += window) {
+        const std::size_t count = std::min(window, files.size() - first);
+        fds.assign(count, -1);
+        for (std::size_t i = 0; i < count; ++i) {
+            io_uring_sqe* sqe = ring.add();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(files[first + i].path);
+            sqe->open_flags = write ? O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC : O_RDONLY | O_CLOEXEC;
+            sqe->len = write ? 0666 : 0;
+            sqe->user_data = i;
+        }
+        if (!ring.run([&fds](uint64_t i, int result) { fds[i] = result; })) {
+            return false;
+        }
+
+        std::vector<unsigned> lengths(count, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            std::vector<char>& data = files[first + i].data;
+            lengths[i] = static_cast<unsigned>(std::min<std::size_t>(data.size(), 1U << 30));
+            io_uring_sqe* sqe = ring.add();
+            sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+            sqe->fd = fds[i];
+            sqe->addr = reinterpret_cast<uint64_t>(data.data());
+            sqe->len = lengths[i];
+            sqe->off = 0;
+            sqe->flags = IOSQE_IO_HARDLINK;
+            sqe->user_data = 2 * i;
+            sqe = ring.add();
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->fd = fds[i];
+            sqe->user_data = 2 * i + 1;
+        }
+        bool complete = ring.run([&](uint64_t tag, int result) {
+            const std::size_t i = static_cast<std::size_t>(tag / 2);
+            FileRequest& file = files[first + i];
+            if (tag % 2 == 1) {
+                // A close that never ran still owns the descriptor
+                if (result == -ECANCELED) {
+                    ::close(fds[i]);
+                }
+            } else if (write) {
+                file.done = result >= 0 && static_cast<std::size_t>(result) == file.data.size();
+            } else if (result >= 0 && (static_cast<unsigned>(result) < lengths[i] || lengths[i] == file.data.size())) {
+                file.data.resize(static_cast<std::size_t>(result));
+                file.done = true;
+            }
+        });
+        if (!complete) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+void readBlocking(FileRequest& file) {
+    std::ifstream input(file.path, std::ios::binary);
+    if (!input.is_open()) {
+        return;
+    }
+    input.read(file.data.data(), static_cast<std::streamsize>(file.data.size()));
+    if (!input.bad()) {
+        file.data.resize(static_cast<std::size_t>(input.gcount()));
+        file.done = true;
+    }
+}
+
+void writeBlocking(FileRequest& file) {
+    std::ofstream output(file.path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        return;
+    }
+    output.write(file.data.data(), static_cast<std::streamsize>(file.data.size()));
+    output.close();
+    file.done = static_cast<bool>(output);
+}
+
+/**
+ * Transfers the files with the engine, finishing with blocking calls what it did not do.
+ */
+void transfer(std::vector<FileRequest>& files, IoEngine engine, bool write) {
+    Stats::ScopedTimer timer(Stats::Phase::Io);
+    bool batched = false;
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_FAST_POLL)
+    if (engine != IoEngine::Threads && BatchIo::uringSupported()) {
+        Ring* ring = threadRing();
+        batched = ring != nullptr && transferFiles(*ring, files, write);
+    }
+#else
+    (void)engine;
+#endif
+
+    uint64_t bytes = 0;
+    for (FileRequest& file : files) {
+        if (!file.done && !batched) {
+            if (write) {
+                writeBlocking(file);
+            } else {
+                readBlocking(file);
+            }
+        }
+        if (file.done) {
+            bytes += file.data.size();
+        }
+    }
+    Stats::add(write ? Stats::Counter::BytesWritten : Stats::Counter::BytesRead, bytes);
+}
+
+}
+
+namespace BatchIo {
+
+/**
+ * @brief Reads a batch of files.
+ *
+ * A file that could not be opened or read is left with done false, so the caller can go
+ * through its usual path for it and report the error there.
+ * @param files The files; the size of each data is the most bytes read.
+ * @param engine The engine to use.
+ */
+void readFiles(std::vector<FileRequest>& files, IoEngine engine) {
+    transfer(files, engine, false);
+}
+
+/**
+ * @brief Writes a batch of files, creating or truncating them.
+ *
+ * A file that could not be written completely is left with done false.
+ * @param files The files and their contents.
+ * @param engine The engine to use.
+ */
+void writeFiles(std::vector<FileRequest>& files, IoEngine engine) {
+    transfer(files, engine, true);
+}
+
+/**
+ * @brief Tells whether io_uring can be used: Linux 5.7 or later, not disabled by the system.
+ * @return bool - true if a ring could be set up.
+ */
+bool uringSupported() {
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_FAST_POLL)
+    static const bool supported = Ring(2).valid();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Returns the name of an engine, as accepted by parseEngine().
+ * @param engine The engine.
+ * @return const char* - Its name.
+ */
+const char* engineName(IoEngine engine) {
+    switch (engine) {
+    case IoEngine::Auto:
+        return "auto";
+    case IoEngine::Uring:
+        return "io_uring";
+    case IoEngine::Threads:
+        return "threads";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Parses an engine name.
+ * @param name One of auto, io_uring or threads.
+ * @param engine Receives the engine.
+ * @return bool - false if the name is unknown.
+ */
+bool parseEngine(const std::string& name, IoEngine& engine) {
+    for (IoEngine candidate : {IoEngine::Auto, IoEngine::Uring, IoEngine::Threads}) {
+        if (name == engineName(candidate)) {
+            engine = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the engine selected by the MINIGIT_IO_ENGINE environment variable.
+ * @return IoEngine - Auto when the variable is not set or not valid.
+ */
+IoEngine engineFromEnvironment() {
+    IoEngine engine = IoEngine::Auto;
+    const char* value = std::getenv("MINIGIT_IO_ENGINE");
+    if (value != nullptr) {
+        parseEngine(value, engine);
+    }
+    return engine;
+}
+
+}
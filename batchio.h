@@ -0,0 +1,50 @@
+#ifndef BATCHIO_H
+#define BATCHIO_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief How batches of small files are read and written.
+ *
+ * Uring submits the opens of a whole batch to an io_uring at once, then the reads (or
+ * writes) each linked to its close, so a batch of files costs a few system calls instead
+ * of three per file. Threads does the same steps with blocking calls, one file after the
+ * other: batches still run in parallel on the shared thread pool. Auto uses io_uring where
+ * the kernel allows it and falls back to Threads otherwise, as does Uring.
+ */
+enum class IoEngine {
+    Auto,
+    Uring,
+    Threads
+};
+
+/**
+ * @brief One file of a batch.
+ *
+ * The path is NUL-terminated and owned by the caller (typically a PathList), so a batch
+ * does not need a path object per file. For a read, data is sized by the caller to the
+ * most bytes wanted and shrunk to the bytes read (a short read is the end of a regular
+ * file); for a write it holds the whole content, which replaces the file. done tells
+ * whether the file was read or written completely.
+ */
+struct FileRequest
+{
+    const char* path = nullptr;
+    std::vector<char> data;
+    bool done = false;
+};
+
+namespace BatchIo {
+
+void readFiles(std::vector<FileRequest>& files, IoEngine engine = IoEngine::Auto);
+void writeFiles(std::vector<FileRequest>& files, IoEngine engine = IoEngine::Auto);
+bool uringSupported();
+
+const char* engineName(IoEngine engine);
+bool parseEngine(const std::string& name, IoEngine& engine);
+IoEngine engineFromEnvironment();
+
+}
+
+#endif // BATCHIO_H
@@ -0,0 +1,117 @@
+#include <fastcopy.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+
+using namespace std::chrono;
+
+namespace {
+
+// Stored objects end with a 32-byte footer, so revert copies everything but the last 32 bytes
+const uint64_t footerSize = 32;
+
+std::string filesystemName(const fs::path& directory) {
+#ifdef __linux__
+    struct statfs info;
+    if (statfs(directory.c_str(), &info) != 0) {
+        return "unknown";
+    }
+    switch (static_cast<unsigned long>(info.f_type)) {
+    case 0x9123683EUL:
+        return "btrfs";
+    case 0x58465342UL:
+        return "xfs";
+    case 0xEF53UL:
+        return "ext2/3/4";
+    case 0x01021994UL:
+        return "tmpfs";
+    case 0x794C7630UL:
+        return "overlayfs";
+    case 0x2FC12FC1UL:
+        return "zfs";
+    default: {
+        std::ostringstream name;
+        name << "0x" << std::hex << info.f_type;
+        return name.str();
+    }
+    }
+#else
+    (void)directory;
+    return "unknown";
+#endif
+}
+
+void createFile(const fs::path& path, uint64_t size) {
+    std::ofstream output(path, std::ios::binary);
+    std::mt19937_64 random(7);
+    std::vector<uint64_t> block(1 << 17);
+    uint64_t written = 0;
+    while (written < size) {
+        for (auto& value : block) {
+            value = random();
+        }
+        std::size_t count = static_cast<std::size_t>(std::min<uint64_t>(size - written, block.size() * 8));
+        output.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(count));
+        written += count;
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    fs::path directory = argc > 1 ? fs::path(argv[1]) : fs::current_path();
+    uint64_t sizeMiB = argc > 2 ? static_cast<uint64_t>(std::atoll(argv[2])) : 256;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 3;
+    if (sizeMiB == 0 || rounds <= 0 || !fs::is_directory(directory)) {
+        std::cerr << "usage: copybench [directory] [size in MiB] [rounds]" << std::endl;
+        return 1;
+    }
+
+    fs::path source = directory / "copybench_source.bin";
+    fs::path destination = directory / "copybench_destination.bin";
+    uint64_t size = (sizeMiB << 20) + footerSize;
+    createFile(source, size);
+
+    std::cout << "Filesystem: " << filesystemName(directory) << ", " << sizeMiB << " MiB, "
+              << rounds << " rounds" << std::endl;
+    std::cout << std::left << std::setw(18) << "mode" << std::setw(18) << "used"
+              << std::setw(14) << "whole MB/s" << "object MB/s" << std::endl;
+
+    for (CopyMode mode : {CopyMode::Auto, CopyMode::Reflink, CopyMode::CopyFileRange,
+                          CopyMode::SendFile, CopyMode::Buffered}) {
+        CopyMode used = CopyMode::Buffered;
+        double seconds[2] = {0, 0};
+        // Whole file (commit/add clone), then the content range of an object (revert)
+        uint64_t lengths[2] = {size, size - footerSize};
+        for (int kind = 0; kind < 2; ++kind) {
+            for (int round = 0; round < rounds; ++round) {
+                std::error_code ec;
+                fs::remove(destination, ec);
+                auto start = steady_clock::now();
+                used = FastCopy::copyRange(source, 0, lengths[kind], destination, mode);
+                seconds[kind] += duration<double>(steady_clock::now() - start).count();
+            }
+        }
+        double megabytes = static_cast<double>(size) * rounds / (1024.0 * 1024.0);
+        std::cout << std::left << std::setw(18) << FastCopy::modeName(mode)
+                  << std::setw(18) << FastCopy::modeName(used)
+                  << std::setw(14) << std::fixed << std::setprecision(1) << megabytes / seconds[0]
+                  << megabytes / seconds[1] << std::endl;
+    }
+
+    std::error_code ec;
+    fs::remove(source, ec);
+    fs::remove(destination, ec);
+    return 0;
+}
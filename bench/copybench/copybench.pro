@@ -0,0 +1,13 @@
+# Speed of each copy mode on a filesystem, e.g. "copybench /mnt/btrfs 1024".
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    copybench.cpp \
+    ../../fastcopy.cpp
+
+HEADERS += \
+    ../../fastcopy.h
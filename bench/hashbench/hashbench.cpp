@@ -0,0 +1,79 @@
+#include <checksum.h>
+#include <widehash.h>
+
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace {
+
+struct Candidate
+{
+    std::string name;
+    std::unique_ptr<Hasher> hasher;
+};
+
+/**
+ * @brief Hashes the buffer in 1 MiB updates, like the add pipeline does, and returns MB/s.
+ */
+double measure(Hasher& hasher, const std::vector<char>& data, int rounds, Digest& digest) {
+    const std::size_t chunk = 1 << 20;
+    auto start = steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (std::size_t offset = 0; offset < data.size(); offset += chunk) {
+            std::size_t count = std::min(chunk, data.size() - offset);
+            hasher.update(data.data() + offset, count);
+        }
+        digest = hasher.finish();
+    }
+    double elapsed = duration<double>(steady_clock::now() - start).count();
+    double megabytes = static_cast<double>(data.size()) * rounds / (1024.0 * 1024.0);
+    return megabytes / elapsed;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t sizeMiB = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 256;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 3;
+    if (sizeMiB == 0 || rounds <= 0) {
+        std::cerr << "usage: hashbench [size in MiB] [rounds]" << std::endl;
+        return 1;
+    }
+
+    std::vector<char> data(sizeMiB << 20);
+    std::mt19937_64 random(42);
+    for (std::size_t i = 0; i + 8 <= data.size(); i += 8) {
+        uint64_t value = random();
+        std::memcpy(&data[i], &value, 8);
+    }
+
+    std::vector<Candidate> candidates;
+    candidates.push_back({"fnv1a32", std::make_unique<Fnv1a32Hasher>()});
+    candidates.push_back({"fnv1a64", std::make_unique<Fnv1a64Hasher>()});
+    for (auto implementation : {WideHasher::Implementation::Scalar, WideHasher::Implementation::Sse2,
+                                WideHasher::Implementation::Avx2}) {
+        if (WideHasher::isSupported(implementation)) {
+            candidates.push_back({std::string("wide128/") + WideHasher::implementationName(implementation),
+                                  std::make_unique<WideHasher>(implementation)});
+        }
+    }
+
+    std::cout << "Hashing " << sizeMiB << " MiB x " << rounds << " rounds" << std::endl;
+    for (auto& candidate : candidates) {
+        Digest digest;
+        double throughput = measure(*candidate.hasher, data, rounds, digest);
+        std::cout << std::left << std::setw(16) << candidate.name
+                  << std::right << std::setw(10) << std::fixed << std::setprecision(1) << throughput << " MB/s  "
+                  << digest.hex() << std::endl;
+    }
+    return 0;
+}
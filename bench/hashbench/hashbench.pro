@@ -0,0 +1,15 @@
+# Throughput of every hash algorithm/implementation, e.g. "hashbench 512" hashes 512 MiB each.
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    hashbench.cpp \
+    ../../checksum.cpp \
+    ../../widehash.cpp
+
+HEADERS += \
+    ../../checksum.h \
+    ../../widehash.h
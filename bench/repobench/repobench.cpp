@@ -0,0 +1,325 @@
+#include <miniversioncontrol.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct TreeSize
+{
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief A kind of synthetic repository and how to generate it.
+ */
+struct Profile
+{
+    std::string name;
+    std::string description;
+    std::function<TreeSize(const fs::path&, double)> generate;
+};
+
+const char* const words[] = {"int", "return", "const", "std::string", "void", "for", "if", "else",
+                             "namespace", "class", "struct", "auto", "value", "size", "path", "{", "}",
+                             "(", ")", ";", "=", "->", "0", "1", "\n", "    ", "\n    "};
+
+/**
+ * @brief Writes a file of the given size, text-like (compressible) or random, from a fixed seed.
+ */
+void writeFile(const fs::path& path, uint64_t size, uint64_t seed, TreeSize& total) {
+    std::mt19937_64 random(seed);
+    bool text = random() % 10 < 7;
+    std::string content;
+    content.reserve(static_cast<std::size_t>(std::min<uint64_t>(size, 1 << 20)));
+
+    std::ofstream output(path, std::ios::binary);
+    uint64_t written = 0;
+    while (written < size) {
+        content.clear();
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(size - written, 1 << 20));
+        if (text) {
+            while (content.size() < chunk) {
+                const char* word = words[random() % (sizeof(words) / sizeof(words[0]))];
+                content += word;
+                content += ' ';
+            }
+            content.resize(chunk);
+        } else {
+            content.resize(chunk);
+            for (std::size_t i = 0; i < chunk; i += 8) {
+                uint64_t value = random();
+                std::memcpy(&content[i], &value, std::min<std::size_t>(8, chunk - i));
+            }
+        }
+        output.write(content.data(), static_cast<std::streamsize>(chunk));
+        written += chunk;
+    }
+    output.close();
+    if (!output) {
+        throw std::runtime_error("Error writing file: " + path.string());
+    }
+    ++total.files;
+    total.bytes += size;
+}
+
+uint64_t scaled(uint64_t count, double scale) {
+    return std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(count * scale)));
+}
+
+// Many tiny files spread over a few hundred directories
+TreeSize generateTiny(const fs::path& root, double scale) {
+    TreeSize total;
+    std::mt19937_64 random(1);
+    uint64_t files = scaled(20000, scale);
+    for (uint64_t i = 0; i < files; ++i) {
+        fs::path directory = root / ("dir" + std::to_string(i % 200));
+        fs::create_directories(directory);
+        writeFile(directory / ("file" + std::to_string(i) + ".txt"), random() % 512, random(), total);
+    }
+    return total;
+}
+
+// A few huge files
+TreeSize generateHuge(const fs::path& root, double scale) {
+    TreeSize total;
+    fs::create_directories(root);
+    uint64_t size = scaled(64, scale) << 20;
+    for (uint64_t i = 0; i < 4; ++i) {
+        writeFile(root / ("huge" + std::to_string(i) + ".bin"), size, 100 + i, total);
+    }
+    return total;
+}
+
+// One long chain of nested directories with a few small files at every level
+TreeSize generateDeep(const fs::path& root, double scale) {
+    TreeSize total;
+    std::mt19937_64 random(2);
+    uint64_t depth = std::min<uint64_t>(scaled(256, scale), 512);
+    fs::path directory = root;
+    for (uint64_t level = 0; level < depth; ++level) {
+        directory /= "d" + std::to_string(level % 10);
+        fs::create_directories(directory);
+        for (int i = 0; i < 4; ++i) {
+            writeFile(directory / ("f" + std::to_string(i)), 1024 + random() % 2048, random(), total);
+        }
+    }
+    return total;
+}
+
+// Log-normal sizes: mostly small files and a long tail of large ones, like a real source tree
+TreeSize generateSkewed(const fs::path& root, double scale) {
+    TreeSize total;
+    std::mt19937_64 random(3);
+    std::lognormal_distribution<double> sizes(7.0, 2.5);
+    uint64_t files = scaled(5000, scale);
+    for (uint64_t i = 0; i < files; ++i) {
+        fs::path directory = root / ("m" + std::to_string(i % 37)) / ("s" + std::to_string(i % 11));
+        fs::create_directories(directory);
+        uint64_t size = std::min<uint64_t>(static_cast<uint64_t>(sizes(random)), 16 << 20);
+        writeFile(directory / ("file" + std::to_string(i)), size, random(), total);
+    }
+    return total;
+}
+
+TreeSize measureTree(const fs::path& root) {
+    TreeSize total;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            ++total.files;
+            total.bytes += entry.file_size();
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Drops the page cache for everything under a directory.
+ *
+ * Writing to /proc/sys/vm/drop_caches also drops the dentry and inode caches but needs
+ * root; otherwise the data pages of each file are dropped with posix_fadvise.
+ * @return std::string - The method used.
+ */
+std::string evictCaches(const fs::path& root) {
+#ifdef __linux__
+    ::sync();
+    {
+        std::ofstream dropCaches("/proc/sys/vm/drop_caches");
+        if (dropCaches.is_open()) {
+            dropCaches << "3\n";
+            dropCaches.close();
+            if (dropCaches) {
+                return "drop_caches";
+            }
+        }
+    }
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            int fd = ::open(entry.path().c_str(), O_RDONLY);
+            if (fd >= 0) {
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(fd);
+            }
+        }
+    }
+    return "fadvise";
+#else
+    (void)root;
+    return "none";
+#endif
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    std::sort(values.begin(), values.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * values.size()));
+    return values[std::min(values.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+const char* const operations[] = {"init", "add", "commit", "enhancedAddDirectoy", "revert", "listVersions"};
+
+/**
+ * @brief Runs every operation once in a fresh repository and returns their latencies in seconds.
+ */
+std::map<std::string, double> runRound(const fs::path& work, const TreeSize& expected, bool cold,
+                                       std::string& evictMethod) {
+    std::error_code ec;
+    fs::remove_all(work / ".git", ec);
+
+    std::map<std::string, double> latencies;
+    std::unique_ptr<MiniVersionControl> repository;
+    std::string version;
+    auto timed = [&](const std::string& name, const std::function<void()>& operation) {
+        if (cold) {
+            evictMethod = evictCaches(work);
+        }
+        auto start = steady_clock::now();
+        operation();
+        latencies[name] = duration<double>(steady_clock::now() - start).count();
+    };
+
+    timed("init", [&] {
+        repository = std::make_unique<MiniVersionControl>();
+        repository->init();
+    });
+    timed("add", [&] { repository->add("tree"); });
+    timed("commit", [&] { repository->commit("benchmark"); });
+    timed("enhancedAddDirectoy", [&] { repository->enhancedAddDirectoy("tree", ".git/staging/tree"); });
+
+    // Revert into an empty working copy so every file is rebuilt from the object store
+    version = repository->listVersions().front();
+    fs::remove_all(work / "tree");
+    timed("revert", [&] { repository->revert(".git/commits/" + version.substr(0, 10)); });
+    timed("listVersions", [&] { repository->listVersions(); });
+
+    TreeSize reverted = measureTree(work / "tree");
+    if (reverted.files != expected.files || reverted.bytes != expected.bytes) {
+        throw std::runtime_error("revert did not rebuild the tree: " + std::to_string(reverted.files) +
+                                 " files, " + std::to_string(reverted.bytes) + " bytes");
+    }
+    return latencies;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    fs::path directory = argc > 1 ? fs::path(argv[1]) : fs::current_path();
+    double scale = argc > 2 ? std::atof(argv[2]) : 1.0;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+    std::string only = argc > 4 ? argv[4] : "";
+    if (scale <= 0 || rounds <= 0 || !fs::is_directory(directory)) {
+        std::cerr << "usage: repobench [directory] [scale] [rounds] [tiny|huge|deep|skewed]" << std::endl;
+        return 1;
+    }
+    directory = fs::absolute(directory) / "repobench_data";
+
+    std::vector<Profile> profiles = {
+        {"tiny", "many tiny files", generateTiny},
+        {"huge", "a few huge files", generateHuge},
+        {"deep", "deep nesting", generateDeep},
+        {"skewed", "log-normal file sizes", generateSkewed},
+    };
+
+    std::cout << "Scale " << scale << ", " << rounds << " rounds per cache state, compression "
+              << LzCodec::levelName(LzCodec::levelFromEnvironment()) << std::endl;
+
+    try {
+        for (const Profile& profile : profiles) {
+            if (!only.empty() && profile.name != only) {
+                continue;
+            }
+            fs::path work = directory / profile.name;
+            fs::remove_all(work);
+            fs::create_directories(work);
+            TreeSize size = profile.generate(work / "tree", scale);
+            fs::current_path(work);
+
+            std::cout << "\n" << profile.name << " (" << profile.description << "): " << size.files << " files, "
+                      << std::fixed << std::setprecision(1) << size.bytes / 1048576.0 << " MiB" << std::endl;
+            std::cout << std::left << std::setw(7) << "cache" << std::setw(21) << "operation" << std::right
+                      << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "max ms"
+                      << std::setw(10) << "MB/s" << std::setw(12) << "files/s" << std::endl;
+
+            for (bool cold : {false, true}) {
+                std::map<std::string, std::vector<double>> latencies;
+                std::string evictMethod;
+                // The first warm round only fills the page cache
+                for (int round = cold ? 0 : -1; round < rounds; ++round) {
+                    auto measured = runRound(work, size, cold, evictMethod);
+                    if (round >= 0) {
+                        for (const auto& item : measured) {
+                            latencies[item.first].push_back(item.second);
+                        }
+                    }
+                }
+
+                std::string cache = cold ? "cold" : "warm";
+                for (const char* operation : operations) {
+                    const std::vector<double>& values = latencies[operation];
+                    double median = percentile(values, 0.5);
+                    bool throughput = std::strcmp(operation, "init") != 0 && std::strcmp(operation, "listVersions") != 0;
+                    std::cout << std::left << std::setw(7) << cache << std::setw(21) << operation << std::right
+                              << std::fixed << std::setprecision(2)
+                              << std::setw(10) << median * 1000
+                              << std::setw(10) << percentile(values, 0.9) * 1000
+                              << std::setw(10) << percentile(values, 1.0) * 1000 << std::setprecision(1);
+                    if (throughput) {
+                        std::cout << std::setw(10) << size.bytes / 1048576.0 / median
+                                  << std::setw(12) << std::setprecision(0) << size.files / median;
+                    } else {
+                        std::cout << std::setw(10) << "-" << std::setw(12) << "-";
+                    }
+                    std::cout << std::endl;
+                }
+                if (cold) {
+                    std::cout << "(cold cache through " << evictMethod << ")" << std::endl;
+                }
+            }
+            fs::current_path(directory);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "repobench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::error_code ec;
+    fs::current_path(directory.parent_path(), ec);
+    fs::remove_all(directory, ec);
+    return 0;
+}
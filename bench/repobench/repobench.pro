@@ -0,0 +1,10 @@
+# Latency percentiles and throughput of the repository operations on synthetic trees,
+# warm and cold cache, e.g. "repobench /mnt/ssd 0.5 5" (directory, scale, rounds).
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../../core/core.pri)
+
+SOURCES += \
+    repobench.cpp
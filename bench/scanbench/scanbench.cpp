@@ -0,0 +1,189 @@
+#include <dirscanner.h>
+#include <pathtable.h>
+#include <threadpool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std::chrono;
+
+namespace {
+
+// Every top-level directory holds subdirectories * filesPerDirectory files
+const int subdirectories = 10;
+const int filesPerDirectory = 100;
+
+struct Walk
+{
+    std::string name;
+    std::function<std::size_t(const fs::path&)> run;  // Returns the entries found
+};
+
+/**
+ * @brief Creates an empty file; the walks only look at names and types.
+ */
+void touch(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Error creating file: " + path);
+    }
+    ::close(fd);
+#else
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open()) {
+        throw std::runtime_error("Error creating file: " + path);
+    }
+#endif
+}
+
+/**
+ * @brief Generates a tree of about the given number of entries, unless the last run left one.
+ * @return std::size_t - The number of entries under root.
+ */
+std::size_t generate(const fs::path& root, std::size_t entries) {
+    const std::size_t perTop = 1 + subdirectories * (1 + filesPerDirectory);
+    const std::size_t tops = std::max<std::size_t>(1, entries / perTop);
+    const std::size_t total = tops * perTop;
+
+    fs::path stamp = root.parent_path() / "scanbench_entries";
+    std::ifstream previous(stamp);
+    std::size_t existing = 0;
+    if (previous >> existing && existing == total && fs::is_directory(root)) {
+        return total;
+    }
+    previous.close();
+
+    fs::remove_all(root);
+    std::string path;
+    for (std::size_t top = 0; top < tops; ++top) {
+        std::string topPath = (root / ("dir" + std::to_string(top))).string();
+        fs::create_directories(topPath);
+        for (int sub = 0; sub < subdirectories; ++sub) {
+            std::string subPath = topPath + "/sub" + std::to_string(sub);
+            fs::create_directory(subPath);
+            for (int file = 0; file < filesPerDirectory; ++file) {
+                path = subPath + "/file" + std::to_string(file) + ".txt";
+                touch(path);
+            }
+        }
+    }
+    std::ofstream(stamp) << total << "\n";
+    return total;
+}
+
+/**
+ * @brief Drops the dentry and inode caches; needs root.
+ */
+bool evictCaches() {
+#ifdef __linux__
+    ::sync();
+    std::ofstream dropCaches("/proc/sys/vm/drop_caches");
+    if (!dropCaches.is_open()) {
+        return false;
+    }
+    dropCaches << "2\n";
+    dropCaches.close();
+    return static_cast<bool>(dropCaches);
+#else
+    return false;
+#endif
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    fs::path directory = argc > 1 ? fs::path(argv[1]) : fs::current_path();
+    long entries = argc > 2 ? std::atol(argv[2]) : 1000000;
+    int rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+    if (entries <= 0 || rounds <= 0 || !fs::is_directory(directory)) {
+        std::cerr << "usage: scanbench [directory] [entries] [rounds]" << std::endl;
+        return 1;
+    }
+    fs::path root = fs::absolute(directory) / "scanbench_data" / "tree";
+
+    ThreadPool single(1);
+    std::vector<Walk> walks = {
+        {"recursive_directory_iterator", [](const fs::path& tree) {
+            // The walk add and revert did before PathTable, path arithmetic included
+            std::size_t found = 0;
+            for (const auto& entry : fs::recursive_directory_iterator(tree)) {
+                fs::path relative = entry.path().lexically_relative(tree);
+                if (entry.is_regular_file() || entry.is_directory()) {
+                    ++found;
+                }
+            }
+            return found;
+        }},
+        {"PathTable::scan", [](const fs::path& tree) {
+            PathTable table;
+            table.scan(tree);
+            return table.size();
+        }},
+        {"DirScanner::scan, 1 worker", [&single](const fs::path& tree) {
+            PathTable table;
+            DirScanner::scan(tree, table, nullptr, IgnoreFilter(), single);
+            return table.size();
+        }},
+        {"DirScanner::scan, shared pool", [](const fs::path& tree) {
+            PathTable table;
+            DirScanner::scan(tree, table);
+            return table.size();
+        }},
+    };
+
+    try {
+        auto start = steady_clock::now();
+        std::size_t total = generate(root, static_cast<std::size_t>(entries));
+        std::cout << total << " entries (" << duration<double>(steady_clock::now() - start).count()
+                  << " s to prepare), " << rounds << " rounds, " << ThreadPool::shared().size()
+                  << " workers in the shared pool, native reads " << (DirScanner::nativeSupported() ? "on" : "off")
+                  << std::endl;
+
+        for (bool cold : {false, true}) {
+            if (cold && !evictCaches()) {
+                std::cout << "(no cold cache runs: /proc/sys/vm/drop_caches needs root)" << std::endl;
+                break;
+            }
+            std::cout << "\n" << (cold ? "cold" : "warm") << " cache" << std::endl;
+            for (const Walk& walk : walks) {
+                std::vector<double> times;
+                std::size_t found = 0;
+                // The first warm round only fills the caches
+                for (int round = cold ? 0 : -1; round < rounds; ++round) {
+                    if (cold) {
+                        evictCaches();
+                    }
+                    auto walkStart = steady_clock::now();
+                    found = walk.run(root);
+                    if (round >= 0) {
+                        times.push_back(duration<double>(steady_clock::now() - walkStart).count());
+                    }
+                }
+                std::sort(times.begin(), times.end());
+                double median = times[times.size() / 2];
+                std::cout << std::left << std::setw(32) << walk.name << std::right << std::fixed
+                          << std::setprecision(1) << std::setw(10) << median * 1000 << " ms  " << std::setw(8)
+                          << found / median / 1e6 << " M entries/s" << (found == total ? "" : "  (count differs)")
+                          << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "scanbench: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
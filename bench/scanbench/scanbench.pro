@@ -0,0 +1,10 @@
+# Speed of the directory walks on a synthetic tree, warm and cold cache, e.g.
+# "scanbench /mnt/ssd 1000000 5" (directory, entries, rounds).
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../../core/core.pri)
+
+SOURCES += \
+    scanbench.cpp
@@ -0,0 +1,484 @@
+#include <changetracker.h>
+#include <logger.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char* const lockName = "watcher.lock";
+const char* const stateName = "dirty";
+const char* const ackName = "dirty.ack";
+const std::string cookiePrefix = "watch-cookie-";
+const char* const stateMagic = "minigit-dirty 1";
+
+// Changes are written out once the tree has been quiet for this long
+const int flushDelayMilliseconds = 50;
+
+// How long a consumer waits for the watcher to answer its cookie
+const auto cookieTimeout = std::chrono::seconds(2);
+
+/**
+ * @brief Writes a small file through a temporary file, so readers never see half of it.
+ */
+void writeAtomically(const fs::path& file, const std::string& content) {
+    fs::path temporary = file;
+    temporary += ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output << content;
+        output.close();
+        if (!output) {
+            throw std::runtime_error("Error writing file: " + temporary.string());
+        }
+    }
+    fs::rename(temporary, file);
+}
+
+/**
+ * @brief Reads "<epoch> <sequence>" from the acknowledgement file; zeros when there is none.
+ */
+void readAck(const fs::path& file, uint64_t& epoch, uint64_t& sequence) {
+    epoch = 0;
+    sequence = 0;
+    std::ifstream input(file);
+    if (!(input >> epoch >> sequence)) {
+        epoch = 0;
+        sequence = 0;
+    }
+}
+
+#ifdef __linux__
+
+const uint32_t treeMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM
+    | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+std::string childPath(const std::string& directory, const std::string& name) {
+    return directory.empty() ? name : directory + "/" + name;
+}
+
+/**
+ * @brief Whether a name is left out of the dirty set, as every walk of the working tree
+ * leaves it out: the repository, the log written by each operation and the GUI executable
+ * at the root, and the temporary files of revert anywhere.
+ */
+bool isUntracked(const std::string& directory, const std::string& name) {
+    static const std::string revertSuffix = ".revert_tmp";
+    if (directory.empty() && (name == ".git" || name == "log.txt" || name == "main.exe")) {
+        return true;
+    }
+    return name.size() >= revertSuffix.size()
+        && name.compare(name.size() - revertSuffix.size(), revertSuffix.size(), revertSuffix) == 0;
+}
+
+#endif
+
+}
+
+ChangeTracker::ChangeTracker(const fs::path& root) : root_(root), gitDir_(root / ".git") {
+}
+
+ChangeTracker::~ChangeTracker() {
+    stop();
+}
+
+bool ChangeTracker::isSupported() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Starts watching the working tree on a background thread.
+ * @return bool - false if watching is not supported, the repository does not exist or
+ * another process already watches it.
+ */
+bool ChangeTracker::start() {
+#ifdef __linux__
+    std::lock_guard<std::mutex> guard(startMutex_);
+    if (running_) {
+        return true;
+    }
+    if (!fs::is_directory(gitDir_)) {
+        return false;
+    }
+
+    auto release = [this] {
+        for (int* fd : {&inotify_, &wakeRead_, &wakeWrite_, &lock_}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        directories_.clear();
+        dirty_.clear();
+    };
+
+    lock_ = ::open((gitDir_ / lockName).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_ < 0 || ::flock(lock_, LOCK_EX | LOCK_NB) != 0) {
+        Logger::log(LogLevel::Warning, "Not watching: another process already watches " + root_.string());
+        release();
+        return false;
+    }
+    int wake[2];
+    inotify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0 || ::pipe2(wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+        Logger::log("Error starting the watcher: " + std::system_category().message(errno));
+        release();
+        return false;
+    }
+    wakeRead_ = wake[0];
+    wakeWrite_ = wake[1];
+    gitWatch_ = ::inotify_add_watch(inotify_, gitDir_.c_str(), IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+
+    try {
+        restartEpoch();
+        flush();
+    } catch (const std::exception& e) {
+        Logger::log("Error starting the watcher: " + std::string(e.what()));
+        release();
+        return false;
+    }
+
+    running_ = true;
+    watcher_ = std::thread(&ChangeTracker::watcherLoop, this);
+    Logger::log(LogLevel::Info, "Watching " + std::to_string(directories_.size()) + " directories");
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Stops the watcher; .git/dirty stays behind but a later start() begins a new epoch.
+ */
+void ChangeTracker::stop() {
+#ifdef __linux__
+    std::lock_guard<std::mutex> guard(startMutex_);
+    if (!running_) {
+        return;
+    }
+    char wake = 0;
+    [[maybe_unused]] ssize_t written = ::write(wakeWrite_, &wake, 1);
+    watcher_.join();
+    for (int* fd : {&inotify_, &wakeRead_, &wakeWrite_, &lock_}) {
+        ::close(*fd);
+        *fd = -1;
+    }
+    directories_.clear();
+    dirty_.clear();
+    running_ = false;
+#endif
+}
+
+bool ChangeTracker::running() const {
+    return running_;
+}
+
+/**
+ * @brief Counts the changes this process's watcher saw; a cheap "did anything happen" check.
+ */
+uint64_t ChangeTracker::changeCount() const {
+    return changeCount_;
+}
+
+/**
+ * @brief Asks the watcher of the repository, in this process or another one, for the changes.
+ */
+ChangeTracker::Changes ChangeTracker::pendingChanges() const {
+    Changes changes;
+#ifdef __linux__
+    // The watcher holds an exclusive lock: if a shared one can be taken, nobody watches
+    int fd = ::open((gitDir_ / lockName).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return changes;
+    }
+    bool watched = ::flock(fd, LOCK_SH | LOCK_NB) != 0 && errno == EWOULDBLOCK;
+    ::close(fd);
+    if (!watched) {
+        return changes;
+    }
+
+    // Wait until the watcher has seen the cookie, and so every change made before it
+    static std::atomic<uint64_t> cookies{0};
+    fs::path cookie = gitDir_ / (cookiePrefix + std::to_string(::getpid()) + "-" + std::to_string(++cookies));
+    {
+        std::ofstream create(cookie);
+    }
+    auto deadline = std::chrono::steady_clock::now() + cookieTimeout;
+    std::error_code ec;
+    while (fs::exists(cookie, ec)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            fs::remove(cookie, ec);
+            Logger::log(LogLevel::Warning, "The watcher did not answer, rescanning");
+            return changes;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::ifstream input(gitDir_ / stateName);
+    std::string line;
+    if (!std::getline(input, line) || line != stateMagic || !std::getline(input, line)) {
+        return changes;
+    }
+    std::istringstream header(line);
+    if (!(header >> changes.epoch >> changes.sequence)) {
+        return changes;
+    }
+    changes.watched = true;
+
+    uint64_t ackEpoch;
+    uint64_t ackSequence;
+    readAck(gitDir_ / ackName, ackEpoch, ackSequence);
+    if (changes.epoch == 0 || ackEpoch != changes.epoch) {
+        // Changes before this epoch were lost: the caller rescans, then acknowledges it
+        return changes;
+    }
+    while (std::getline(input, line)) {
+        std::size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        if (std::stoull(line.substr(0, tab)) > ackSequence) {
+            changes.paths.push_back(line.substr(tab + 1));
+        }
+    }
+    changes.complete = true;
+#endif
+    return changes;
+}
+
+/**
+ * @brief Records that every change up to the answer was handled; the watcher forgets them.
+ */
+void ChangeTracker::acknowledge(const Changes& changes) const {
+    if (!changes.watched) {
+        return;
+    }
+    writeAtomically(gitDir_ / ackName, std::to_string(changes.epoch) + " " + std::to_string(changes.sequence) + "\n");
+}
+
+#ifdef __linux__
+
+void ChangeTracker::watcherLoop() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    pollfd fds[2] = {{inotify_, POLLIN, 0}, {wakeRead_, POLLIN, 0}};
+    std::vector<std::string> cookies;
+
+    while (true) {
+        int ready = ::poll(fds, 2, unflushed_ ? flushDelayMilliseconds : -1);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0 || fds[1].revents != 0) {
+            break;
+        }
+
+        try {
+            if (ready == 0) {
+                flush();
+                continue;
+            }
+            ssize_t length;
+            while ((length = ::read(inotify_, buffer, sizeof(buffer))) > 0) {
+                for (char* next = buffer; next < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+                    next += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        Logger::log(LogLevel::Warning, "Watcher queue overflow, starting a new epoch");
+                        restartEpoch();
+                        continue;
+                    }
+                    if (event->wd == gitWatch_) {
+                        if (event->len > 0 && std::string(event->name).rfind(cookiePrefix, 0) == 0) {
+                            cookies.push_back(event->name);
+                        }
+                        continue;
+                    }
+                    auto watched = directories_.find(event->wd);
+                    if (watched == directories_.end()) {
+                        continue;
+                    }
+                    if (event->mask & IN_IGNORED) {
+                        directories_.erase(watched);
+                        continue;
+                    }
+                    if (event->len == 0) {
+                        if ((event->mask & IN_MOVE_SELF) && watched->second.empty()) {
+                            Logger::log(LogLevel::Warning, "The working tree was moved, starting a new epoch");
+                            restartEpoch();
+                        }
+                        continue;
+                    }
+
+                    std::string directory = watched->second;
+                    std::string name = event->name;
+                    if (isUntracked(directory, name)) {
+                        continue;
+                    }
+                    std::string path = childPath(directory, name);
+                    markDirty(path);
+                    if (event->mask & IN_ISDIR) {
+                        if (event->mask & IN_MOVED_FROM) {
+                            unwatchTree(path);
+                        } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                            // Files may have been created before the watch was added
+                            watchTree(path);
+                        }
+                    }
+                }
+            }
+            if (!cookies.empty()) {
+                flush();
+                std::error_code ec;
+                for (const std::string& cookie : cookies) {
+                    fs::remove(gitDir_ / cookie, ec);
+                }
+                cookies.clear();
+            }
+        } catch (const std::exception& e) {
+            Logger::log("Watcher error: " + std::string(e.what()));
+        }
+    }
+
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        Logger::log("Watcher error: " + std::string(e.what()));
+    }
+}
+
+/**
+ * @brief Watches a directory and every directory under it.
+ *
+ * Directories that appear after the initial scan had time to get files before their
+ * watch existed, so their contents are marked dirty.
+ */
+void ChangeTracker::watchTree(const std::string& directory) {
+    bool markContents = !directory.empty();
+    std::vector<std::string> pending{directory};
+    while (!pending.empty()) {
+        std::string relative = std::move(pending.back());
+        pending.pop_back();
+        fs::path path = relative.empty() ? root_ : root_ / relative;
+
+        int wd = ::inotify_add_watch(inotify_, path.c_str(), treeMask);
+        if (wd < 0) {
+            if (errno != ENOENT && errno != ENOTDIR) {
+                // Without this watch changes would be missed: never claim to be complete
+                Logger::log(LogLevel::Warning, "Cannot watch " + path.string() + ": "
+                            + std::system_category().message(errno));
+                epoch_ = 0;
+            }
+            continue;
+        }
+        directories_[wd] = relative;
+
+        std::error_code ec;
+        for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            if (isUntracked(relative, name)) {
+                continue;
+            }
+            std::string child = childPath(relative, name);
+            std::error_code typeError;
+            if (it->is_directory(typeError) && !it->is_symlink(typeError)) {
+                pending.push_back(child);
+            }
+            if (markContents) {
+                markDirty(child);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stops watching a directory that moved away, and everything under it.
+ */
+void ChangeTracker::unwatchTree(const std::string& directory) {
+    std::string prefix = directory + "/";
+    for (auto it = directories_.begin(); it != directories_.end();) {
+        if (it->second == directory || it->second.compare(0, prefix.size(), prefix) == 0) {
+            ::inotify_rm_watch(inotify_, it->first);
+            it = directories_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+#else
+
+void ChangeTracker::watcherLoop() {
+}
+
+void ChangeTracker::watchTree(const std::string&) {
+}
+
+void ChangeTracker::unwatchTree(const std::string&) {
+}
+
+#endif
+
+void ChangeTracker::markDirty(const std::string& path) {
+    dirty_[path] = ++sequence_;
+    unflushed_ = true;
+    ++changeCount_;
+}
+
+/**
+ * @brief Forgets everything and watches the tree again: consumers will rescan once.
+ */
+void ChangeTracker::restartEpoch() {
+#ifdef __linux__
+    for (const auto& item : directories_) {
+        ::inotify_rm_watch(inotify_, item.first);
+    }
+#endif
+    directories_.clear();
+    dirty_.clear();
+    epoch_ = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    watchTree("");
+    unflushed_ = true;
+    ++changeCount_;
+}
+
+/**
+ * @brief Drops the acknowledged entries and writes the dirty set to .git/dirty.
+ */
+void ChangeTracker::flush() {
+    uint64_t ackEpoch;
+    uint64_t ackSequence;
+    readAck(gitDir_ / ackName, ackEpoch, ackSequence);
+    if (ackEpoch == epoch_) {
+        for (auto it = dirty_.begin(); it != dirty_.end();) {
+            if (it->second <= ackSequence) {
+                it = dirty_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    std::string content = std::string(stateMagic) + "\n" + std::to_string(epoch_) + " "
+        + std::to_string(sequence_) + "\n";
+    for (const auto& item : dirty_) {
+        content += std::to_string(item.second) + "\t" + item.first + "\n";
+    }
+    writeAtomically(gitDir_ / stateName, content);
+    unflushed_ = false;
+}
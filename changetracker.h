@@ -0,0 +1,88 @@
+#ifndef CHANGETRACKER_H
+#define CHANGETRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief inotify-maintained set of the working tree paths changed since they were last added.
+ *
+ * One process runs the watcher (start(): "minigit watch", or the GUI in watch mode). It
+ * holds .git/watcher.lock, watches every directory of the working tree (not .git; like the
+ * walks of the core it leaves log.txt, main.exe and revert temporaries out) and
+ * keeps a numbered dirty set in .git/dirty. Any process can then ask for the changes with
+ * pendingChanges() and, once it has staged them, acknowledge() them; the watcher drops
+ * acknowledged entries.
+ *
+ * Before reading .git/dirty a consumer creates a cookie file in .git and waits for the
+ * watcher to delete it: inotify delivers events in order, so every change made before
+ * the question is in the answer. A watcher (re)start or a kernel queue overflow starts
+ * a new epoch; a consumer whose acknowledgement is from another epoch gets an incomplete
+ * answer and must rescan the tree once. Without a watcher every answer is incomplete.
+ */
+class ChangeTracker
+{
+public:
+    struct Changes
+    {
+        bool watched = false;   // A watcher answered: the epoch and sequence can be acknowledged
+        bool complete = false;  // paths holds every change since the last acknowledge()
+        uint64_t epoch = 0;
+        uint64_t sequence = 0;
+        std::vector<std::string> paths;  // Relative to the working tree, changed, created or deleted
+    };
+
+    explicit ChangeTracker(const fs::path& root = ".");
+    ~ChangeTracker();
+
+    ChangeTracker(const ChangeTracker&) = delete;
+    ChangeTracker& operator=(const ChangeTracker&) = delete;
+
+    static bool isSupported();
+
+    bool start();
+    void stop();
+    bool running() const;
+    uint64_t changeCount() const;
+
+    Changes pendingChanges() const;
+    void acknowledge(const Changes& changes) const;
+
+private:
+    void watcherLoop();
+    void watchTree(const std::string& directory);
+    void unwatchTree(const std::string& directory);
+    void markDirty(const std::string& path);
+    void restartEpoch();
+    void flush();
+
+    fs::path root_;
+    fs::path gitDir_;
+
+    // Watcher state, only touched by the watcher thread once it runs
+    int inotify_ = -1;
+    int lock_ = -1;
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+    int gitWatch_ = -1;
+    std::unordered_map<int, std::string> directories_;  // Watch descriptor -> relative path
+    std::unordered_map<std::string, uint64_t> dirty_;   // Path -> sequence of its last change
+    uint64_t epoch_ = 0;
+    uint64_t sequence_ = 0;
+    bool unflushed_ = false;
+
+    std::thread watcher_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> changeCount_{0};
+    std::mutex startMutex_;
+};
+
+#endif // CHANGETRACKER_H
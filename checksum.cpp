@@ -0,0 +1,120 @@
+#include <checksum.h>
+
+#include <widehash.h>
+
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Formats the digest as lowercase hex.
+ * @return std::string - Two characters per byte.
+ */
+std::string Digest::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string result(size * 2, '0');
+    for (std::size_t i = 0; i < size; ++i) {
+        result[2 * i] = digits[bytes[i] >> 4];
+        result[2 * i + 1] = digits[bytes[i] & 0xf];
+    }
+    return result;
+}
+
+/**
+ * @brief Compares two digests.
+ * @param other The digest to compare with.
+ * @return bool - true if both have the same size and bytes.
+ */
+bool Digest::operator==(const Digest& other) const {
+    return size == other.size && std::memcmp(bytes, other.bytes, size) == 0;
+}
+
+/**
+ * @brief Creates a hasher for an algorithm.
+ * @param algorithm The algorithm, as stored on disk.
+ * @return std::unique_ptr<Hasher> - A fresh hasher.
+ */
+std::unique_ptr<Hasher> Hasher::create(HashAlgorithm algorithm) {
+    switch (algorithm) {
+    case HashAlgorithm::Fnv1a32:
+        return std::make_unique<Fnv1a32Hasher>();
+    case HashAlgorithm::Fnv1a64:
+        return std::make_unique<Fnv1a64Hasher>();
+    case HashAlgorithm::Wide128:
+        return std::make_unique<WideHasher>();
+    }
+    throw std::runtime_error("Unknown hash algorithm: " + std::to_string(static_cast<int>(algorithm)));
+}
+
+/**
+ * @brief Adds a chunk of data to the checksum.
+ * @param data Pointer to the bytes.
+ * @param size Number of bytes.
+ */
+void Fnv1a32Hasher::update(const char* data, std::size_t size) {
+    const uint32_t prime = 16777619;
+    uint32_t hash = hash_;
+
+    for (std::size_t i = 0; i < size; ++i) {
+        // Sign extension of the char is kept to stay compatible with existing trailers
+        hash ^= static_cast<uint32_t>(data[i]);
+        hash *= prime;
+    }
+
+    hash_ = hash;
+}
+
+/**
+ * @brief Returns the checksum as its 4 little-endian bytes, as written in the trailer, and resets the hasher.
+ * @return Digest - The checksum.
+ */
+Digest Fnv1a32Hasher::finish() {
+    Digest digest;
+    digest.size = sizeof(hash_);
+    for (std::size_t i = 0; i < digest.size; ++i) {
+        digest.bytes[i] = static_cast<uint8_t>(hash_ >> (8 * i));
+    }
+    hash_ = 2166136261U;
+    return digest;
+}
+
+/**
+ * @brief Adds a chunk of data to the hash.
+ * @param data Pointer to the bytes.
+ * @param size Number of bytes.
+ */
+void Fnv1a64Hasher::update(const char* data, std::size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = hash_;
+
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= prime;
+    }
+
+    hash_ = hash;
+}
+
+/**
+ * @brief Returns the hash as 8 big-endian bytes and resets the hasher.
+ * @return Digest - The hash.
+ */
+Digest Fnv1a64Hasher::finish() {
+    Digest digest;
+    digest.size = sizeof(hash_);
+    for (std::size_t i = 0; i < digest.size; ++i) {
+        digest.bytes[i] = static_cast<uint8_t>(hash_ >> (8 * (digest.size - 1 - i)));
+    }
+    hash_ = 14695981039346656037ULL;
+    return digest;
+}
+
+/**
+ * @brief Computes a checksum for a given string using the FNV-1a hash algorithm.
+ * @param str The string for which the checksum is calculated.
+ * @return uint32_t - The computed checksum.
+ */
+uint32_t computeChecksum(const std::string& str) {
+    Fnv1a32Hasher checksum;
+    checksum.update(str);
+    return checksum.value();
+}
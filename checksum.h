@@ -0,0 +1,86 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Hash algorithms known to the repository. The values are stored on disk.
+ */
+enum class HashAlgorithm : uint8_t {
+    Fnv1a32 = 1,  // Legacy 4-byte trailer of "1234"-prefixed files
+    Fnv1a64 = 2,  // Object ids of the first object store layout
+    Wide128 = 3   // Current object ids and trailers
+};
+
+/**
+ * @brief Result of a hash computation (up to 128 bits).
+ */
+struct Digest
+{
+    uint8_t bytes[16] = {};
+    std::size_t size = 0;
+
+    std::string hex() const;
+    bool operator==(const Digest& other) const;
+    bool operator!=(const Digest& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Incremental hash interface.
+ *
+ * Feeding the data in several update() calls gives the same result as hashing it at once,
+ * so files can be hashed chunk by chunk without holding them in memory. finish() returns
+ * the digest and starts the hasher over.
+ */
+class Hasher
+{
+public:
+    virtual ~Hasher() = default;
+
+    virtual HashAlgorithm algorithm() const = 0;
+    virtual void update(const char* data, std::size_t size) = 0;
+    virtual Digest finish() = 0;
+
+    void update(const std::string& data) { update(data.data(), data.size()); }
+
+    static std::unique_ptr<Hasher> create(HashAlgorithm algorithm);
+};
+
+/**
+ * @brief FNV-1a 32-bit, stored as the 4-byte trailer of legacy stored files.
+ */
+class Fnv1a32Hasher : public Hasher
+{
+public:
+    HashAlgorithm algorithm() const override { return HashAlgorithm::Fnv1a32; }
+    void update(const char* data, std::size_t size) override;
+    Digest finish() override;
+    using Hasher::update;
+
+    uint32_t value() const { return hash_; }
+
+private:
+    uint32_t hash_ = 2166136261U;
+};
+
+/**
+ * @brief FNV-1a 64-bit, the object id of the first object store layout.
+ */
+class Fnv1a64Hasher : public Hasher
+{
+public:
+    HashAlgorithm algorithm() const override { return HashAlgorithm::Fnv1a64; }
+    void update(const char* data, std::size_t size) override;
+    Digest finish() override;
+    using Hasher::update;
+
+private:
+    uint64_t hash_ = 14695981039346656037ULL;
+};
+
+uint32_t computeChecksum(const std::string& str);
+
+#endif // CHECKSUM_H
@@ -0,0 +1,90 @@
+#include <chunker.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+struct GearTable
+{
+    uint64_t plain[256];
+    uint64_t shifted[256];  // plain << 1, for the two bytes per step loop
+};
+
+// The table is part of the storage format: other values would cut files elsewhere and
+// stop new chunks from matching the stored ones
+constexpr GearTable makeGearTable() {
+    GearTable table{};
+    uint64_t state = 0x6d696e6967697431ULL;
+    for (int i = 0; i < 256; ++i) {
+        // splitmix64
+        state += 0x9e3779b97f4a7c15ULL;
+        uint64_t value = state;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        table.plain[i] = value ^ (value >> 31);
+        table.shifted[i] = table.plain[i] << 1;
+    }
+    return table;
+}
+
+constexpr GearTable gear = makeGearTable();
+
+// Bit k of the gear hash depends on the last k + 1 bytes only, so the masks take the high
+// bits (below bit 63, which the shifted masks need) to look at a 46 to 63 byte window
+constexpr uint64_t highBits(unsigned count) {
+    return ((uint64_t(1) << count) - 1) << (63 - count);
+}
+
+// normalSize is 2^16: two bits more before it, two bits less after it
+constexpr uint64_t strictMask = highBits(18);
+constexpr uint64_t looseMask = highBits(14);
+
+/**
+ * Rolls the hash over [position, end) two bytes per step and returns the length of the
+ * chunk ending at the first boundary, or 0. The first byte of a step adds the shifted gear
+ * value to the hash shifted by two and is tested with the shifted mask, which gives the
+ * same boundaries as one byte per step with one shift less on the dependency chain.
+ */
+inline std::size_t scan(const unsigned char* bytes, std::size_t& position, std::size_t end,
+                        uint64_t& hash, uint64_t mask) {
+    const uint64_t shiftedMask = mask << 1;
+    std::size_t i = position;
+    for (; i + 1 < end; i += 2) {
+        hash = (hash << 2) + gear.shifted[bytes[i]];
+        if ((hash & shiftedMask) == 0) {
+            return i + 1;
+        }
+        hash += gear.plain[bytes[i + 1]];
+        if ((hash & mask) == 0) {
+            return i + 2;
+        }
+    }
+    position = i;
+    return 0;
+}
+
+}
+
+/**
+ * @brief Finds the end of the chunk starting at data.
+ * @param data The content from the start of the chunk.
+ * @param size The bytes available; must be at least maxSize unless the content ends there.
+ * @return std::size_t - The length of the chunk, at most maxSize and at most size.
+ */
+std::size_t Chunker::cut(const char* data, std::size_t size) {
+    if (size <= minSize) {
+        return size;
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    const std::size_t normalEnd = std::min(size, normalSize);
+    const std::size_t end = std::min(size, maxSize);
+
+    uint64_t hash = 0;
+    std::size_t position = minSize;
+    std::size_t length = scan(bytes, position, normalEnd, hash, strictMask);
+    if (length == 0) {
+        length = scan(bytes, position, end, hash, looseMask);
+    }
+    return length == 0 ? end : length;
+}
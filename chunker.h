@@ -0,0 +1,26 @@
+#ifndef CHUNKER_H
+#define CHUNKER_H
+
+#include <cstddef>
+
+/**
+ * @brief Content-defined chunking (FastCDC).
+ *
+ * A gear hash (hash = (hash << 1) + gear[byte]) is rolled over the content and a chunk
+ * ends where its high bits are zero, so boundaries depend on the bytes around them and not
+ * on their offset: an insertion in a large file only changes the chunks it touches and the
+ * following ones line up again after the next boundary. No boundary is looked for in the
+ * first minSize bytes; up to normalSize a stricter mask is used and after it a looser one,
+ * which keeps most chunks close to normalSize, and a chunk never exceeds maxSize.
+ */
+namespace Chunker {
+
+const std::size_t minSize = 16 << 10;
+const std::size_t normalSize = 64 << 10;
+const std::size_t maxSize = 256 << 10;
+
+std::size_t cut(const char* data, std::size_t size);
+
+}
+
+#endif // CHUNKER_H
@@ -0,0 +1,14 @@
+# minigit: the repository operations from the command line, for scripts and build pipelines.
+TEMPLATE = app
+TARGET = minigit
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../core/link.pri)
+
+SOURCES += \
+    minigit.cpp
+
+# Default rules for deployment.
+unix:!android: target.path = /usr/local/bin
+!isEmpty(target.path): INSTALLS += target
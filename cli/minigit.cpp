@@ -0,0 +1,291 @@
+#include <miniversioncontrol.h>
+#include <stats.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <pthread.h>
+#endif
+
+namespace {
+
+const char* const usage =
+    "usage: minigit [options] <command> [arguments]\n"
+    "\n"
+    "commands:\n"
+    "  init                          create the repository in the current directory\n"
+    "  add [-f MANIFEST] [-m MSG] [PATH...]\n"
+    "                                stage the paths (and those listed in MANIFEST, one per\n"
+    "                                line, '-' for stdin) as one batch, then commit with MSG\n"
+    "  add --changed [-m MSG]        stage what changed in the paths added before\n"
+    "  commit MESSAGE                commit the staging area\n"
+    "  revert VERSION                restore the working tree to a version\n"
+    "  diff [-U N] [OLD [NEW]]       show the changes from version OLD (default: the newest)\n"
+    "                                to version NEW (default: the working tree)\n"
+    "  versions                      list the versions\n"
+    "  files VERSION                 list the files of a version\n"
+    "  staged                        list the staging area\n"
+    "  status [--all]                list the untracked, modified, staged and deleted files\n"
+    "                                (and with --all the unchanged ones)\n"
+    "  unstage NAME                  remove a file or directory from the staging area\n"
+    "  pack                          move the loose objects into a pack file\n"
+    "  report                        print the object store statistics\n"
+    "  watch                         watch the working tree until interrupted, so that\n"
+    "                                changed and add --changed only look at what changed\n"
+    "  changed                       list the working tree paths changed since the last\n"
+    "                                add --changed\n"
+    "\n"
+    "options:\n"
+    "  -C DIRECTORY                  run in DIRECTORY instead of the current directory\n"
+    "  --compression none|fast|high  compression of the objects added\n"
+    "  --delta-depth N               longest delta chain, 0 stores every version in full\n"
+    "  --chunk-threshold BYTES       split files from this size on into deduplicated chunks,\n"
+    "                                0 stores every file whole\n"
+    "  --copy-mode MODE              auto, reflink, copy_file_range, sendfile or buffered\n"
+    "  --io-engine ENGINE            auto, io_uring or threads: how small files are read and\n"
+    "                                written in batches\n"
+    "  --stats                       print the cost of each operation and write .git/stats.json\n";
+
+/**
+ * @brief Reads a manifest: one path per line, blank lines and lines starting with '#' are skipped.
+ */
+void readManifest(const std::string& file, std::vector<std::string>& paths) {
+    std::ifstream input;
+    if (file != "-") {
+        input.open(file);
+        if (!input.is_open()) {
+            throw std::runtime_error("Error opening manifest: " + file);
+        }
+    }
+    std::istream& lines = file == "-" ? std::cin : input;
+
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            paths.push_back(line);
+        }
+    }
+}
+
+std::string requireArgument(const std::vector<std::string>& arguments, std::size_t& i) {
+    if (i + 1 >= arguments.size()) {
+        throw std::invalid_argument(arguments[i] + " needs an argument");
+    }
+    return arguments[++i];
+}
+
+/**
+ * @brief Runs the watcher until SIGINT or SIGTERM.
+ */
+void watch(MiniVersionControl& vcs) {
+#ifndef _WIN32
+    // Blocked before the watcher thread starts, so that it inherits the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    if (!vcs.startWatching()) {
+        throw std::runtime_error(ChangeTracker::isSupported() ? "cannot watch, see log.txt (already watched?)"
+                                                              : "watching is not supported on this platform");
+    }
+    std::cerr << "minigit: watching, interrupt to stop" << std::endl;
+    int received;
+    sigwait(&signals, &received);
+    vcs.stopWatching();
+#else
+    (void)vcs;
+    throw std::runtime_error("watching is not supported on this platform");
+#endif
+}
+
+int run(const std::vector<std::string>& arguments) {
+    MiniVersionControl vcs;
+    std::size_t i = 0;
+    for (; i < arguments.size() && arguments[i].size() > 1 && arguments[i][0] == '-'; ++i) {
+        const std::string& option = arguments[i];
+        if (option == "-C") {
+            fs::current_path(requireArgument(arguments, i));
+        } else if (option == "--compression") {
+            Compression level;
+            if (!LzCodec::parseLevel(requireArgument(arguments, i), level)) {
+                throw std::invalid_argument("unknown compression level: " + arguments[i]);
+            }
+            vcs.setCompression(level);
+        } else if (option == "--delta-depth") {
+            vcs.setDeltaDepth(static_cast<unsigned>(std::stoul(requireArgument(arguments, i))));
+        } else if (option == "--chunk-threshold") {
+            vcs.setChunkThreshold(std::stoull(requireArgument(arguments, i)));
+        } else if (option == "--copy-mode") {
+            CopyMode mode;
+            if (!FastCopy::parseMode(requireArgument(arguments, i), mode)) {
+                throw std::invalid_argument("unknown copy mode: " + arguments[i]);
+            }
+            vcs.setCopyMode(mode);
+        } else if (option == "--io-engine") {
+            IoEngine engine;
+            if (!BatchIo::parseEngine(requireArgument(arguments, i), engine)) {
+                throw std::invalid_argument("unknown I/O engine: " + arguments[i]);
+            }
+            vcs.setIoEngine(engine);
+        } else if (option == "--stats") {
+            // Handled by main()
+        } else {
+            throw std::invalid_argument("unknown option: " + option);
+        }
+    }
+    if (i == arguments.size()) {
+        throw std::invalid_argument("no command");
+    }
+
+    const std::string command = arguments[i++];
+    std::vector<std::string> operands(arguments.begin() + static_cast<std::ptrdiff_t>(i), arguments.end());
+
+    if (command == "init") {
+        vcs.init();
+    } else if (command == "add") {
+        std::vector<std::string> paths;
+        std::string message;
+        bool commit = false;
+        bool changed = false;
+        for (std::size_t j = 0; j < operands.size(); ++j) {
+            if (operands[j] == "--changed") {
+                changed = true;
+            } else if (operands[j] == "-f" || operands[j] == "--manifest") {
+                readManifest(requireArgument(operands, j), paths);
+            } else if (operands[j] == "-m" || operands[j] == "--message") {
+                message = requireArgument(operands, j);
+                commit = true;
+            } else {
+                paths.push_back(operands[j]);
+            }
+        }
+        if (changed != paths.empty()) {
+            throw std::invalid_argument(changed ? "--changed takes no paths" : "nothing to add");
+        }
+        // The core only logs a path it cannot find; a pipeline should stop on it
+        for (const std::string& path : paths) {
+            if (!fs::exists(path)) {
+                throw std::runtime_error("No such file or directory: " + path);
+            }
+        }
+        if (changed) {
+            vcs.addChanged();
+        } else {
+            vcs.add(paths);
+        }
+        if (commit) {
+            vcs.commit(message);
+        }
+    } else if (command == "commit" && operands.size() == 1) {
+        vcs.commit(operands[0]);
+    } else if (command == "revert" && operands.size() == 1) {
+        vcs.revert(".git/commits/" + operands[0]);
+    } else if (command == "diff") {
+        unsigned context = 3;
+        std::vector<std::string> versions;
+        for (std::size_t j = 0; j < operands.size(); ++j) {
+            if (operands[j] == "-U") {
+                context = static_cast<unsigned>(std::stoul(requireArgument(operands, j)));
+            } else {
+                versions.push_back(operands[j]);
+            }
+        }
+        if (versions.size() > 2) {
+            throw std::invalid_argument("diff takes at most two versions");
+        }
+        if (versions.empty()) {
+            std::vector<std::string> all = vcs.listVersions();
+            auto newest = std::max_element(all.begin(), all.end(), MiniVersionControl::olderVersion);
+            if (newest == all.end()) {
+                throw std::runtime_error("no version to compare with");
+            }
+            versions.push_back(*newest);
+        }
+        vcs.diff(".git/commits/" + versions[0], versions.size() > 1 ? ".git/commits/" + versions[1] : std::string(),
+                 std::cout, context);
+    } else if (command == "versions" && operands.empty()) {
+        std::vector<std::string> versions = vcs.listVersions();
+        std::sort(versions.begin(), versions.end(), MiniVersionControl::olderVersion);
+        for (const std::string& version : versions) {
+            std::cout << version << "\n";
+        }
+    } else if (command == "files" && operands.size() == 1) {
+        for (const std::string& path : vcs.listVersionFiles(".git/commits/" + operands[0])) {
+            std::cout << path << "\n";
+        }
+    } else if (command == "staged" && operands.empty()) {
+        for (const std::string& name : vcs.listStagingArea()) {
+            std::cout << name << "\n";
+        }
+    } else if (command == "status" && (operands.empty() || (operands.size() == 1 && operands[0] == "--all"))) {
+        bool all = !operands.empty();
+        for (const FileStatus& status : vcs.status()) {
+            if (all || status.state != FileState::Unchanged) {
+                std::cout << std::left << std::setw(10) << FileStatus::stateName(status.state) << status.path << "\n";
+            }
+        }
+    } else if (command == "unstage" && operands.size() == 1) {
+        vcs.deleteFromStaging(operands[0]);
+    } else if (command == "pack" && operands.empty()) {
+        std::cout << vcs.pack() << " objects packed\n";
+    } else if (command == "report" && operands.empty()) {
+        std::cout << vcs.storageReport().summary() << "\n";
+    } else if (command == "watch" && operands.empty()) {
+        watch(vcs);
+    } else if (command == "changed" && operands.empty()) {
+        ChangeTracker::Changes changes = vcs.pendingChanges();
+        if (!changes.complete) {
+            throw std::runtime_error(changes.watched ? "the watcher lost changes, run add --changed once"
+                                                     : "no watcher is running (minigit watch)");
+        }
+        std::sort(changes.paths.begin(), changes.paths.end());
+        for (const std::string& path : changes.paths) {
+            std::cout << path << "\n";
+        }
+    } else {
+        throw std::invalid_argument("unknown command or wrong arguments: " + command);
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    bool printStats = std::find(arguments.begin(), arguments.end(), "--stats") != arguments.end();
+
+    int result;
+    try {
+        result = run(arguments);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "minigit: " << e.what() << "\n\n" << usage;
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "minigit: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (printStats) {
+        std::vector<Stats::OperationReport> reports = Stats::reports();
+        std::cout << Stats::formatText(reports);
+        try {
+            if (fs::is_directory(".git")) {
+                Stats::writeJson(".git/stats.json", reports);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "minigit: " << e.what() << std::endl;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,50 @@
+# Sources of the version control core, shared by the static library and the benchmarks.
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    $$PWD/../batchio.cpp \
+    $$PWD/../changetracker.cpp \
+    $$PWD/../checksum.cpp \
+    $$PWD/../chunker.cpp \
+    $$PWD/../delta.cpp \
+    $$PWD/../dirscanner.cpp \
+    $$PWD/../fastcopy.cpp \
+    $$PWD/../ignorerules.cpp \
+    $$PWD/../linediff.cpp \
+    $$PWD/../logger.cpp \
+    $$PWD/../lzcodec.cpp \
+    $$PWD/../merkletree.cpp \
+    $$PWD/../miniversioncontrol.cpp \
+    $$PWD/../objectstore.cpp \
+    $$PWD/../packfile.cpp \
+    $$PWD/../pathtable.cpp \
+    $$PWD/../progress.cpp \
+    $$PWD/../statindex.cpp \
+    $$PWD/../stats.cpp \
+    $$PWD/../threadpool.cpp \
+    $$PWD/../widehash.cpp
+
+HEADERS += \
+    $$PWD/../batchio.h \
+    $$PWD/../changetracker.h \
+    $$PWD/../checksum.h \
+    $$PWD/../chunker.h \
+    $$PWD/../delta.h \
+    $$PWD/../dirscanner.h \
+    $$PWD/../fastcopy.h \
+    $$PWD/../ignorerules.h \
+    $$PWD/../linediff.h \
+    $$PWD/../logger.h \
+    $$PWD/../lzcodec.h \
+    $$PWD/../merkletree.h \
+    $$PWD/../miniversioncontrol.h \
+    $$PWD/../objectstore.h \
+    $$PWD/../packfile.h \
+    $$PWD/../pathtable.h \
+    $$PWD/../progress.h \
+    $$PWD/../statindex.h \
+    $$PWD/../stats.h \
+    $$PWD/../threadpool.h \
+    $$PWD/../widehash.h
+
+unix: LIBS += -pthread
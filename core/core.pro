@@ -0,0 +1,7 @@
+# Headless version control core (no Qt), linked by the GUI and the minigit CLI.
+TEMPLATE = lib
+TARGET = minigitcore
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+include(core.pri)
@@ -0,0 +1,13 @@
+# Links the core static library built by core.pro next to the including project.
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD/..
+
+win32:CONFIG(release, debug|release): CORE_LIB_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): CORE_LIB_DIR = $$OUT_PWD/../core/debug
+else: CORE_LIB_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$CORE_LIB_DIR -lminigitcore
+win32-msvc*: PRE_TARGETDEPS += $$CORE_LIB_DIR/minigitcore.lib
+else: PRE_TARGETDEPS += $$CORE_LIB_DIR/libminigitcore.a
+
+unix: LIBS += -pthread
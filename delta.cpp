@@ -0,0 +1,175 @@
+#include <delta.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+const std::size_t blockSize = 16;
+const uint64_t hashBase = 0x100000001b3ULL;
+
+void putVarint(std::vector<char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (p == end) {
+            return false;
+        }
+        unsigned char byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t blockHash(const unsigned char* p) {
+    uint64_t hash = 0;
+    for (std::size_t i = 0; i < blockSize; ++i) {
+        hash = hash * hashBase + p[i];
+    }
+    return hash;
+}
+
+void emitInsert(std::vector<char>& delta, const unsigned char* bytes, std::size_t length) {
+    if (length > 0) {
+        putVarint(delta, static_cast<uint64_t>(length) << 1);
+        delta.insert(delta.end(), bytes, bytes + length);
+    }
+}
+
+void emitCopy(std::vector<char>& delta, std::size_t offset, std::size_t length) {
+    putVarint(delta, static_cast<uint64_t>(length) << 1 | 1);
+    putVarint(delta, offset);
+}
+
+}
+
+namespace Delta {
+
+/**
+ * @brief Encodes a target content as a delta against a base content.
+ * @param base The base content.
+ * @param baseSize Size of the base.
+ * @param target The content to encode.
+ * @param targetSize Size of the target.
+ * @param delta Receives the delta.
+ */
+void encode(const char* base, std::size_t baseSize, const char* target, std::size_t targetSize,
+            std::vector<char>& delta) {
+    const unsigned char* source = reinterpret_cast<const unsigned char*>(base);
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(target);
+    delta.clear();
+    putVarint(delta, baseSize);
+    putVarint(delta, targetSize);
+
+    std::size_t anchor = 0;
+    if (baseSize >= blockSize && targetSize >= blockSize) {
+        // Open-addressed table of block positions + 1 (0 is empty); the last block of a bucket wins
+        unsigned bits = 10;
+        while ((std::size_t(1) << bits) < 2 * (baseSize / blockSize)) {
+            ++bits;
+        }
+        std::vector<uint32_t> table(std::size_t(1) << bits, 0);
+        auto slot = [bits](uint64_t hash) {
+            return static_cast<std::size_t>((hash * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+        };
+        for (std::size_t position = 0; position + blockSize <= baseSize; position += blockSize) {
+            table[slot(blockHash(source + position))] = static_cast<uint32_t>(position + 1);
+        }
+
+        uint64_t outFactor = 1;
+        for (std::size_t i = 1; i < blockSize; ++i) {
+            outFactor *= hashBase;
+        }
+
+        std::size_t position = 0;
+        uint64_t hash = blockHash(in);
+        while (position + blockSize <= targetSize) {
+            uint32_t candidate = table[slot(hash)];
+            if (candidate != 0 && std::memcmp(source + candidate - 1, in + position, blockSize) == 0) {
+                std::size_t start = position;
+                std::size_t from = candidate - 1;
+                while (start > anchor && from > 0 && source[from - 1] == in[start - 1]) {
+                    --start;
+                    --from;
+                }
+                std::size_t end = position + blockSize;
+                std::size_t fromEnd = from + (end - start);
+                while (end < targetSize && fromEnd < baseSize && source[fromEnd] == in[end]) {
+                    ++end;
+                    ++fromEnd;
+                }
+                emitInsert(delta, in + anchor, start - anchor);
+                emitCopy(delta, from, end - start);
+                anchor = end;
+                position = end;
+                if (position + blockSize <= targetSize) {
+                    hash = blockHash(in + position);
+                }
+                continue;
+            }
+            if (position + blockSize < targetSize) {
+                hash = (hash - in[position] * outFactor) * hashBase + in[position + blockSize];
+            }
+            ++position;
+        }
+    }
+    emitInsert(delta, in + anchor, targetSize - anchor);
+}
+
+/**
+ * @brief Rebuilds a content from its base and its delta, checking every instruction.
+ * @param base The base content.
+ * @param baseSize Size of the base.
+ * @param delta The delta.
+ * @param deltaSize Size of the delta.
+ * @param target Receives the content (reserve it beforehand when the size is known).
+ * @return bool - false if the delta is corrupted or was made against another base.
+ */
+bool apply(const char* base, std::size_t baseSize, const char* delta, std::size_t deltaSize,
+           std::vector<char>& target) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(delta);
+    const unsigned char* end = p + deltaSize;
+    uint64_t expectedBase;
+    uint64_t targetSize;
+    if (!readVarint(p, end, expectedBase) || !readVarint(p, end, targetSize) || expectedBase != baseSize) {
+        return false;
+    }
+    target.clear();
+
+    while (p < end) {
+        uint64_t instruction;
+        if (!readVarint(p, end, instruction)) {
+            return false;
+        }
+        uint64_t length = instruction >> 1;
+        if (length > targetSize - target.size()) {
+            return false;
+        }
+        if (instruction & 1) {
+            uint64_t offset;
+            if (!readVarint(p, end, offset) || offset > baseSize || length > baseSize - offset) {
+                return false;
+            }
+            target.insert(target.end(), base + offset, base + offset + length);
+        } else {
+            if (length > static_cast<uint64_t>(end - p)) {
+                return false;
+            }
+            target.insert(target.end(), p, p + length);
+            p += length;
+        }
+    }
+    return target.size() == targetSize;
+}
+
+}
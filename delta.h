@@ -0,0 +1,26 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Copy/insert delta encoding of a content against a base content.
+ *
+ * A delta starts with the base size and the target size, then a list of instructions.
+ * Every instruction starts with a varint holding its length shifted left by one, the low
+ * bit telling a copy (1, followed by a varint offset in the base) from an insert (0,
+ * followed by the inserted bytes). Copies are found by indexing the base by 16-byte
+ * blocks and scanning the target with a rolling hash, so any common run of at least
+ * 31 bytes is copied.
+ */
+namespace Delta {
+
+void encode(const char* base, std::size_t baseSize, const char* target, std::size_t targetSize,
+            std::vector<char>& delta);
+bool apply(const char* base, std::size_t baseSize, const char* delta, std::size_t deltaSize,
+           std::vector<char>& target);
+
+}
+
+#endif // DELTA_H
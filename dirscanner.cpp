@@ -0,0 +1,305 @@
+#include <dirscanner.h>
+
+#include <atomic>
+#include <cerrno>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using DirScanner::Kind;
+
+#if defined(__linux__) && defined(SYS_getdents64)
+
+// Room for a few thousand entries per getdents64 call
+const std::size_t bufferSize = 256 << 10;
+
+/**
+ * @brief Closes a file descriptor when leaving its scope.
+ */
+class Descriptor
+{
+public:
+    explicit Descriptor(int fd) : fd_(fd) {}
+    ~Descriptor() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+    Descriptor(const Descriptor&) = delete;
+    Descriptor& operator=(const Descriptor&) = delete;
+
+    int get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+Kind kindOf(mode_t mode) {
+    return S_ISREG(mode) ? Kind::File : S_ISDIR(mode) ? Kind::Directory : Kind::Other;
+}
+
+/**
+ * Classifies a symbolic link by its target, or an entry the file system gave no type for.
+ */
+Kind resolveKind(int directory, const char* name, unsigned char type, bool& link) {
+    struct ::stat info;
+    if (type == DT_UNKNOWN) {
+        if (::fstatat(directory, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+            return Kind::Other;
+        }
+        if (!S_ISLNK(info.st_mode)) {
+            return kindOf(info.st_mode);
+        }
+    }
+    link = true;
+    if (::fstatat(directory, name, &info, 0) != 0) {
+        return Kind::Other;
+    }
+    return kindOf(info.st_mode);
+}
+
+/**
+ * Calls visit(name, kind, link) for every entry of a directory but "." and "..".
+ */
+template <typename Visit>
+void readDirectory(const std::string& path, Visit&& visit) {
+    Descriptor directory(::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (directory.get() < 0) {
+        throw fs::filesystem_error("Cannot open directory", fs::path(path), std::error_code(errno, std::generic_category()));
+    }
+    thread_local std::vector<char> buffer(bufferSize);
+    for (;;) {
+        long count = ::syscall(SYS_getdents64, directory.get(), buffer.data(), buffer.size());
+        if (count < 0) {
+            throw fs::filesystem_error("Cannot read directory", fs::path(path), std::error_code(errno, std::generic_category()));
+        }
+        if (count == 0) {
+            return;
+        }
+        for (long offset = 0; offset < count;) {
+            const auto* entry = reinterpret_cast<const struct dirent64*>(buffer.data() + offset);
+            offset += entry->d_reclen;
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            bool link = false;
+            Kind kind;
+            switch (entry->d_type) {
+            case DT_REG:
+                kind = Kind::File;
+                break;
+            case DT_DIR:
+                kind = Kind::Directory;
+                break;
+            case DT_LNK:
+            case DT_UNKNOWN:
+                kind = resolveKind(directory.get(), name, entry->d_type, link);
+                break;
+            default:
+                kind = Kind::Other;
+                break;
+            }
+            visit(std::string_view(name), kind, link);
+        }
+    }
+}
+
+#else
+
+template <typename Visit>
+void readDirectory(const std::string& path, Visit&& visit) {
+    for (const auto& entry : fs::directory_iterator(path)) {
+        std::error_code ec;
+        bool link = entry.is_symlink(ec);
+        Kind kind = entry.is_regular_file(ec) ? Kind::File : entry.is_directory(ec) ? Kind::Directory : Kind::Other;
+        std::string name = entry.path().filename().string();
+        visit(std::string_view(name), kind, link);
+    }
+}
+
+#endif
+
+/**
+ * @brief The files and directories of one directory, read by a scan() worker.
+ */
+struct Listing
+{
+    struct Item
+    {
+        uint32_t nameEnd = 0;      // The name starts where the previous one ends
+        bool directory = false;
+        bool link = false;
+        IgnoreRules::State state = IgnoreRules::none;  // Where the ignore rules are in it
+        Listing* child = nullptr;  // Subdirectories that are walked
+    };
+
+    std::string names;
+    std::vector<Item> items;
+};
+
+/**
+ * @brief Reads a tree one directory per task, subdirectories fanned out to the pool.
+ *
+ * Only a few tasks per worker are kept queued: past that a worker reads the subdirectories
+ * it finds itself, depth first, which keeps every worker busy without queuing a closure
+ * and a path for each directory of a wide tree.
+ */
+class ParallelScan
+{
+public:
+    ParallelScan(const std::function<void()>& onDirectory, const IgnoreRules* rules, ThreadPool& pool)
+        : onDirectory_(onDirectory), rules_(rules), maxQueued_(pool.size() * 4), group_(pool) {}
+
+    Listing& allocate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return listings_.emplace_back();
+    }
+
+    void read(const std::string& path, Listing& listing, IgnoreRules::State state) {
+        if (onDirectory_) {
+            onDirectory_();
+        }
+        readDirectory(path, [this, &listing, state](std::string_view name, Kind kind, bool link) {
+            if (kind == Kind::Other) {
+                return;
+            }
+            Listing::Item item;
+            item.directory = kind == Kind::Directory;
+            item.link = link;
+            if (state != IgnoreRules::none) {
+                bool ignored;
+                item.state = rules_->descend(state, name, item.directory, ignored);
+                if (ignored) {
+                    return;
+                }
+            }
+            listing.names.append(name);
+            item.nameEnd = static_cast<uint32_t>(listing.names.size());
+            listing.items.push_back(item);
+        });
+
+        uint32_t nameStart = 0;
+        for (Listing::Item& item : listing.items) {
+            if (item.directory && !item.link) {
+                item.child = &allocate();
+                std::string childPath = path;
+                childPath += '/';
+                childPath.append(listing.names, nameStart, item.nameEnd - nameStart);
+                if (queued_.load() < maxQueued_) {
+                    queued_.fetch_add(1);
+                    group_.run([this, childPath = std::move(childPath), child = item.child, state = item.state] {
+                        queued_.fetch_sub(1);
+                        read(childPath, *child, state);
+                    });
+                } else {
+                    read(childPath, *item.child, item.state);
+                }
+            }
+            nameStart = item.nameEnd;
+        }
+    }
+
+    void wait() { group_.wait(); }
+
+private:
+    const std::function<void()>& onDirectory_;
+    const IgnoreRules* rules_;
+    const std::size_t maxQueued_;
+    std::atomic<std::size_t> queued_{0};
+    std::mutex mutex_;
+    std::deque<Listing> listings_;  // Never moved: the tasks fill them in place
+    TaskGroup group_;               // Last, so that it waits before the listings go
+};
+
+/**
+ * Appends the listings to the table depth first, in the order PathTable::scan() uses.
+ */
+void assemble(const Listing& root, PathTable& table) {
+    std::vector<std::pair<const Listing*, uint32_t>> pending{{&root, PathTable::noParent}};
+    while (!pending.empty()) {
+        auto [listing, parent] = pending.back();
+        pending.pop_back();
+        const std::string_view names(listing->names);
+        const uint32_t first = static_cast<uint32_t>(table.size());
+        uint32_t nameStart = 0;
+        for (const Listing::Item& item : listing->items) {
+            table.add(parent, names.substr(nameStart, item.nameEnd - nameStart), item.directory);
+            nameStart = item.nameEnd;
+        }
+        for (std::size_t i = listing->items.size(); i-- > 0;) {
+            if (listing->items[i].child != nullptr) {
+                pending.emplace_back(listing->items[i].child, first + static_cast<uint32_t>(i));
+            }
+        }
+    }
+}
+
+}
+
+namespace DirScanner {
+
+/**
+ * @brief Lists the entries of one directory, "." and ".." excepted.
+ * @param directory The directory.
+ * @return std::vector<Entry> - Its entries, in the order the file system returns them.
+ */
+std::vector<Entry> list(const fs::path& directory) {
+    std::vector<Entry> entries;
+    readDirectory(directory.string(), [&entries](std::string_view name, Kind kind, bool link) {
+        entries.push_back(Entry{std::string(name), kind, link});
+    });
+    return entries;
+}
+
+/**
+ * @brief Appends the files and directories under a directory, read in parallel.
+ *
+ * Gives the same table as PathTable::scan(): regular files and directories only, links
+ * listed as their target, links to directories not followed.
+ * @param root The directory to walk; entries are relative to it.
+ * @param table Receives the entries.
+ * @param onDirectory Called before each directory is read, from any worker thread; it may
+ * stop the walk by throwing.
+ * @param filter The ignore rules at root: ignored entries are left out, ignored directories
+ * are not read.
+ * @param pool Runs the directory reads.
+ */
+void scan(const fs::path& root, PathTable& table, const std::function<void()>& onDirectory,
+          const IgnoreFilter& filter, ThreadPool& pool) {
+#if defined(__linux__) && defined(SYS_getdents64)
+    ParallelScan scan(onDirectory, filter.rules, pool);
+    Listing& listing = scan.allocate();
+    scan.read(root.string(), listing, filter.active() ? filter.state : IgnoreRules::none);
+    scan.wait();
+    assemble(listing, table);
+#else
+    (void)pool;
+    table.scan(root, onDirectory, filter);
+#endif
+}
+
+/**
+ * @brief Tells whether directories are read with getdents64 rather than std::filesystem.
+ */
+bool nativeSupported() {
+#if defined(__linux__) && defined(SYS_getdents64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef DIRSCANNER_H
+#define DIRSCANNER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ignorerules.h>
+#include <pathtable.h>
+#include <threadpool.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Native directory reading and parallel tree walks.
+ *
+ * On Linux directories are read with getdents64 into a large per-thread buffer, many
+ * entries per system call, and the type the kernel reports with each entry (d_type) is
+ * used as is: only symbolic links and file systems that report no type cost a stat.
+ * scan() reads the subdirectories of a tree in parallel on a thread pool, each worker
+ * listing directories into its own buffers, and assembles the PathTable once at the end
+ * in the order PathTable::scan() would give. Elsewhere both fall back to std::filesystem.
+ */
+namespace DirScanner {
+
+enum class Kind : uint8_t {
+    File,       // Regular file
+    Directory,
+    Other       // Anything else, including broken links
+};
+
+/**
+ * @brief One entry of a directory; a symbolic link has the kind of its target.
+ */
+struct Entry
+{
+    std::string name;
+    Kind kind = Kind::Other;
+    bool link = false;
+};
+
+std::vector<Entry> list(const fs::path& directory);
+void scan(const fs::path& root, PathTable& table, const std::function<void()>& onDirectory = nullptr,
+          const IgnoreFilter& filter = IgnoreFilter(), ThreadPool& pool = ThreadPool::shared());
+bool nativeSupported();
+
+}
+
+#endif // DIRSCANNER_H
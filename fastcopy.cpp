@@ -0,0 +1,357 @@
+#include <fastcopy.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const std::size_t copyBufferSize = 1 << 20;
+
+#ifdef __linux__
+
+/**
+ * Owns a file descriptor.
+ */
+class FileDescriptor
+{
+public:
+    explicit FileDescriptor(int fd) : fd_(fd) {}
+    ~FileDescriptor() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// Errors meaning "this method is not available here", as opposed to a real I/O error
+bool isUnsupported(int error) {
+    return error == EXDEV || error == ENOSYS || error == EINVAL || error == EOPNOTSUPP
+        || error == ENOTTY || error == EBADF || error == EPERM;
+}
+
+/**
+ * Clones as much of the range as the filesystem allows: the whole file at once when the
+ * range is the whole file, otherwise the block-aligned part of it. Returns the cloned size.
+ */
+uint64_t reflinkRange(int source, int destination, uint64_t offset, uint64_t length, uint64_t sourceSize) {
+#if defined(FICLONE) && defined(FICLONERANGE)
+    if (offset == 0 && length == sourceSize) {
+        return ::ioctl(destination, FICLONE, source) == 0 ? length : 0;
+    }
+
+    struct stat info;
+    if (::fstat(source, &info) != 0 || info.st_blksize <= 0) {
+        return 0;
+    }
+    uint64_t block = static_cast<uint64_t>(info.st_blksize);
+    uint64_t aligned = length - length % block;
+    if (offset % block != 0 || aligned == 0) {
+        return 0;
+    }
+
+    struct file_clone_range range;
+    range.src_fd = source;
+    range.src_offset = offset;
+    range.src_length = aligned;
+    range.dest_offset = 0;
+    return ::ioctl(destination, FICLONERANGE, &range) == 0 ? aligned : 0;
+#else
+    (void)source; (void)destination; (void)offset; (void)length; (void)sourceSize;
+    return 0;
+#endif
+}
+
+/**
+ * Kernel-side copy with copy_file_range. Returns false if the method is unavailable.
+ */
+bool kernelCopy(int source, int destination, uint64_t offset, uint64_t length, uint64_t& done) {
+#if defined(SYS_copy_file_range)
+    const uint64_t start = done;
+    while (done < length) {
+        loff_t in = static_cast<loff_t>(offset + done);
+        loff_t out = static_cast<loff_t>(done);
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(length - done, 1ULL << 30));
+        long copied = ::syscall(SYS_copy_file_range, source, &in, destination, &out, chunk, 0u);
+        if (copied < 0) {
+            if (isUnsupported(errno) && done == start) {
+                return false;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "copy_file_range");
+        }
+        if (copied == 0) {
+            throw std::runtime_error("copy_file_range: unexpected end of file");
+        }
+        done += static_cast<uint64_t>(copied);
+    }
+    return true;
+#else
+    (void)source; (void)destination; (void)offset; (void)length; (void)done;
+    return false;
+#endif
+}
+
+/**
+ * Kernel-side copy with sendfile. Returns false if the method is unavailable.
+ */
+bool sendFileCopy(int source, int destination, uint64_t offset, uint64_t length, uint64_t& done) {
+    if (::lseek(destination, static_cast<off_t>(done), SEEK_SET) < 0) {
+        return false;
+    }
+    bool started = false;
+    while (done < length) {
+        off_t in = static_cast<off_t>(offset + done);
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(length - done, 1ULL << 30));
+        ssize_t copied = ::sendfile(destination, source, &in, chunk);
+        if (copied < 0) {
+            if (isUnsupported(errno) && !started) {
+                return false;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "sendfile");
+        }
+        if (copied == 0) {
+            throw std::runtime_error("sendfile: unexpected end of file");
+        }
+        started = true;
+        done += static_cast<uint64_t>(copied);
+    }
+    return true;
+}
+
+/**
+ * Copy through a user-space buffer.
+ */
+void bufferedCopy(int source, int destination, uint64_t offset, uint64_t length, uint64_t& done) {
+    std::vector<char> buffer(copyBufferSize);
+    while (done < length) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(length - done, buffer.size()));
+        ssize_t count = ::pread(source, buffer.data(), chunk, static_cast<off_t>(offset + done));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "read");
+        }
+        if (count == 0) {
+            throw std::runtime_error("read: unexpected end of file");
+        }
+        ssize_t written = 0;
+        while (written < count) {
+            ssize_t result = ::pwrite(destination, buffer.data() + written, static_cast<std::size_t>(count - written),
+                                      static_cast<off_t>(done + written));
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+            written += result;
+        }
+        done += static_cast<uint64_t>(count);
+    }
+}
+
+#endif // __linux__
+
+}
+
+namespace FastCopy {
+
+/**
+ * @brief Copies a byte range of a file into a new file (replacing it if it exists).
+ * @param source The file to copy from.
+ * @param offset First byte of the range.
+ * @param length Number of bytes to copy.
+ * @param destination The file receiving the bytes.
+ * @param mode The first method to try, see CopyMode.
+ * @return CopyMode - The method that copied the bulk of the data.
+ */
+CopyMode copyRange(const fs::path& source, uint64_t offset, uint64_t length,
+                   const fs::path& destination, CopyMode mode) {
+#ifdef __linux__
+    FileDescriptor in(::open(source.c_str(), O_RDONLY | O_CLOEXEC));
+    if (in.get() < 0) {
+        throw std::system_error(errno, std::generic_category(), "Error opening " + source.string());
+    }
+    struct stat info;
+    if (::fstat(in.get(), &info) != 0) {
+        throw std::system_error(errno, std::generic_category(), "Error reading " + source.string());
+    }
+    uint64_t sourceSize = static_cast<uint64_t>(info.st_size);
+    if (offset > sourceSize || length > sourceSize - offset) {
+        throw std::runtime_error("Copy range outside of " + source.string());
+    }
+
+    FileDescriptor out(::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+    if (out.get() < 0) {
+        throw std::system_error(errno, std::generic_category(), "Error opening " + destination.string());
+    }
+
+    uint64_t done = 0;
+    CopyMode used = CopyMode::Buffered;
+    CopyMode start = mode == CopyMode::Auto ? CopyMode::Reflink : mode;
+
+    if (start == CopyMode::Reflink) {
+        done = reflinkRange(in.get(), out.get(), offset, length, sourceSize);
+        if (done > 0) {
+            used = CopyMode::Reflink;
+        }
+    }
+    // The unaligned tail of a reflink continues with the next methods
+    if (done < length && start <= CopyMode::CopyFileRange) {
+        uint64_t before = done;
+        if (kernelCopy(in.get(), out.get(), offset, length, done) && done > before && used == CopyMode::Buffered) {
+            used = CopyMode::CopyFileRange;
+        }
+    }
+    if (done < length && start <= CopyMode::SendFile) {
+        uint64_t before = done;
+        if (sendFileCopy(in.get(), out.get(), offset, length, done) && done > before && used == CopyMode::Buffered) {
+            used = CopyMode::SendFile;
+        }
+    }
+    if (done < length) {
+        bufferedCopy(in.get(), out.get(), offset, length, done);
+    }
+    return used;
+#else
+    (void)mode;
+    std::ifstream in(source, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Error opening " + source.string());
+    }
+    std::ofstream out(destination, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Error opening " + destination.string());
+    }
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::vector<char> buffer(copyBufferSize);
+    uint64_t done = 0;
+    while (done < length) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(length - done, buffer.size()));
+        in.read(buffer.data(), static_cast<std::streamsize>(chunk));
+        if (static_cast<std::size_t>(in.gcount()) != chunk) {
+            throw std::runtime_error("Unexpected end of file in " + source.string());
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(chunk));
+        done += chunk;
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Error writing " + destination.string());
+    }
+    return CopyMode::Buffered;
+#endif
+}
+
+/**
+ * @brief Makes a metadata-only copy of a whole file, where the filesystem supports it.
+ * @param source The file to clone.
+ * @param destination The new file; it is removed again if cloning is not supported.
+ * @return bool - true if the file was cloned.
+ */
+bool cloneFile(const fs::path& source, const fs::path& destination) {
+#if defined(__linux__) && defined(FICLONE)
+    FileDescriptor in(::open(source.c_str(), O_RDONLY | O_CLOEXEC));
+    if (in.get() < 0) {
+        return false;
+    }
+    bool cloned;
+    {
+        FileDescriptor out(::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666));
+        if (out.get() < 0) {
+            return false;
+        }
+        cloned = ::ioctl(out.get(), FICLONE, in.get()) == 0;
+    }
+    if (!cloned) {
+        std::error_code ec;
+        fs::remove(destination, ec);
+    }
+    return cloned;
+#else
+    (void)source;
+    (void)destination;
+    return false;
+#endif
+}
+
+/**
+ * @brief Returns the name of a copy mode, as accepted by parseMode().
+ * @param mode The mode.
+ * @return const char* - Its name.
+ */
+const char* modeName(CopyMode mode) {
+    switch (mode) {
+    case CopyMode::Auto:
+        return "auto";
+    case CopyMode::Reflink:
+        return "reflink";
+    case CopyMode::CopyFileRange:
+        return "copy_file_range";
+    case CopyMode::SendFile:
+        return "sendfile";
+    case CopyMode::Buffered:
+        return "buffered";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Parses a copy mode name.
+ * @param name One of auto, reflink, copy_file_range, sendfile or buffered.
+ * @param mode Receives the mode.
+ * @return bool - false if the name is unknown.
+ */
+bool parseMode(const std::string& name, CopyMode& mode) {
+    for (CopyMode candidate : {CopyMode::Auto, CopyMode::Reflink, CopyMode::CopyFileRange,
+                               CopyMode::SendFile, CopyMode::Buffered}) {
+        if (name == modeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the mode selected by the MINIGIT_COPY_MODE environment variable.
+ * @return CopyMode - Auto when the variable is not set or not valid.
+ */
+CopyMode modeFromEnvironment() {
+    CopyMode mode = CopyMode::Auto;
+    const char* value = std::getenv("MINIGIT_COPY_MODE");
+    if (value != nullptr) {
+        parseMode(value, mode);
+    }
+    return mode;
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef FASTCOPY_H
+#define FASTCOPY_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief How file data is copied between the working tree and the object store.
+ *
+ * Auto tries the cheapest method first: a reflink (FICLONE, metadata only on btrfs/XFS),
+ * then a kernel-side copy (copy_file_range, then sendfile), and finally a buffered copy
+ * through user space. Selecting another mode starts the chain at that method.
+ */
+enum class CopyMode {
+    Auto,
+    Reflink,
+    CopyFileRange,
+    SendFile,
+    Buffered
+};
+
+namespace FastCopy {
+
+CopyMode copyRange(const fs::path& source, uint64_t offset, uint64_t length,
+                   const fs::path& destination, CopyMode mode = CopyMode::Auto);
+bool cloneFile(const fs::path& source, const fs::path& destination);
+
+const char* modeName(CopyMode mode);
+bool parseMode(const std::string& name, CopyMode& mode);
+CopyMode modeFromEnvironment();
+
+}
+
+#endif // FASTCOPY_H
@@ -0,0 +1,510 @@
+#include <ignorerules.h>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// Moves cached per thread before the cache is emptied
+const std::size_t maxCachedMoves = 1 << 16;
+
+std::atomic<uint64_t> nextGeneration{1};
+
+bool isGlobCharacter(char c) {
+    return c == '*' || c == '?' || c == '[' || c == '\\';
+}
+
+/**
+ * Matches one character of a glob at position p; next receives the position after it.
+ */
+bool matchOne(std::string_view pattern, std::size_t p, char c, std::size_t& next) {
+    const unsigned char ch = static_cast<unsigned char>(c);
+    switch (pattern[p]) {
+    case '?':
+        next = p + 1;
+        return true;
+    case '\\':
+        if (p + 1 < pattern.size()) {
+            next = p + 2;
+            return pattern[p + 1] == c;
+        }
+        break;
+    case '[': {
+        std::size_t i = p + 1;
+        bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+        if (negate) {
+            ++i;
+        }
+        bool matched = false;
+        bool first = true;
+        while (i < pattern.size() && (pattern[i] != ']' || first)) {
+            first = false;
+            if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+                ++i;
+            }
+            unsigned char low = static_cast<unsigned char>(pattern[i++]);
+            unsigned char high = low;
+            if (i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']') {
+                ++i;
+                if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+                    ++i;
+                }
+                high = static_cast<unsigned char>(pattern[i++]);
+            }
+            matched = matched || (ch >= low && ch <= high);
+        }
+        if (i < pattern.size()) {
+            next = i + 1;
+            return matched != negate;
+        }
+        // No closing bracket: a plain '['
+        break;
+    }
+    default:
+        break;
+    }
+    next = p + 1;
+    return pattern[p] == c;
+}
+
+/**
+ * Matches a name against a glob; '*' backtracks to its last occurrence only, which is
+ * enough since it cannot cross a '/'.
+ */
+bool globMatch(std::string_view pattern, std::string_view name) {
+    std::size_t p = 0;
+    std::size_t n = 0;
+    std::size_t starPattern = std::string_view::npos;
+    std::size_t starName = 0;
+    while (n < name.size()) {
+        if (p < pattern.size()) {
+            if (pattern[p] == '*') {
+                starPattern = ++p;
+                starName = n;
+                continue;
+            }
+            std::size_t next;
+            if (matchOne(pattern, p, name[n], next)) {
+                p = next;
+                ++n;
+                continue;
+            }
+        }
+        if (starPattern == std::string_view::npos) {
+            return false;
+        }
+        p = starPattern;
+        n = ++starName;
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+void sortUnique(std::vector<uint32_t>& values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+}
+
+/**
+ * @brief Replaces the patterns by the ones of an ignore file.
+ * @param file The file, usually .minigitignore at the repository root.
+ * @return bool - false if the file cannot be read (no pattern is left then).
+ */
+bool IgnoreRules::load(const fs::path& file) {
+    clear();
+    std::ifstream input(file);
+    if (!input.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(input, line)) {
+        addPattern(line);
+    }
+    return true;
+}
+
+/**
+ * @brief Adds the pattern of one line of an ignore file; blank lines and comments add nothing.
+ *
+ * Not to be called while a walk uses the rules: the automaton is rebuilt from scratch.
+ * @param line The line.
+ */
+void IgnoreRules::addPattern(const std::string& line) {
+    std::string text = line;
+    if (!text.empty() && text.back() == '\r') {
+        text.pop_back();
+    }
+    while (!text.empty() && text.back() == ' ' && (text.size() < 2 || text[text.size() - 2] != '\\')) {
+        text.pop_back();
+    }
+    if (text.empty() || text[0] == '#') {
+        return;
+    }
+
+    Pattern pattern;
+    std::size_t begin = 0;
+    if (text[0] == '!') {
+        pattern.negated = true;
+        begin = 1;
+    } else if (text[0] == '\\' && text.size() > 1 && (text[1] == '#' || text[1] == '!')) {
+        begin = 1;
+    }
+    if (text.back() == '/') {
+        pattern.directoryOnly = true;
+        text.pop_back();
+    }
+    text.erase(0, begin);
+    bool anchored = text.find('/') != std::string::npos;
+    if (!anchored) {
+        pattern.segments.push_back({SegmentKind::Recursive, std::string()});
+    }
+
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t slash = std::min(text.find('/', start), text.size());
+        std::string name = text.substr(start, slash - start);
+        start = slash + 1;
+        if (name.empty()) {
+            continue;
+        }
+        Segment segment;
+        std::size_t special = std::count_if(name.begin(), name.end(), isGlobCharacter);
+        if (name == "**") {
+            segment.kind = SegmentKind::Recursive;
+        } else if (name == "*") {
+            segment.kind = SegmentKind::Any;
+        } else if (special == 0) {
+            segment.kind = SegmentKind::Literal;
+            segment.text = name;
+        } else if (special == 1 && name.front() == '*') {
+            segment.kind = SegmentKind::Suffix;
+            segment.text = name.substr(1);
+        } else if (special == 1 && name.back() == '*') {
+            segment.kind = SegmentKind::Prefix;
+            segment.text = name.substr(0, name.size() - 1);
+        } else {
+            segment.kind = SegmentKind::Glob;
+            segment.text = name;
+        }
+        pattern.segments.push_back(std::move(segment));
+    }
+    if (pattern.segments.empty() || (pattern.segments.size() == 1 && !anchored)) {
+        return;
+    }
+    // "dir/**" matches what is inside dir, not dir itself
+    if (pattern.segments.back().kind == SegmentKind::Recursive) {
+        pattern.segments.insert(pattern.segments.end() - 1, Segment{SegmentKind::Any, std::string()});
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    firstPosition_.push_back(static_cast<uint32_t>(patternOf_.size()));
+    patternOf_.insert(patternOf_.end(), pattern.segments.size() + 1, static_cast<uint32_t>(patterns_.size()));
+    patterns_.push_back(std::move(pattern));
+    // The transitions point into the segments
+    discardStates();
+}
+
+/**
+ * @brief Removes every pattern.
+ */
+void IgnoreRules::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    patterns_.clear();
+    firstPosition_.clear();
+    patternOf_.clear();
+    discardStates();
+}
+
+/**
+ * @brief Returns the state of the repository root.
+ * @return State - none when there is no pattern.
+ */
+IgnoreRules::State IgnoreRules::start() const {
+    if (patterns_.empty()) {
+        return none;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (start_ == none) {
+        prepare();
+    }
+    return start_;
+}
+
+/**
+ * @brief Moves a state into an entry of its directory. Safe to call from several threads,
+ * but not while patterns are added.
+ * @param state The state of the directory.
+ * @param name The name of the entry.
+ * @param directory Whether the entry is a directory.
+ * @param ignored Receives whether the entry is ignored.
+ * @return State - The state of the entry, to descend into it if it is a directory.
+ */
+IgnoreRules::State IgnoreRules::descend(State state, std::string_view name, bool directory, bool& ignored) const {
+    ignored = false;
+    if (state == none) {
+        return none;
+    }
+    DfaState& current = stateAt(state);
+    if (!current.built.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!current.built.load(std::memory_order_relaxed)) {
+            build(current);
+        }
+    }
+    const Transitions& next = current.next;
+    const Transitions& floating = floatingState_->next;
+
+    thread_local std::vector<uint32_t> hits;
+    hits.clear();
+    auto take = [](const std::unordered_map<std::string_view, std::vector<uint32_t>>& index, std::string_view key) {
+        auto found = index.find(key);
+        if (found != index.end()) {
+            hits.insert(hits.end(), found->second.begin(), found->second.end());
+        }
+    };
+    for (const Transitions* transitions : {&next, &floating}) {
+        take(transitions->literals, name);
+        for (std::size_t length : transitions->prefixLengths) {
+            if (length > name.size()) {
+                break;
+            }
+            take(transitions->prefixes, name.substr(0, length));
+        }
+        for (std::size_t length : transitions->suffixLengths) {
+            if (length > name.size()) {
+                break;
+            }
+            take(transitions->suffixes, name.substr(name.size() - length));
+        }
+        for (const auto& glob : transitions->globs) {
+            if (globMatch(glob.first->text, name)) {
+                hits.push_back(glob.second);
+            }
+        }
+    }
+
+    State result = next.otherwise;
+    if (!hits.empty()) {
+        sortUnique(hits);
+        result = reach(state, current, hits);
+    }
+
+    if (result != none) {
+        const DfaState& reached = stateAt(result);
+        int match = directory ? reached.match : reached.fileMatch;
+        ignored = match >= 0 && !patterns_[static_cast<std::size_t>(match)].negated;
+    }
+    return result;
+}
+
+/**
+ * @brief Tells whether a path or one of its parent directories is ignored.
+ * @param path The path relative to the repository root, '/' separated.
+ * @param directory Whether the path is a directory.
+ * @return bool - true if it is ignored.
+ */
+bool IgnoreRules::ignored(std::string_view path, bool directory) const {
+    State state = start();
+    std::size_t begin = 0;
+    while (begin < path.size() && state != none) {
+        std::size_t slash = std::min(path.find('/', begin), path.size());
+        std::string_view name = path.substr(begin, slash - begin);
+        begin = slash + 1;
+        if (name.empty() || name == ".") {
+            continue;
+        }
+        bool ignoredName;
+        state = descend(state, name, begin < path.size() || directory, ignoredName);
+        if (ignoredName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t IgnoreRules::position(std::size_t pattern, std::size_t segment) const {
+    return firstPosition_[pattern] + static_cast<uint32_t>(segment);
+}
+
+/**
+ * Adds a position and, through the '**' segments that can match no name, the ones after it.
+ */
+void IgnoreRules::close(uint32_t position, std::vector<uint32_t>& positions) const {
+    while (true) {
+        positions.push_back(position);
+        const Pattern& pattern = patterns_[patternOf_[position]];
+        std::size_t segment = position - firstPosition_[patternOf_[position]];
+        if (segment == pattern.segments.size() || pattern.segments[segment].kind != SegmentKind::Recursive) {
+            return;
+        }
+        ++position;
+    }
+}
+
+/**
+ * Sets the floating positions apart and creates the start state.
+ */
+void IgnoreRules::prepare() const {
+    std::vector<uint32_t> floating;
+    std::vector<uint32_t> anchored;
+    for (std::size_t i = 0; i < patterns_.size(); ++i) {
+        bool any = patterns_[i].segments.front().kind == SegmentKind::Recursive;
+        close(position(i, 0), any ? floating : anchored);
+    }
+    // A '**' position moves to itself on any name: once reached it stays. None of them
+    // accepts, a pattern never ends with a '**' that may match no name.
+    floating_.assign(patternOf_.size(), false);
+    for (uint32_t position : floating) {
+        floating_[position] = true;
+    }
+    floatingState_ = std::make_unique<DfaState>();
+    floatingState_->positions = std::move(floating);
+    build(*floatingState_);
+    start_ = intern(std::move(anchored));
+}
+
+IgnoreRules::DfaState& IgnoreRules::stateAt(State state) const {
+    return *chunks_[state / chunkSize][state % chunkSize];
+}
+
+/**
+ * Returns the state of a set of positions, creating it the first time. The floating
+ * positions are left out; none when nothing is left and no pattern floats.
+ */
+IgnoreRules::State IgnoreRules::intern(std::vector<uint32_t> positions) const {
+    positions.erase(std::remove_if(positions.begin(), positions.end(),
+                                   [this](uint32_t position) { return floating_[position]; }),
+                    positions.end());
+    sortUnique(positions);
+    if (positions.empty() && floatingState_->positions.empty()) {
+        return none;
+    }
+    auto found = stateIds_.find(positions);
+    if (found != stateIds_.end()) {
+        return found->second;
+    }
+
+    State id = stateCount_;
+    if (id / chunkSize >= maxChunks) {
+        throw std::length_error("Too many ignore rule states");
+    }
+    std::unique_ptr<std::unique_ptr<DfaState>[]>& chunk = chunks_[id / chunkSize];
+    if (!chunk) {
+        chunk.reset(new std::unique_ptr<DfaState>[chunkSize]);
+    }
+    auto state = std::make_unique<DfaState>();
+    for (uint32_t position : positions) {
+        uint32_t pattern = patternOf_[position];
+        if (position - firstPosition_[pattern] == patterns_[pattern].segments.size()) {
+            state->match = std::max(state->match, static_cast<int>(pattern));
+            if (!patterns_[pattern].directoryOnly) {
+                state->fileMatch = std::max(state->fileMatch, static_cast<int>(pattern));
+            }
+        }
+    }
+    state->positions = positions;
+    chunk[id % chunkSize] = std::move(state);
+    ++stateCount_;
+    stateIds_.emplace(std::move(positions), id);
+    return id;
+}
+
+/**
+ * Indexes the segments a state can match next by how they match a name.
+ */
+void IgnoreRules::build(DfaState& state) const {
+    Transitions& next = state.next;
+    if (&state != floatingState_.get()) {
+        // What the floating patterns reach on any name ("*", "**/*") is part of every move
+        next.always = floatingState_->next.always;
+    }
+    for (uint32_t position : state.positions) {
+        const Pattern& pattern = patterns_[patternOf_[position]];
+        std::size_t index = position - firstPosition_[patternOf_[position]];
+        if (index == pattern.segments.size()) {
+            continue;
+        }
+        const Segment& segment = pattern.segments[index];
+        const uint32_t target = position + 1;
+        switch (segment.kind) {
+        case SegmentKind::Recursive:
+            close(position, next.always);
+            break;
+        case SegmentKind::Any:
+            close(target, next.always);
+            break;
+        case SegmentKind::Literal:
+            next.literals[segment.text].push_back(target);
+            break;
+        case SegmentKind::Prefix:
+            next.prefixes[segment.text].push_back(target);
+            next.prefixLengths.push_back(segment.text.size());
+            break;
+        case SegmentKind::Suffix:
+            next.suffixes[segment.text].push_back(target);
+            next.suffixLengths.push_back(segment.text.size());
+            break;
+        case SegmentKind::Glob:
+            next.globs.emplace_back(&segment, target);
+            break;
+        }
+    }
+    for (std::vector<std::size_t>* lengths : {&next.prefixLengths, &next.suffixLengths}) {
+        std::sort(lengths->begin(), lengths->end());
+        lengths->erase(std::unique(lengths->begin(), lengths->end()), lengths->end());
+    }
+    sortUnique(next.always);
+    next.otherwise = intern(next.always);
+    // Publishes next to the lookups that do not lock
+    state.built.store(true, std::memory_order_release);
+}
+
+/**
+ * Returns the state reached from a state by a name that matched the given targets,
+ * sorted. The moves are cached per thread: only the first one takes the lock.
+ */
+IgnoreRules::State IgnoreRules::reach(State state, const DfaState& current, const std::vector<uint32_t>& hits) const {
+    thread_local uint64_t cacheGeneration = 0;
+    thread_local std::unordered_map<std::string, State> cache;
+    thread_local std::string key;
+    if (cacheGeneration != generation_ || cache.size() >= maxCachedMoves) {
+        cache.clear();
+        cacheGeneration = generation_;
+    }
+    key.assign(reinterpret_cast<const char*>(&state), sizeof(state));
+    key.append(reinterpret_cast<const char*>(hits.data()), hits.size() * sizeof(uint32_t));
+    auto found = cache.find(key);
+    if (found != cache.end()) {
+        return found->second;
+    }
+
+    State result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<uint32_t> positions = current.next.always;
+        for (uint32_t hit : hits) {
+            close(hit, positions);
+        }
+        result = intern(std::move(positions));
+    }
+    cache.emplace(key, result);
+    return result;
+}
+
+void IgnoreRules::discardStates() {
+    for (auto& chunk : chunks_) {
+        chunk.reset();
+    }
+    stateCount_ = 0;
+    stateIds_.clear();
+    start_ = none;
+    floating_.clear();
+    floatingState_.reset();
+    // Every instance and every set of patterns gets its own, never reused
+    generation_ = nextGeneration.fetch_add(1);
+}
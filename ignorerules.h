@@ -0,0 +1,139 @@
+#ifndef IGNORERULES_H
+#define IGNORERULES_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief The patterns of a .minigitignore file, compiled into one automaton over path components.
+ *
+ * The syntax is the one of .gitignore: '#' comments, '!' to re-include, a trailing '/'
+ * for directories only, a pattern with a '/' anywhere but at its end is anchored to the
+ * repository root, otherwise it matches a name at any depth; '*', '?', '[...]' within a
+ * name and '**' across directories. The last matching pattern wins, and nothing below an
+ * ignored directory is looked at, so it cannot be re-included either.
+ *
+ * Every pattern is a sequence of name globs (or '**'). A State stands for all the
+ * positions reached in all the patterns by the path walked so far; descend() moves it by
+ * one name and tells whether that entry is ignored. States are built lazily and shared by
+ * every directory that reaches them; each one indexes the globs it can take next by exact
+ * name, by fixed prefix or suffix ("*.o", "cache*") and only tries the remaining ones one
+ * by one, so the cost of a name does not grow with the number of plain patterns. The
+ * patterns that match at any depth are in every state: they are kept out of the states and
+ * indexed once. A walk keeps the State of every directory it descends into and skips
+ * ignored directories before reading them.
+ *
+ * The parallel scans descend from many threads: a state is built under the lock, then
+ * published, and lookups on built states take no lock. The moves a name match leads to
+ * are cached per thread, so the lock is only taken the first time a thread makes a move.
+ */
+class IgnoreRules
+{
+public:
+    using State = uint32_t;
+    static const State none = UINT32_MAX;  // No pattern can match below: nothing is ignored
+
+    bool load(const fs::path& file);
+    void addPattern(const std::string& line);
+    void clear();
+
+    std::size_t size() const { return patterns_.size(); }
+    State start() const;
+    State descend(State state, std::string_view name, bool directory, bool& ignored) const;
+    bool ignored(std::string_view path, bool directory) const;
+
+private:
+    enum class SegmentKind {
+        Literal,    // The exact name
+        Prefix,     // "text*"
+        Suffix,     // "*text"
+        Any,        // "*"
+        Glob,       // Any other glob
+        Recursive   // "**": any number of names
+    };
+
+    struct Segment
+    {
+        SegmentKind kind = SegmentKind::Literal;
+        std::string text;
+    };
+
+    struct Pattern
+    {
+        std::vector<Segment> segments;
+        bool negated = false;
+        bool directoryOnly = false;
+    };
+
+    // What a state can take next, built the first time something descends from it
+    struct Transitions
+    {
+        std::vector<uint32_t> always;  // Reached whatever the name
+        std::unordered_map<std::string_view, std::vector<uint32_t>> literals;
+        std::unordered_map<std::string_view, std::vector<uint32_t>> prefixes;
+        std::unordered_map<std::string_view, std::vector<uint32_t>> suffixes;
+        std::vector<std::size_t> prefixLengths;
+        std::vector<std::size_t> suffixLengths;
+        std::vector<std::pair<const Segment*, uint32_t>> globs;
+        State otherwise = none;        // The state reached by a name no index matches
+    };
+
+    struct DfaState
+    {
+        std::vector<uint32_t> positions;  // Sorted pattern positions, see position()
+        int match = -1;                   // Last pattern ending here, -1 if none
+        int fileMatch = -1;               // The same among the patterns that are not directory only
+        std::atomic<bool> built{false};   // next is complete and no longer written
+        Transitions next;
+    };
+
+    // States live in chunks that never move, found without the lock
+    static const uint32_t chunkSize = 1024;
+    static const uint32_t maxChunks = 4096;
+
+    uint32_t position(std::size_t pattern, std::size_t segment) const;
+    void close(uint32_t position, std::vector<uint32_t>& positions) const;
+    void prepare() const;
+    DfaState& stateAt(State state) const;
+    State intern(std::vector<uint32_t> positions) const;
+    void build(DfaState& state) const;
+    State reach(State state, const DfaState& current, const std::vector<uint32_t>& hits) const;
+    void discardStates();
+
+    std::vector<Pattern> patterns_;
+    std::vector<uint32_t> firstPosition_;  // Position of the first segment of each pattern
+    std::vector<uint32_t> patternOf_;      // Pattern of each position
+
+    mutable std::mutex mutex_;  // Guards building and adding states
+    mutable std::array<std::unique_ptr<std::unique_ptr<DfaState>[]>, maxChunks> chunks_;
+    mutable uint32_t stateCount_ = 0;
+    mutable std::map<std::vector<uint32_t>, State> stateIds_;
+    mutable State start_ = none;
+    mutable std::vector<bool> floating_;                 // Per position: reached at any depth, left out of the states
+    mutable std::unique_ptr<DfaState> floatingState_;    // Their transitions
+    uint64_t generation_ = 0;  // Changes with the patterns, invalidating the per-thread move caches
+};
+
+/**
+ * @brief Where a walk starts in a set of ignore rules; an inactive filter keeps everything.
+ */
+struct IgnoreFilter
+{
+    const IgnoreRules* rules = nullptr;
+    IgnoreRules::State state = IgnoreRules::none;
+
+    bool active() const { return rules != nullptr && state != IgnoreRules::none; }
+};
+
+#endif // IGNORERULES_H
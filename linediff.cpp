@@ -0,0 +1,574 @@
+#include <linediff.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const std::size_t readChunkSize = 1 << 20;
+
+// Like git and GNU diff, a NUL byte this close to the start makes a file binary
+const std::size_t binaryProbeSize = 8000;
+
+// Middle snake searches never give up before this many steps
+const long minimumCostLimit = 4096;
+
+/**
+ * Hashes a line eight bytes at a time; the result does not depend on how the line was
+ * split across reads.
+ */
+class LineHasher
+{
+public:
+    void update(const char* data, std::size_t size) {
+        length_ += size;
+        if (pendingSize_ > 0) {
+            std::size_t taken = std::min(sizeof(pending_) - pendingSize_, size);
+            std::memcpy(pending_ + pendingSize_, data, taken);
+            pendingSize_ += taken;
+            data += taken;
+            size -= taken;
+            if (pendingSize_ < sizeof(pending_)) {
+                return;
+            }
+            mix(load(pending_));
+            pendingSize_ = 0;
+        }
+        for (; size >= 8; data += 8, size -= 8) {
+            mix(load(data));
+        }
+        std::memcpy(pending_, data, size);
+        pendingSize_ = size;
+    }
+
+    uint64_t finish() {
+        if (pendingSize_ > 0) {
+            uint64_t word = 0;
+            std::memcpy(&word, pending_, pendingSize_);
+            mix(word);
+        }
+        // Final avalanche (MurmurHash3 fmix64)
+        uint64_t hash = state_ ^ length_;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        state_ = seed;
+        length_ = 0;
+        pendingSize_ = 0;
+        return hash;
+    }
+
+private:
+    static const uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+    static uint64_t load(const char* data) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+
+    void mix(uint64_t word) {
+        state_ ^= word * 0x87c37b91114253d5ULL;
+        state_ = ((state_ << 31) | (state_ >> 33)) * 0x4cf5ad432745937fULL;
+    }
+
+    uint64_t state_ = seed;
+    uint64_t length_ = 0;
+    char pending_[8];
+    std::size_t pendingSize_ = 0;
+};
+
+/**
+ * Linear-space Myers search over two sequences of line ids, marking the lines that are
+ * not part of the common subsequence. Follows the layout of GNU diff's diag().
+ */
+class MiddleSnake
+{
+public:
+    MiddleSnake(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                std::vector<char>& removed, std::vector<char>& added)
+        : a_(a), b_(b), removed_(removed), added_(added) {
+        long diagonals = static_cast<long>(a.size() + b.size() + 3);
+        forward_.resize(static_cast<std::size_t>(diagonals));
+        backward_.resize(static_cast<std::size_t>(diagonals));
+        offset_ = static_cast<long>(b.size()) + 1;
+
+        // About the square root of the number of diagonals
+        costLimit_ = 1;
+        for (long remaining = diagonals; remaining != 0; remaining >>= 2) {
+            costLimit_ <<= 1;
+        }
+        costLimit_ = std::max(costLimit_, minimumCostLimit);
+    }
+
+    void run() {
+        std::vector<Range> pending{{0, static_cast<long>(a_.size()), 0, static_cast<long>(b_.size())}};
+        while (!pending.empty()) {
+            Range range = pending.back();
+            pending.pop_back();
+
+            long aLo = range.aLo, aHi = range.aHi, bLo = range.bLo, bHi = range.bHi;
+            while (aLo < aHi && bLo < bHi && a_[aLo] == b_[bLo]) {
+                ++aLo;
+                ++bLo;
+            }
+            while (aLo < aHi && bLo < bHi && a_[aHi - 1] == b_[bHi - 1]) {
+                --aHi;
+                --bHi;
+            }
+
+            if (aLo == aHi) {
+                std::fill(added_.begin() + bLo, added_.begin() + bHi, 1);
+            } else if (bLo == bHi) {
+                std::fill(removed_.begin() + aLo, removed_.begin() + aHi, 1);
+            } else {
+                long xMid;
+                long yMid;
+                split(aLo, aHi, bLo, bHi, xMid, yMid);
+                pending.push_back({xMid, aHi, yMid, bHi});
+                pending.push_back({aLo, xMid, bLo, yMid});
+            }
+        }
+    }
+
+private:
+    struct Range
+    {
+        long aLo;
+        long aHi;
+        long bLo;
+        long bHi;
+    };
+
+    // Finds a point of an optimal (or, past the cost limit, a good) path through the range
+    void split(long aLo, long aHi, long bLo, long bHi, long& xMid, long& yMid) {
+        long* fd = forward_.data() + offset_;
+        long* bd = backward_.data() + offset_;
+        const long dmin = aLo - bHi;
+        const long dmax = aHi - bLo;
+        const long fmid = aLo - bLo;
+        const long bmid = aHi - bHi;
+        const bool odd = ((fmid - bmid) & 1) != 0;
+        long fmin = fmid;
+        long fmax = fmid;
+        long bmin = bmid;
+        long bmax = bmid;
+        fd[fmid] = aLo;
+        bd[bmid] = aHi;
+
+        for (long cost = 1;; ++cost) {
+            // One more edit forward
+            if (fmin > dmin) {
+                fd[--fmin - 1] = -1;
+            } else {
+                ++fmin;
+            }
+            if (fmax < dmax) {
+                fd[++fmax + 1] = -1;
+            } else {
+                --fmax;
+            }
+            for (long d = fmax; d >= fmin; d -= 2) {
+                long x = fd[d - 1] >= fd[d + 1] ? fd[d - 1] + 1 : fd[d + 1];
+                long y = x - d;
+                while (x < aHi && y < bHi && a_[x] == b_[y]) {
+                    ++x;
+                    ++y;
+                }
+                fd[d] = x;
+                if (odd && bmin <= d && d <= bmax && bd[d] <= x) {
+                    xMid = x;
+                    yMid = y;
+                    return;
+                }
+            }
+
+            // One more edit backward
+            if (bmin > dmin) {
+                bd[--bmin - 1] = LONG_MAX;
+            } else {
+                ++bmin;
+            }
+            if (bmax < dmax) {
+                bd[++bmax + 1] = LONG_MAX;
+            } else {
+                --bmax;
+            }
+            for (long d = bmax; d >= bmin; d -= 2) {
+                long x = bd[d - 1] < bd[d + 1] ? bd[d - 1] : bd[d + 1] - 1;
+                long y = x - d;
+                while (x > aLo && y > bLo && a_[x - 1] == b_[y - 1]) {
+                    --x;
+                    --y;
+                }
+                bd[d] = x;
+                if (!odd && fmin <= d && d <= fmax && x <= fd[d]) {
+                    xMid = x;
+                    yMid = y;
+                    return;
+                }
+            }
+
+            if (cost >= costLimit_) {
+                // Too expensive: split where one of the searches got furthest
+                long forwardBest = -1;
+                long forwardX = 0;
+                for (long d = fmax; d >= fmin; d -= 2) {
+                    long x = std::min(fd[d], aHi);
+                    long y = x - d;
+                    if (bHi < y) {
+                        x = bHi + d;
+                        y = bHi;
+                    }
+                    if (forwardBest < x + y) {
+                        forwardBest = x + y;
+                        forwardX = x;
+                    }
+                }
+                long backwardBest = LONG_MAX;
+                long backwardX = 0;
+                for (long d = bmax; d >= bmin; d -= 2) {
+                    long x = std::max(aLo, bd[d]);
+                    long y = x - d;
+                    if (y < bLo) {
+                        x = bLo + d;
+                        y = bLo;
+                    }
+                    if (x + y < backwardBest) {
+                        backwardBest = x + y;
+                        backwardX = x;
+                    }
+                }
+                if ((aHi + bHi) - backwardBest < forwardBest - (aLo + bLo)) {
+                    xMid = forwardX;
+                    yMid = forwardBest - forwardX;
+                } else {
+                    xMid = backwardX;
+                    yMid = backwardBest - backwardX;
+                }
+                return;
+            }
+        }
+    }
+
+    const std::vector<uint32_t>& a_;
+    const std::vector<uint32_t>& b_;
+    std::vector<char>& removed_;
+    std::vector<char>& added_;
+    std::vector<long> forward_;
+    std::vector<long> backward_;
+    long offset_;
+    long costLimit_;
+};
+
+/**
+ * Copies lines of a file to the diff output, reading only those lines.
+ */
+class LinePrinter
+{
+public:
+    LinePrinter(const fs::path& file, const LineTable& lines) : lines_(lines) {
+        if (!file.empty()) {
+            input_.open(file, std::ios::binary);
+            if (!input_.is_open()) {
+                throw std::runtime_error("Error opening file: " + file.string());
+            }
+        }
+    }
+
+    void print(std::ostream& output, char prefix, std::size_t line) {
+        uint64_t begin = lines_.offsets[line];
+        uint64_t end = lines_.offsets[line + 1];
+        if (position_ != begin) {
+            input_.seekg(static_cast<std::streamoff>(begin));
+        }
+        buffer_.resize(static_cast<std::size_t>(end - begin));
+        input_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        if (!input_) {
+            throw std::runtime_error("File changed while diffing");
+        }
+        position_ = end;
+
+        output << prefix;
+        output.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        if (line + 1 == lines_.size() && !lines_.finalNewline) {
+            output << "\n\\ No newline at end of file\n";
+        }
+    }
+
+private:
+    const LineTable& lines_;
+    std::ifstream input_;
+    std::vector<char> buffer_;
+    uint64_t position_ = 0;
+};
+
+bool sameBytes(const fs::path& first, const fs::path& second) {
+    if (first.empty() || second.empty() || fs::file_size(first) != fs::file_size(second)) {
+        return false;
+    }
+    std::ifstream a(first, std::ios::binary);
+    std::ifstream b(second, std::ios::binary);
+    std::vector<char> bufferA(readChunkSize);
+    std::vector<char> bufferB(readChunkSize);
+    while (a && b) {
+        a.read(bufferA.data(), static_cast<std::streamsize>(bufferA.size()));
+        b.read(bufferB.data(), static_cast<std::streamsize>(bufferB.size()));
+        if (a.gcount() != b.gcount()
+            || std::memcmp(bufferA.data(), bufferB.data(), static_cast<std::size_t>(a.gcount())) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// "-start,count" of a hunk header; an empty range names the line before it
+std::string hunkRange(std::size_t first, std::size_t count) {
+    std::string range = std::to_string(count == 0 ? first : first + 1);
+    if (count != 1) {
+        range += "," + std::to_string(count);
+    }
+    return range;
+}
+
+}
+
+/**
+ * @brief Reads the line table of a file in one streaming pass.
+ * @param file The file to read.
+ * @return LineTable - Its lines, or only the binary flag for a binary file.
+ */
+LineTable LineTable::read(const fs::path& file) {
+    std::ifstream input(file, std::ios::binary);
+    if (!input.is_open()) {
+        throw std::runtime_error("Error opening file: " + file.string());
+    }
+
+    LineTable table;
+    table.offsets.push_back(0);
+    std::vector<char> buffer(readChunkSize);
+    LineHasher hasher;
+    uint64_t offset = 0;
+    bool openLine = false;
+    while (true) {
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::size_t size = static_cast<std::size_t>(input.gcount());
+        if (size == 0) {
+            break;
+        }
+        if (offset == 0 && std::memchr(buffer.data(), 0, std::min(size, binaryProbeSize)) != nullptr) {
+            table.binary = true;
+            table.offsets.clear();
+            return table;
+        }
+
+        const char* next = buffer.data();
+        const char* end = next + size;
+        while (next < end) {
+            const char* newline = static_cast<const char*>(std::memchr(next, '\n', static_cast<std::size_t>(end - next)));
+            if (newline == nullptr) {
+                hasher.update(next, static_cast<std::size_t>(end - next));
+                openLine = true;
+                break;
+            }
+            hasher.update(next, static_cast<std::size_t>(newline + 1 - next));
+            table.hashes.push_back(hasher.finish());
+            table.offsets.push_back(offset + static_cast<uint64_t>(newline + 1 - buffer.data()));
+            openLine = false;
+            next = newline + 1;
+        }
+        offset += size;
+    }
+    if (openLine) {
+        table.hashes.push_back(hasher.finish());
+        table.offsets.push_back(offset);
+        table.finalNewline = false;
+    }
+    return table;
+}
+
+/**
+ * @brief Computes the changed line runs between two files.
+ * @param oldLines The lines of the old file.
+ * @param newLines The lines of the new file.
+ * @return std::vector<LineChange> - The changes, in file order.
+ */
+std::vector<LineChange> LineDiff::compare(const LineTable& oldLines, const LineTable& newLines) {
+    // Equal lines get equal ids
+    std::unordered_map<uint64_t, uint32_t> ids;
+    ids.reserve(oldLines.size() + newLines.size());
+    std::vector<uint32_t> oldIds(oldLines.size());
+    std::vector<uint32_t> newIds(newLines.size());
+    std::vector<uint32_t> oldUses;
+    std::vector<uint32_t> newUses;
+    auto assign = [&ids, &oldUses, &newUses](uint64_t hash) {
+        auto inserted = ids.emplace(hash, static_cast<uint32_t>(ids.size()));
+        if (inserted.second) {
+            oldUses.push_back(0);
+            newUses.push_back(0);
+        }
+        return inserted.first->second;
+    };
+    for (std::size_t i = 0; i < oldLines.size(); ++i) {
+        oldIds[i] = assign(oldLines.hashes[i]);
+        ++oldUses[oldIds[i]];
+    }
+    for (std::size_t j = 0; j < newLines.size(); ++j) {
+        newIds[j] = assign(newLines.hashes[j]);
+        ++newUses[newIds[j]];
+    }
+
+    // Lines found on one side only are changes whatever the rest: search without them
+    std::vector<char> removed(oldLines.size(), 0);
+    std::vector<char> added(newLines.size(), 0);
+    std::vector<uint32_t> oldKept;
+    std::vector<uint32_t> newKept;
+    std::vector<std::size_t> oldIndex;
+    std::vector<std::size_t> newIndex;
+    for (std::size_t i = 0; i < oldIds.size(); ++i) {
+        if (newUses[oldIds[i]] == 0) {
+            removed[i] = 1;
+        } else {
+            oldKept.push_back(oldIds[i]);
+            oldIndex.push_back(i);
+        }
+    }
+    for (std::size_t j = 0; j < newIds.size(); ++j) {
+        if (oldUses[newIds[j]] == 0) {
+            added[j] = 1;
+        } else {
+            newKept.push_back(newIds[j]);
+            newIndex.push_back(j);
+        }
+    }
+
+    std::vector<char> keptRemoved(oldKept.size(), 0);
+    std::vector<char> keptAdded(newKept.size(), 0);
+    MiddleSnake(oldKept, newKept, keptRemoved, keptAdded).run();
+    for (std::size_t k = 0; k < keptRemoved.size(); ++k) {
+        removed[oldIndex[k]] |= keptRemoved[k];
+    }
+    for (std::size_t k = 0; k < keptAdded.size(); ++k) {
+        added[newIndex[k]] |= keptAdded[k];
+    }
+
+    // Unmarked lines pair up in order; everything between two pairs is one change
+    std::vector<LineChange> changes;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < removed.size() || j < added.size()) {
+        if (i < removed.size() && j < added.size() && !removed[i] && !added[j]) {
+            ++i;
+            ++j;
+            continue;
+        }
+        LineChange change;
+        change.oldFirst = i;
+        change.newFirst = j;
+        while (i < removed.size() && removed[i]) {
+            ++i;
+        }
+        while (j < added.size() && added[j]) {
+            ++j;
+        }
+        change.oldCount = i - change.oldFirst;
+        change.newCount = j - change.newFirst;
+        if (change.oldCount == 0 && change.newCount == 0) {
+            throw std::logic_error("Inconsistent line diff");
+        }
+        changes.push_back(change);
+    }
+    return changes;
+}
+
+/**
+ * @brief Writes the unified diff of two files.
+ *
+ * Both files are streamed twice at most: once to build their line tables and once to
+ * copy the lines of the hunks.
+ * @param output Receives the diff.
+ * @param oldFile The old file, empty if the file was added.
+ * @param newFile The new file, empty if the file was removed.
+ * @param oldName The name printed for the old file.
+ * @param newName The name printed for the new file.
+ * @param context Unchanged lines shown around each change.
+ * @return bool - false if the files have the same content (nothing is written).
+ */
+bool LineDiff::writeUnified(std::ostream& output, const fs::path& oldFile, const fs::path& newFile,
+                            const std::string& oldName, const std::string& newName, unsigned context) {
+    LineTable oldLines = oldFile.empty() ? LineTable() : LineTable::read(oldFile);
+    LineTable newLines = newFile.empty() ? LineTable() : LineTable::read(newFile);
+    if (oldFile.empty()) {
+        oldLines.offsets.push_back(0);
+    }
+    if (newFile.empty()) {
+        newLines.offsets.push_back(0);
+    }
+    std::string oldLabel = oldFile.empty() ? "/dev/null" : oldName;
+    std::string newLabel = newFile.empty() ? "/dev/null" : newName;
+
+    if (oldLines.binary || newLines.binary) {
+        if (sameBytes(oldFile, newFile)) {
+            return false;
+        }
+        output << "Binary files " << oldLabel << " and " << newLabel << " differ\n";
+        return true;
+    }
+
+    std::vector<LineChange> changes = compare(oldLines, newLines);
+    if (changes.empty()) {
+        return false;
+    }
+    output << "--- " << oldLabel << "\n+++ " << newLabel << "\n";
+
+    LinePrinter oldPrinter(oldFile, oldLines);
+    LinePrinter newPrinter(newFile, newLines);
+    std::size_t previousEnd = 0;  // Old line after the previous hunk
+    for (std::size_t first = 0; first < changes.size();) {
+        // Changes closer than two contexts share a hunk
+        std::size_t last = first;
+        while (last + 1 < changes.size()
+               && changes[last + 1].oldFirst - (changes[last].oldFirst + changes[last].oldCount) <= 2 * context) {
+            ++last;
+        }
+        const LineChange& head = changes[first];
+        const LineChange& tail = changes[last];
+        std::size_t lead = std::min<std::size_t>(context, head.oldFirst - previousEnd);
+        std::size_t nextStart = last + 1 < changes.size() ? changes[last + 1].oldFirst : oldLines.size();
+        std::size_t trail = std::min<std::size_t>(context, nextStart - (tail.oldFirst + tail.oldCount));
+        std::size_t oldStart = head.oldFirst - lead;
+        std::size_t newStart = head.newFirst - lead;
+        std::size_t oldEnd = tail.oldFirst + tail.oldCount + trail;
+        std::size_t newEnd = tail.newFirst + tail.newCount + trail;
+
+        output << "@@ -" << hunkRange(oldStart, oldEnd - oldStart) << " +" << hunkRange(newStart, newEnd - newStart)
+               << " @@\n";
+        std::size_t line = oldStart;
+        for (std::size_t k = first; k <= last; ++k) {
+            const LineChange& change = changes[k];
+            for (; line < change.oldFirst; ++line) {
+                oldPrinter.print(output, ' ', line);
+            }
+            for (std::size_t i = 0; i < change.oldCount; ++i) {
+                oldPrinter.print(output, '-', change.oldFirst + i);
+            }
+            for (std::size_t j = 0; j < change.newCount; ++j) {
+                newPrinter.print(output, '+', change.newFirst + j);
+            }
+            line = change.oldFirst + change.oldCount;
+        }
+        for (; line < oldEnd; ++line) {
+            oldPrinter.print(output, ' ', line);
+        }
+
+        previousEnd = oldEnd;
+        first = last + 1;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief The lines of a file as offsets and 64-bit hashes, without their bytes.
+ *
+ * A file is read once in 1 MiB chunks: lines are split with memchr (vectorized by the C
+ * library) and hashed eight bytes at a time, so a diff keeps 16 bytes per line in memory
+ * whatever the file size and only reads the bytes of the lines it prints.
+ */
+struct LineTable
+{
+    std::vector<uint64_t> offsets;  // Start of each line, then the file size
+    std::vector<uint64_t> hashes;
+    bool binary = false;            // A NUL byte in the first 8000 bytes; no lines are read
+    bool finalNewline = true;       // Whether the last line ends with '\n'
+
+    static LineTable read(const fs::path& file);
+    std::size_t size() const { return hashes.size(); }
+};
+
+/**
+ * @brief A run of changed lines: [oldFirst, oldFirst + oldCount) became [newFirst, newFirst + newCount).
+ */
+struct LineChange
+{
+    std::size_t oldFirst = 0;
+    std::size_t oldCount = 0;
+    std::size_t newFirst = 0;
+    std::size_t newCount = 0;
+};
+
+/**
+ * @brief Myers line diff.
+ *
+ * Common prefix and suffix are trimmed first and lines found on one side only are taken
+ * out before the search, as they cannot match anything. The search is the linear-space
+ * divide and conquer variant (middle snake); past a cost limit it splits at the furthest
+ * point reached instead of insisting on a minimal script, which bounds the time spent on
+ * files that share almost nothing.
+ */
+namespace LineDiff {
+
+std::vector<LineChange> compare(const LineTable& oldLines, const LineTable& newLines);
+
+bool writeUnified(std::ostream& output, const fs::path& oldFile, const fs::path& newFile,
+                  const std::string& oldName, const std::string& newName, unsigned context = 3);
+
+}
+
+#endif // LINEDIFF_H
@@ -0,0 +1,241 @@
+#include <logger.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug:
+        return "DEBUG";
+    case LogLevel::Info:
+        return "INFO";
+    case LogLevel::Warning:
+        return "WARNING";
+    case LogLevel::Error:
+        return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+// How long the writer sleeps when nobody wakes it up
+const std::chrono::milliseconds writerIdleWait(50);
+
+}
+
+/**
+ * @brief Logs an error message.
+ * @param message The message to be logged.
+ */
+void Logger::log(const std::string& message) {
+    log(LogLevel::Error, message);
+}
+
+/**
+ * @brief Queues a message for the log file without waiting for it to be written.
+ * @param level The severity; messages below the minimum level are discarded.
+ * @param message The message to be logged.
+ */
+void Logger::log(LogLevel level, std::string message) {
+    Logger& logger = instance();
+    if (static_cast<int>(level) < logger.minimumLevel_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    logger.push(level, std::move(message));
+}
+
+/**
+ * @brief Waits until every message queued before the call is written to the file.
+ */
+void Logger::flush() {
+    Logger& logger = instance();
+    uint64_t target = logger.enqueuePosition_.load();
+    std::unique_lock<std::mutex> lock(logger.wakeMutex_);
+    logger.wake_.notify_one();
+    logger.flushed_.wait(lock, [&logger, target] { return logger.written_.load() >= target; });
+}
+
+/**
+ * @brief Sets the lowest severity that is logged.
+ * @param level The minimum level (Debug by default).
+ */
+void Logger::setMinimumLevel(LogLevel level) {
+    instance().minimumLevel_ = static_cast<int>(level);
+}
+
+/**
+ * @brief Returns how many messages were dropped because the buffer was full.
+ * @return uint64_t - The number of dropped messages since the start.
+ */
+uint64_t Logger::droppedCount() {
+    return instance().dropped_.load();
+}
+
+/**
+ * @brief Returns the process-wide logger, starting its writer thread on first use.
+ *
+ * The logger is never destroyed, so threads may log until the very end; what is still
+ * queued at exit is flushed by an atexit handler.
+ */
+Logger& Logger::instance() {
+    static Logger* logger = [] {
+        Logger* created = new Logger();
+        std::atexit([] { Logger::flush(); });
+        return created;
+    }();
+    return *logger;
+}
+
+/**
+ * @brief Logger constructor: sets the slots up and starts the writer thread.
+ */
+Logger::Logger() : records_(new Record[capacity]) {
+    for (std::size_t i = 0; i < capacity; ++i) {
+        records_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread([this] { writerLoop(); });
+}
+
+/**
+ * @brief Claims a slot of the ring buffer and publishes a record in it.
+ * @return bool - false if the buffer was full and the record was dropped.
+ */
+bool Logger::push(LogLevel level, std::string&& message) {
+    uint64_t position = enqueuePosition_.load(std::memory_order_relaxed);
+    Record* record;
+    for (;;) {
+        record = &records_[position % capacity];
+        uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+        int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+        if (difference == 0) {
+            if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The writer did not free this slot yet: drop rather than block
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = enqueuePosition_.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->level = level;
+    record->time = std::chrono::system_clock::now();
+    record->message = std::move(message);
+    std::error_code ec;
+    record->directory = fs::current_path(ec).string();
+    record->sequence.store(position + 1);
+    if (writerSleeping_.load()) {
+        wake_.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Formats the published records, in order, and frees their slots.
+ *
+ * Stops before a record logged in another working directory than the first one taken.
+ * @param batch Receives the formatted lines.
+ * @param directory Receives the working directory of the records taken.
+ * @return std::size_t - The number of records taken.
+ */
+std::size_t Logger::drain(std::string& batch, std::string& directory) {
+    static std::time_t cachedSecond = -1;
+    static char cachedTime[32];
+
+    std::size_t count = 0;
+    for (;;) {
+        Record& record = records_[dequeuePosition_ % capacity];
+        if (record.sequence.load(std::memory_order_acquire) != dequeuePosition_ + 1) {
+            break;
+        }
+        if (count == 0) {
+            directory = record.directory;
+        } else if (record.directory != directory) {
+            break;
+        }
+
+        std::time_t second = std::chrono::system_clock::to_time_t(record.time);
+        if (second != cachedSecond) {
+            std::tm timeinfo;
+#ifdef _WIN32
+            localtime_s(&timeinfo, &second);
+#else
+            localtime_r(&second, &timeinfo);
+#endif
+            std::strftime(cachedTime, sizeof(cachedTime), "%d/%m/%Y %H:%M:%S", &timeinfo);
+            cachedSecond = second;
+        }
+        batch += '[';
+        batch += cachedTime;
+        batch += "][";
+        batch += levelName(record.level);
+        batch += "] ";
+        batch += record.message;
+        batch += '\n';
+
+        record.message.clear();
+        record.directory.clear();
+        record.sequence.store(dequeuePosition_ + capacity, std::memory_order_release);
+        ++dequeuePosition_;
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief Body of the writer thread: drains the buffer and appends batches to log.txt.
+ *
+ * A batch holds records logged in one working directory; the file is opened again when
+ * the directory of a batch differs from the last one.
+ */
+void Logger::writerLoop() {
+    std::ofstream logFile;
+    std::string logDirectory;
+    std::string directory;
+    std::string batch;
+    uint64_t reportedDrops = 0;
+    for (;;) {
+        batch.clear();
+        directory = logDirectory;
+        std::size_t count = drain(batch, directory);
+
+        uint64_t drops = dropped_.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            batch += "[WARNING] " + std::to_string(drops - reportedDrops) + " log messages dropped, the buffer was full\n";
+            reportedDrops = drops;
+        }
+        if (!batch.empty()) {
+            if (!logFile.is_open() || directory != logDirectory) {
+                logFile.close();
+                logFile.clear();
+                logFile.open(directory.empty() ? fs::path("log.txt") : fs::path(directory) / "log.txt", std::ios::app);
+                logDirectory = directory;
+            }
+            if (logFile.is_open()) {
+                logFile << batch;
+                logFile.flush();
+            }
+        }
+
+        if (count > 0) {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            written_ += count;
+            flushed_.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        writerSleeping_ = true;
+        wake_.wait_for(lock, writerIdleWait, [this] {
+            return records_[dequeuePosition_ % capacity].sequence.load() == dequeuePosition_ + 1;
+        });
+        writerSleeping_ = false;
+    }
+}
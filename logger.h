@@ -0,0 +1,78 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Severity of a log record.
+ */
+enum class LogLevel {
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+/**
+ * @brief Asynchronous logger writing to log.txt.
+ *
+ * log() only moves the message into a slot of a bounded lock-free ring buffer (a
+ * multi-producer, single-consumer queue with one sequence number per slot). A background
+ * thread formats the records and appends them to the file in batches, keeping the file
+ * open. Each record goes to the log.txt of the working directory it was logged in, so a
+ * caller changing directory (the GUI opening another repository) switches logs. When the buffer is full the record is dropped and counted instead of blocking
+ * the caller; the writer then logs how many records were lost.
+ */
+class Logger
+{
+public:
+    static void log(const std::string& message);
+    static void log(LogLevel level, std::string message);
+    static void flush();
+
+    static void setMinimumLevel(LogLevel level);
+    static uint64_t droppedCount();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    struct Record
+    {
+        std::atomic<uint64_t> sequence{0};
+        LogLevel level = LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+        std::string directory;  // The working directory when it was logged
+    };
+
+    Logger();
+    static Logger& instance();
+
+    bool push(LogLevel level, std::string&& message);
+    void writerLoop();
+    std::size_t drain(std::string& batch, std::string& directory);
+
+    static const std::size_t capacity = 8192;
+
+    std::unique_ptr<Record[]> records_;
+    alignas(64) std::atomic<uint64_t> enqueuePosition_{0};
+    alignas(64) uint64_t dequeuePosition_ = 0;
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<int> minimumLevel_{static_cast<int>(LogLevel::Debug)};
+    std::atomic<bool> writerSleeping_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    std::thread writer_;
+};
+
+#endif // LOGGER_H
@@ -0,0 +1,271 @@
+#include <lzcodec.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const std::size_t minMatch = 4;
+const std::size_t maxOffset = 65535;
+// Matches never start in the last 12 bytes nor end in the last 5, like LZ4
+const std::size_t matchStartMargin = 12;
+const std::size_t matchEndMargin = 5;
+const unsigned hashBits = 16;
+const uint32_t noPosition = 0xffffffffU;
+const unsigned highSearchDepth = 64;
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash4(const unsigned char* p) {
+    return (read32(p) * 2654435761U) >> (32 - hashBits);
+}
+
+void writeLength(std::vector<char>& output, std::size_t length) {
+    while (length >= 255) {
+        output.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+void emitSequence(std::vector<char>& output, const unsigned char* literals, std::size_t literalLength,
+                  std::size_t offset, std::size_t matchLength) {
+    std::size_t tokenPosition = output.size();
+    output.push_back(0);
+    unsigned token = 0;
+
+    if (literalLength >= 15) {
+        token = 15 << 4;
+        writeLength(output, literalLength - 15);
+    } else {
+        token = static_cast<unsigned>(literalLength) << 4;
+    }
+    output.insert(output.end(), literals, literals + literalLength);
+
+    if (matchLength > 0) {
+        output.push_back(static_cast<char>(offset & 0xff));
+        output.push_back(static_cast<char>(offset >> 8));
+        std::size_t extra = matchLength - minMatch;
+        if (extra >= 15) {
+            token |= 15;
+            writeLength(output, extra - 15);
+        } else {
+            token |= static_cast<unsigned>(extra);
+        }
+    }
+    output[tokenPosition] = static_cast<char>(token);
+}
+
+}
+
+namespace LzCodec {
+
+/**
+ * @brief Compresses a block.
+ * @param input The raw bytes.
+ * @param size Number of raw bytes.
+ * @param level Fast or High (None is treated as Fast).
+ * @param output Receives the compressed block (it may be larger than the input).
+ */
+void compressBlock(const char* input, std::size_t size, Compression level, std::vector<char>& output) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(input);
+    output.clear();
+    output.reserve(size + size / 255 + 16);
+
+    std::size_t anchor = 0;
+    if (size > matchStartMargin) {
+        const bool high = level == Compression::High;
+        std::vector<uint32_t> table(std::size_t(1) << hashBits, noPosition);
+        std::vector<uint32_t> chain(high ? maxOffset + 1 : 0, noPosition);
+        const std::size_t limit = size - matchStartMargin;
+        const std::size_t matchEnd = size - matchEndMargin;
+
+        auto insert = [&](std::size_t position) {
+            uint32_t h = hash4(in + position);
+            if (high) {
+                chain[position & maxOffset] = table[h];
+            }
+            table[h] = static_cast<uint32_t>(position);
+        };
+
+        std::size_t position = 0;
+        while (position < limit) {
+            uint32_t h = hash4(in + position);
+            std::size_t bestLength = 0;
+            std::size_t bestCandidate = 0;
+
+            uint32_t candidate = table[h];
+            unsigned depth = high ? highSearchDepth : 1;
+            while (candidate != noPosition && depth-- > 0 && position - candidate <= maxOffset) {
+                if (read32(in + candidate) == read32(in + position)) {
+                    std::size_t length = minMatch;
+                    while (position + length < matchEnd && in[candidate + length] == in[position + length]) {
+                        ++length;
+                    }
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestCandidate = candidate;
+                    }
+                }
+                if (!high) {
+                    break;
+                }
+                uint32_t next = chain[candidate & maxOffset];
+                if (next == noPosition || next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+            insert(position);
+
+            if (bestLength == 0) {
+                // Skip faster through data that does not compress
+                position += high ? 1 : 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            std::size_t start = position;
+            while (start > anchor && bestCandidate > 0 && in[start - 1] == in[bestCandidate - 1]) {
+                --start;
+                --bestCandidate;
+                ++bestLength;
+            }
+            emitSequence(output, in + anchor, start - anchor, start - bestCandidate, bestLength);
+
+            std::size_t end = start + bestLength;
+            if (high) {
+                for (std::size_t p = position + 1; p < end && p < limit; ++p) {
+                    insert(p);
+                }
+            } else if (end - 2 < limit) {
+                insert(end - 2);
+            }
+            position = end;
+            anchor = end;
+        }
+    }
+    emitSequence(output, in + anchor, size - anchor, 0, 0);
+}
+
+/**
+ * @brief Decompresses a block, checking every length and offset against the buffers.
+ * @param input The compressed block.
+ * @param size Size of the compressed block.
+ * @param output Receives exactly rawSize bytes.
+ * @param rawSize Size of the raw block.
+ * @return bool - false if the block is corrupted.
+ */
+bool decompressBlock(const char* input, std::size_t size, char* output, std::size_t rawSize) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(input);
+    const unsigned char* const end = ip + size;
+    char* op = output;
+    char* const outputEnd = output + rawSize;
+
+    auto readLength = [&](std::size_t& length) {
+        unsigned char byte;
+        do {
+            if (ip >= end) {
+                return false;
+            }
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (ip < end) {
+        unsigned token = *ip++;
+        std::size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(literalLength)) {
+            return false;
+        }
+        if (literalLength > static_cast<std::size_t>(end - ip) || literalLength > static_cast<std::size_t>(outputEnd - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == end) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        std::size_t offset = ip[0] | static_cast<std::size_t>(ip[1]) << 8;
+        ip += 2;
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength)) {
+            return false;
+        }
+        matchLength += minMatch;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - output)
+            || matchLength > static_cast<std::size_t>(outputEnd - op)) {
+            return false;
+        }
+
+        const char* match = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(op, match, matchLength);
+            op += matchLength;
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            for (std::size_t i = 0; i < matchLength; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return op == outputEnd;
+}
+
+/**
+ * @brief Returns the name of a compression level, as accepted by parseLevel().
+ * @param level The level.
+ * @return const char* - Its name.
+ */
+const char* levelName(Compression level) {
+    switch (level) {
+    case Compression::None:
+        return "none";
+    case Compression::Fast:
+        return "fast";
+    case Compression::High:
+        return "high";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Parses a compression level name.
+ * @param name One of none, fast or high.
+ * @param level Receives the level.
+ * @return bool - false if the name is unknown.
+ */
+bool parseLevel(const std::string& name, Compression& level) {
+    for (Compression candidate : {Compression::None, Compression::Fast, Compression::High}) {
+        if (name == levelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the level selected by the MINIGIT_COMPRESSION environment variable.
+ * @return Compression - Fast when the variable is not set or not valid.
+ */
+Compression levelFromEnvironment() {
+    Compression level = Compression::Fast;
+    const char* value = std::getenv("MINIGIT_COMPRESSION");
+    if (value != nullptr) {
+        parseLevel(value, level);
+    }
+    return level;
+}
+
+}
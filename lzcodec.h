@@ -0,0 +1,40 @@
+#ifndef LZCODEC_H
+#define LZCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compression applied to stored objects.
+ *
+ * Fast is an LZ4-class codec (one hash probe per position), High searches hash chains for
+ * longer matches: it compresses slower for a better ratio but decompresses just as fast.
+ */
+enum class Compression {
+    None,
+    Fast,
+    High
+};
+
+/**
+ * @brief LZ77 block codec using the LZ4 sequence layout.
+ *
+ * A block is a list of sequences: a token (literal length in the high nibble, match
+ * length - 4 in the low nibble, 15 meaning "more length bytes follow"), the literals, a
+ * 16-bit little-endian match offset and the extra match length bytes. The last sequence
+ * only has literals.
+ */
+namespace LzCodec {
+
+void compressBlock(const char* input, std::size_t size, Compression level, std::vector<char>& output);
+bool decompressBlock(const char* input, std::size_t size, char* output, std::size_t rawSize);
+
+const char* levelName(Compression level);
+bool parseLevel(const std::string& name, Compression& level);
+Compression levelFromEnvironment();
+
+}
+
+#endif // LZCODEC_H
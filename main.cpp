@@ -1,11 +1,34 @@
 #include "mainwindow.h"
+#include "stats.h"
 
 #include <QApplication>
 
+#include <cstring>
+#include <iostream>
+
 int main(int argc, char *argv[])
 {
+    // --stats prints what every operation of the session cost and keeps it in .git/stats.json
+    bool printStats = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stats") == 0) {
+            printStats = true;
+        }
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
-    return a.exec();
+    int result = a.exec();
+
+    if (printStats) {
+        std::vector<Stats::OperationReport> reports = Stats::reports();
+        std::cout << Stats::formatText(reports);
+        try {
+            Stats::writeJson(".git/stats.json", reports);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+    return result;
 }
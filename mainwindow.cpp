@@ -2,21 +2,171 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "miniversioncontrol.h"
+#include "pathlistmodel.h"
 
 #include <QDir>
 #include <QMessageBox>
+#include <QtConcurrent>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+
+// The progress is redrawn at about 30 frames per second
+const int progressInterval = 33;
+
+// In watch mode, how often the lists are refreshed if the working tree changed
+const int watchInterval = 250;
+
+QString progressText(const Progress::Snapshot& progress)
+{
+    QString text = QString("%1 / %2%3 files, %4 MiB")
+        .arg(progress.filesDone)
+        .arg(progress.filesTotal)
+        .arg(QString(progress.totalKnown ? "" : "+"))
+        .arg(progress.bytesDone / 1048576.0, 0, 'f', 1);
+    if (progress.remainingSeconds >= 0) {
+        text += QString(", about %1 s left").arg(progress.remainingSeconds, 0, 'f', 0);
+    }
+    return text;
+}
+
+}
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow), vcs(new MiniVersionControl) {
     ui->setupUi(this);
     ui->terminal->setReadOnly(true);
+
+    filesModel = new PathListModel(this);
+    stagedModel = new PathListModel(this);
+    versionsModel = new PathListModel(this);
+    versionsModel->setNumbered(true);
+    versionsModel->setOrder(&MiniVersionControl::olderVersion);
+    ui->filesList->setModel(filesModel);
+    ui->addedFiles->setModel(stagedModel);
+    ui->versionsList->setModel(versionsModel);
+    connect(ui->versionsList->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &MainWindow::versionChanged);
+
+    progressTimer.setInterval(progressInterval);
+    connect(&progressTimer, &QTimer::timeout, this, &MainWindow::updateProgress);
+    connect(&operationWatcher, &QFutureWatcher<QString>::finished, this, &MainWindow::operationDone);
+
+    watchTimer.setInterval(watchInterval);
+    connect(&watchTimer, &QTimer::timeout, this, &MainWindow::refreshIfChanged);
+    startWatching();
 }
 
 MainWindow::~MainWindow()
 {
+    // Stop a running operation cleanly before the repository goes away
+    if (operationWatcher.isRunning()) {
+        vcs->progress().cancel();
+        operationWatcher.waitForFinished();
+    }
+    vcs->stopWatching();
     delete ui;
 }
 
 
+// Starts a repository operation on a worker thread; `finished` then runs on the UI thread.
+void MainWindow::runOperation(const QString& name, std::function<void()> work, std::function<void()> finished)
+{
+    operationName = name;
+    operationFinished = std::move(finished);
+    operationTime.start();
+    setOperationRunning(true);
+
+    operationWatcher.setFuture(QtConcurrent::run([work]() -> QString {
+        try {
+            work();
+            return QString();
+        } catch (const OperationCancelled&) {
+            return QString("Cancelled, the files done so far are kept.");
+        } catch (const std::exception& e) {
+            return QString("Failed: ") + QString::fromStdString(e.what());
+        }
+    }));
+}
+
+
+// Only one operation runs at a time: everything else touching the repository waits for it.
+void MainWindow::setOperationRunning(bool running)
+{
+    ui->initButton->setEnabled(!running);
+    ui->addButton->setEnabled(!running);
+    ui->commitButton->setEnabled(!running);
+    ui->revert->setEnabled(!running);
+    ui->deleteButton->setEnabled(!running);
+    ui->pushButton->setEnabled(!running);
+    ui->pushButton_2->setEnabled(!running);
+    ui->reloadVersions->setEnabled(!running);
+    ui->statusButton->setEnabled(!running);
+    ui->cancelButton->setEnabled(running);
+
+    if (running) {
+        ui->progressBar->setValue(0);
+        progressTimer.start();
+    } else {
+        progressTimer.stop();
+    }
+}
+
+
+void MainWindow::updateProgress()
+{
+    Progress::Snapshot progress = vcs->progress().snapshot();
+    if (progress.totalKnown) {
+        ui->progressBar->setMaximum(1000);
+        ui->progressBar->setValue(static_cast<int>(progress.fraction() * 1000));
+    } else {
+        // Busy indicator until the walk has counted every file
+        ui->progressBar->setMaximum(0);
+    }
+    ui->statusbar->showMessage(operationName + ": " + progressText(progress));
+}
+
+
+void MainWindow::operationDone()
+{
+    setOperationRunning(false);
+    Progress::Snapshot progress = vcs->progress().snapshot();
+    ui->progressBar->setMaximum(1000);
+    ui->progressBar->setValue(ui->progressBar->maximum());
+    ui->statusbar->clearMessage();
+
+    QString error = operationWatcher.result();
+    QString summary = QString("%1 files, %2 MiB in %3 s")
+        .arg(progress.filesDone)
+        .arg(progress.bytesDone / 1048576.0, 0, 'f', 1)
+        .arg(operationTime.elapsed() / 1000.0, 0, 'f', 1);
+    if (error.isEmpty()) {
+        this->logUserAction(operationName + " completed: " + summary + ".");
+    } else {
+        this->logUserAction(operationName + " " + error + " (" + summary + ")");
+    }
+
+    // The lists are refreshed even after a failure: part of the work may be done
+    std::function<void()> finished = std::move(operationFinished);
+    operationFinished = nullptr;
+    if (finished) {
+        finished();
+    }
+}
+
+
+void MainWindow::on_cancelButton_clicked()
+{
+    if (operationWatcher.isRunning()) {
+        this->logUserAction("Cancelling " + operationName + "...");
+        ui->cancelButton->setEnabled(false);
+        vcs->progress().cancel();
+    }
+}
+
+
 void MainWindow::on_initButton_clicked()
 {
     this->logUserAction(QString("Initiating your Repository..."));
@@ -25,25 +175,47 @@ void MainWindow::on_initButton_clicked()
     // ...
     MainWindow::vcs->init();
     this->logUserAction(QString("Initiation Stage Completed."));
+    startWatching();
 }
 
 
-// Handlers for special buttons
-void MainWindow::on_addButton_clicked()
+void MainWindow::startWatching()
 {
-    this->logUserAction("Adding Selected Elements...");
+    if (!qEnvironmentVariableIsSet("MINIGIT_WATCH") || watchTimer.isActive()) {
+        return;
+    }
+    if (vcs->startWatching()) {
+        this->logUserAction(QString("Watching the working tree for changes."));
+        watchTimer.start();
+    }
+}
 
-    for (const QString& selectedFile : this->selectedFiles)
-    {
-        std::string filePath = selectedFile.toStdString();
-        this->vcs->add(filePath);
 
+// The watcher counts the changes it sees: nothing to list again while the count stays the same.
+void MainWindow::refreshIfChanged()
+{
+    uint64_t changes = vcs->changeCount();
+    if (changes == seenChanges || operationWatcher.isRunning()) {
+        return;
     }
-
-    this->logUserAction("Adding Stage Completed.");
+    seenChanges = changes;
     MainWindow::on_pushButton_pressed();
     MainWindow::on_pushButton_2_clicked();
+}
+
+
+// Handlers for special buttons
+void MainWindow::on_addButton_clicked()
+{
+    this->logUserAction("Adding Selected Elements...");
 
+    // One batch: the index is loaded and saved once for the whole selection
+    std::vector<std::string> filePaths = filesModel->selectedEntries();
+
+    runOperation("Adding", [this, filePaths] { this->vcs->add(filePaths); }, [this] {
+        MainWindow::on_pushButton_pressed();
+        MainWindow::on_pushButton_2_clicked();
+    });
 }
 
 
@@ -61,117 +233,98 @@ void MainWindow::on_commitButton_clicked()
     this->logUserAction(QString("Your Changes are Being Commited..."));
     //QMessageBox::information(this, "Add Files", "Selected Files:\n" + selectedFiles.join("\n"));
 
-    this->vcs->commit("Mahmoud/Amine/Imane");
-
-    this->logUserAction(QString("Your Changes Have succesfully been commited."));
-
-    MainWindow::on_pushButton_pressed();
-    MainWindow::on_pushButton_2_clicked();
-    // MainWindow::on_reloadVersions_pressed();
+    runOperation("Commit", [this] { this->vcs->commit("Mahmoud/Amine/Imane"); }, [this] {
+        MainWindow::on_pushButton_pressed();
+        MainWindow::on_pushButton_2_clicked();
+        // MainWindow::on_reloadVersions_pressed();
+    });
 }
 
 
 
-//
+// Lists are diffed against what is shown: only new and removed names touch the view.
+// The status tags describe the files as they were: they are dropped.
 void MainWindow::on_pushButton_pressed()
 {
-    ui->filesList->clear();
-
-    std::vector<std::string> vec =  this->vcs->listFilesAndFolders();
-
-    for(auto x : vec){
-        QString itemText =  QString::fromStdString(x); // Example text: "Item 1", "Item 2", ...
-        QListWidgetItem *newItem = new QListWidgetItem(itemText);
+    filesModel->setEntries(this->vcs->listFilesAndFolders());
+    filesModel->setTags({});
+}
 
-        // You can set additional properties or customize the item here if needed
 
-        ui->filesList->addItem(newItem);
-    }
+// Tags every listed name with its state, or with what changed below it for a directory.
+void MainWindow::on_statusButton_clicked()
+{
+    this->logUserAction("Comparing your files with the staging area and the last version...");
+
+    auto statuses = std::make_shared<std::vector<FileStatus>>();
+    runOperation("Status", [this, statuses] { *statuses = this->vcs->status(); }, [this, statuses] {
+        std::map<std::string, std::map<FileState, int>> changes;
+        std::map<FileState, int> totals;
+        std::unordered_map<std::string, std::string> tags;
+        for (const FileStatus& status : *statuses) {
+            if (status.state == FileState::Unchanged) {
+                continue;
+            }
+            ++totals[status.state];
+            std::string name = status.path.substr(0, status.path.find('/'));
+            if (name == status.path) {
+                tags[name] = FileStatus::stateName(status.state);
+            } else {
+                ++changes[name][status.state];
+            }
+        }
+        for (const auto& item : changes) {
+            std::string tag;
+            for (const auto& count : item.second) {
+                tag += (tag.empty() ? "" : ", ") + std::to_string(count.second) + " " + FileStatus::stateName(count.first);
+            }
+            tags[item.first] = tag;
+        }
 
+        MainWindow::on_pushButton_pressed();
+        filesModel->setTags(std::move(tags));
 
+        QString summary;
+        for (const auto& total : totals) {
+            summary += QString(summary.isEmpty() ? "" : ", ") + QString::number(total.second) + " "
+                + FileStatus::stateName(total.first);
+        }
+        this->logUserAction(summary.isEmpty() ? QString("Nothing changed.") : summary + ".");
+    });
 }
 
 
 void MainWindow::on_reloadVersions_pressed()
 {
-    ui->versionsList->clear();
-
-    std::vector<std::string> vec =  this->vcs->listVersions();
-    int i = 1;
-    for(auto x : vec){
-        std::string res = x;
-        res = res + " - Version: " + std::to_string(i);
-        QString itemText =  QString::fromStdString(res); // Example text: "Item 1", "Item 2", ...
-        QListWidgetItem *newItem = new QListWidgetItem(itemText);
-
-        ui->versionsList->addItem(newItem);
-        i++;
-    }
+    versionsModel->setEntries(this->vcs->listVersions());
 }
 
 
 
 // This function changes the selected Version.
-void MainWindow::on_versionsList_currentItemChanged(QListWidgetItem *current, QListWidgetItem *previous)
+void MainWindow::versionChanged(const QModelIndex &current)
 {
-
-    // Set some attribute (i.e currVerison : To the version id)
-    // QString s = current->text();
-
-    current->setBackground(QBrush(Qt::yellow));
-    isSelectedVersion = true;
-    version = current->text();
-
-
-    // Set The visuals for the previous element.
-    if(previous != NULL){
-        previous->setBackground(QBrush(Qt::white));
+    if(!current.isValid()){
+        isSelectedVersion = false;
+        return;
     }
+    isSelectedVersion = true;
+    version = QString::fromStdString(versionsModel->entry(current.row()));
 }
 
 
-// This function adds all items in the filesList to the selectedFiles structure.
+// This function selects every file of the working tree, fetched by the view or not.
 void MainWindow::on_selectAll_clicked()
 {
-    QListWidget *filesList = ui->filesList;
-    this->selectedFiles.clear();
-
-
-    for (int i = 0; i < filesList->count(); ++i)
-    {
-        QListWidgetItem *item = filesList->item(i);
-        if (item != nullptr)
-        {
-            // Add it to the list (it's name).
-            this->selectedFiles.insert(item->text());
-            item->setBackground(QBrush(Qt::yellow));
-        }
-    }
-
+    filesModel->selectAll();
 }
 
 
-// This method Handles adding Selected files to the selectedFiles QSet<QString> object.
+// This method toggles the selection of a file (to be added).
 //====================================================
-void MainWindow::on_filesList_itemClicked(QListWidgetItem *item)
+void MainWindow::on_filesList_clicked(const QModelIndex &index)
 {
-
-    // this->logUserAction( QString("Clicked."));
-
-    if(item->background() == QBrush(Qt::yellow)){
-        // Remove the coloring.
-        // remove the element from the list of elements to be commited.
-        this->selectedFiles.remove(item->text());
-        item->setBackground(QBrush(Qt::white));
-
-    }else{
-        // Add the coloring.
-        this->selectedFiles.insert(item->text());
-        item->setBackground(QBrush(Qt::yellow));
-        // append it to the commit list.
-    }
-
-    //item->setBackground(QBrush(Qt::yellow));
+    filesModel->toggleSelected(index.row());
 }
 
 
@@ -192,38 +345,22 @@ void MainWindow::on_revert_clicked()
     this->logUserAction("Reverting to selected Version...");
 
     if(this->isSelectedVersion){
-        this->vcs->revert(".git/commits/" + this->version.toStdString().substr(0, 10));
+        std::string commitFolder = ".git/commits/" + this->version.toStdString();
+        runOperation("Revert", [this, commitFolder] { this->vcs->revert(commitFolder); }, [this] {
+            MainWindow::on_pushButton_pressed();
+        });
     }
     else{
         this->logUserAction("No Version chosen.");
         return;
     }
 
-    this->logUserAction("Completed.");
-
 }
 
 
-void MainWindow::on_addedFiles_itemClicked(QListWidgetItem *item)
+void MainWindow::on_addedFiles_clicked(const QModelIndex &index)
 {
-
-    //this->logUserAction( QString("Clicked."));
-
-    if(item->background() == QBrush(Qt::yellow)){
-        // Remove the coloring.
-        // remove the element from the list of elements to be commited.
-        this->selectedFilesAdd.remove(item->text());
-        item->setBackground(QBrush(Qt::white));
-
-    }else{
-        // Add the coloring.
-        this->selectedFilesAdd.insert(item->text());
-        item->setBackground(QBrush(Qt::yellow));
-        // append it to the commit list.
-    }
-
-    //item->setBackground(QBrush(Qt::yellow));
-
+    stagedModel->toggleSelected(index.row());
 }
 
 
@@ -231,44 +368,15 @@ void MainWindow::on_addedFiles_itemClicked(QListWidgetItem *item)
 
 void MainWindow::on_pushButton_2_clicked()
 {
-    ui->addedFiles->clear();
-
-    std::vector<std::string> vec =  this->vcs->listStagingArea();
-
-    //this->logUserAction("vsvwxvbwfgw");
-
-    for(auto x : vec){
-        QString itemText =  QString::fromStdString(x); // Example text: "Item 1", "Item 2", ...
-        QListWidgetItem *newItem = new QListWidgetItem(itemText);
-
-        // You can set additional properties or customize the item here if needed
-
-        ui->addedFiles->addItem(newItem);
-    }
+    stagedModel->setEntries(this->vcs->listStagingArea());
 }
 
 
 void MainWindow::on_deleteButton_pressed()
 {
-    ui->addedFiles->clear();
-
-    QSet<QString> vec =  this->selectedFilesAdd;
-    for(auto x : vec){
-        std::string filename = x.toStdString();
+    for(const std::string& filename : stagedModel->selectedEntries()){
         this->vcs->deleteFromStaging(filename);
     }
 
-
     MainWindow::on_pushButton_2_clicked();
 }
-
-
-
-
-
-
-
-
-
-
-
@@ -5,8 +5,12 @@
 #include <miniversioncontrol.h>
 
 #include <QMainWindow>
-#include <QListWidgetItem>
-#include <QSet>
+#include <QModelIndex>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QTimer>
+
+#include <functional>
 
 
 
@@ -14,6 +18,8 @@ namespace Ui {
 class MainWindow;
 }
 
+class PathListModel;
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -34,14 +40,19 @@ private slots:
     void on_commitButton_clicked();
     void on_pushButton_pressed();
     void on_reloadVersions_pressed();
-    void on_versionsList_currentItemChanged(QListWidgetItem *current, QListWidgetItem *previous);
+    void versionChanged(const QModelIndex &current);
     void on_selectAll_clicked();
-    void on_filesList_itemClicked(QListWidgetItem *item);
+    void on_filesList_clicked(const QModelIndex &index);
     void logUserAction(const QString &action);
     void on_revert_clicked();
-    void on_addedFiles_itemClicked(QListWidgetItem *item);
+    void on_addedFiles_clicked(const QModelIndex &index);
     void on_pushButton_2_clicked();
     void on_deleteButton_pressed();
+    void on_cancelButton_clicked();
+    void on_statusButton_clicked();
+    void updateProgress();
+    void operationDone();
+    void refreshIfChanged();
 
 
 
@@ -50,9 +61,10 @@ private:
     // The UI object.
     Ui::MainWindow *ui;
 
-    // List of file names that are selected (to be added for next Commit/ Or to be deleted).
-    QSet<QString> selectedFiles;
-    QSet<QString> selectedFilesAdd;
+    // Working tree, staging area and versions; each model holds the selection of its list.
+    PathListModel *filesModel;
+    PathListModel *stagedModel;
+    PathListModel *versionsModel;
 
 
     bool isSelectedVersion = false;
@@ -64,6 +76,21 @@ private:
 
     void updateFileList();
     void updateVersionList();
+
+    // Long operations run on a worker thread; the UI thread only polls their progress.
+    void runOperation(const QString& name, std::function<void()> work, std::function<void()> finished);
+    void setOperationRunning(bool running);
+
+    QFutureWatcher<QString> operationWatcher; // Empty result on success, the error otherwise
+    QTimer progressTimer;
+    QElapsedTimer operationTime;
+    QString operationName;
+    std::function<void()> operationFinished;
+
+    // With MINIGIT_WATCH set the working tree is watched and the lists follow its changes.
+    void startWatching();
+    QTimer watchTimer;
+    uint64_t seenChanges = 0;
 };
 
 #endif // MAINWINDOW_H
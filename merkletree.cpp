@@ -0,0 +1,201 @@
+#include <merkletree.h>
+#include <widehash.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const std::string treeHeader = "minigit-tree 1\n";
+
+std::string serialize(std::vector<TreeItem>& items) {
+    std::sort(items.begin(), items.end(), [](const TreeItem& a, const TreeItem& b) { return a.name < b.name; });
+    std::string content = treeHeader;
+    for (const TreeItem& item : items) {
+        content += item.directory ? "tree " : "blob ";
+        content += item.id;
+        content += ' ';
+        content += item.name;
+        content += '\n';
+    }
+    return content;
+}
+
+/**
+ * Builds the tree of the files in [first, last), which all start with prefix and are
+ * sorted, so that every subdirectory is a contiguous range.
+ */
+std::string buildRange(const ObjectStore& objects, const std::vector<TreeFile>& files, std::size_t first,
+                       std::size_t last, std::size_t prefixSize, std::size_t* written) {
+    std::vector<TreeItem> items;
+    for (std::size_t i = first; i < last;) {
+        const std::string& path = files[i].first;
+        std::size_t slash = path.find('/', prefixSize);
+        TreeItem item;
+        if (slash == std::string::npos) {
+            item.name = path.substr(prefixSize);
+            item.id = files[i].second;
+            ++i;
+        } else {
+            item.directory = true;
+            item.name = path.substr(prefixSize, slash - prefixSize);
+            std::size_t childPrefix = slash + 1;
+            std::size_t end = i + 1;
+            while (end < last && files[end].first.compare(0, childPrefix, path, 0, childPrefix) == 0) {
+                ++end;
+            }
+            item.id = buildRange(objects, files, i, end, childPrefix, written);
+            i = end;
+        }
+        items.push_back(std::move(item));
+    }
+
+    std::string content = serialize(items);
+    WideHasher hasher;
+    hasher.update(content.data(), content.size());
+    std::string id = hasher.finish().hex();
+    if (!objects.contains(id)) {
+        std::istringstream input(content);
+        if (objects.writeBlob(input) != id) {
+            throw std::runtime_error("Tree object id mismatch");
+        }
+        if (written != nullptr) {
+            ++*written;
+        }
+    }
+    return id;
+}
+
+void listInto(const ObjectStore& objects, const std::string& id, const std::string& prefix,
+              std::vector<TreeFile>& files, bool& complete) {
+    std::vector<TreeItem> items;
+    if (!MerkleTree::read(objects, id, items)) {
+        complete = false;
+        return;
+    }
+    for (const TreeItem& item : items) {
+        if (item.directory) {
+            listInto(objects, item.id, prefix + item.name + "/", files, complete);
+        } else {
+            files.emplace_back(prefix + item.name, item.id);
+        }
+    }
+}
+
+}
+
+/**
+ * @brief Stores the trees of a set of files.
+ * @param objects The store receiving the trees; the file contents must already be in it.
+ * @param files The files of the version, paths relative to its root.
+ * @param written Incremented for every tree that was not stored yet.
+ * @return std::string - The id of the root tree.
+ */
+std::string MerkleTree::build(const ObjectStore& objects, std::vector<TreeFile> files, std::size_t* written) {
+    std::sort(files.begin(), files.end());
+    return buildRange(objects, files, 0, files.size(), 0, written);
+}
+
+/**
+ * @brief Reads the entries of a tree object.
+ * @return bool - false if the object is missing, corrupted or not a tree.
+ */
+bool MerkleTree::read(const ObjectStore& objects, const std::string& id, std::vector<TreeItem>& items) {
+    std::vector<char> content;
+    if (!objects.readObject(id, content)) {
+        return false;
+    }
+    std::string text(content.begin(), content.end());
+    if (text.compare(0, treeHeader.size(), treeHeader) != 0) {
+        return false;
+    }
+
+    items.clear();
+    std::size_t position = treeHeader.size();
+    while (position < text.size()) {
+        std::size_t end = text.find('\n', position);
+        std::size_t firstSpace = text.find(' ', position);
+        std::size_t secondSpace = firstSpace == std::string::npos ? firstSpace : text.find(' ', firstSpace + 1);
+        if (end == std::string::npos || secondSpace == std::string::npos || secondSpace > end) {
+            return false;
+        }
+        TreeItem item;
+        item.directory = text.compare(position, firstSpace - position, "tree") == 0;
+        item.id = text.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+        item.name = text.substr(secondSpace + 1, end - secondSpace - 1);
+        items.push_back(std::move(item));
+        position = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Lists every file under a tree.
+ * @return bool - false if a tree is missing or corrupted (files holds what could be read).
+ */
+bool MerkleTree::list(const ObjectStore& objects, const std::string& id, std::vector<TreeFile>& files) {
+    bool complete = true;
+    listInto(objects, id, "", files, complete);
+    return complete;
+}
+
+/**
+ * @brief Reports the files that differ between two trees.
+ *
+ * Subtrees with the same id on both sides are skipped without being read, so the cost
+ * follows the number of directories on the changed paths.
+ * @param oldId The old root tree.
+ * @param newId The new root tree.
+ * @param changed Called with the path and both ids; an empty id means the file is absent.
+ * @return bool - false if a tree is missing or corrupted.
+ */
+bool MerkleTree::compare(const ObjectStore& objects, const std::string& oldId, const std::string& newId,
+                         const std::function<void(const std::string&, const std::string&, const std::string&)>& changed) {
+    struct Pending
+    {
+        std::string prefix;
+        std::string oldId;
+        std::string newId;
+    };
+    std::vector<Pending> pending{{"", oldId, newId}};
+    while (!pending.empty()) {
+        Pending trees = std::move(pending.back());
+        pending.pop_back();
+        if (trees.oldId == trees.newId) {
+            continue;
+        }
+
+        std::vector<TreeItem> oldItems;
+        std::vector<TreeItem> newItems;
+        if ((!trees.oldId.empty() && !read(objects, trees.oldId, oldItems))
+            || (!trees.newId.empty() && !read(objects, trees.newId, newItems))) {
+            return false;
+        }
+
+        // Both lists are sorted by name
+        std::vector<Pending> subtrees;
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < oldItems.size() || j < newItems.size()) {
+            bool takeOld = j == newItems.size() || (i < oldItems.size() && oldItems[i].name <= newItems[j].name);
+            bool takeNew = i == oldItems.size() || (j < newItems.size() && newItems[j].name <= oldItems[i].name);
+            const TreeItem* oldItem = takeOld ? &oldItems[i++] : nullptr;
+            const TreeItem* newItem = takeNew ? &newItems[j++] : nullptr;
+            std::string path = trees.prefix + (oldItem != nullptr ? oldItem->name : newItem->name);
+
+            std::string oldFile = oldItem != nullptr && !oldItem->directory ? oldItem->id : std::string();
+            std::string newFile = newItem != nullptr && !newItem->directory ? newItem->id : std::string();
+            std::string oldTree = oldItem != nullptr && oldItem->directory ? oldItem->id : std::string();
+            std::string newTree = newItem != nullptr && newItem->directory ? newItem->id : std::string();
+            if (oldFile != newFile) {
+                changed(path, oldFile, newFile);
+            }
+            if (oldTree != newTree) {
+                subtrees.push_back({path + "/", oldTree, newTree});
+            }
+        }
+        pending.insert(pending.end(), std::make_move_iterator(subtrees.rbegin()), std::make_move_iterator(subtrees.rend()));
+    }
+    return true;
+}
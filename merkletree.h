@@ -0,0 +1,43 @@
+#ifndef MERKLETREE_H
+#define MERKLETREE_H
+
+#include <objectstore.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief One entry of a tree object: a file (blob) or a directory (tree) and its id.
+ */
+struct TreeItem
+{
+    bool directory = false;
+    std::string id;
+    std::string name;
+};
+
+// A file of a version: its path relative to the repository root and its content id
+using TreeFile = std::pair<std::string, std::string>;
+
+/**
+ * @brief Directory hashes of a version, stored as objects.
+ *
+ * A tree object lists the entries of one directory, sorted by name, one per line:
+ * "blob <id> <name>" or "tree <id> <name>", after a "minigit-tree 1" header. Its id is
+ * the id of that text, so a directory whose files did not change has the same id in
+ * every version: its tree is stored once, and comparing two versions skips it without
+ * looking inside. build() only writes the trees the store does not have yet.
+ */
+namespace MerkleTree {
+
+std::string build(const ObjectStore& objects, std::vector<TreeFile> files, std::size_t* written = nullptr);
+bool read(const ObjectStore& objects, const std::string& id, std::vector<TreeItem>& items);
+bool list(const ObjectStore& objects, const std::string& id, std::vector<TreeFile>& files);
+bool compare(const ObjectStore& objects, const std::string& oldId, const std::string& newId,
+             const std::function<void(const std::string& path, const std::string& oldId, const std::string& newId)>& changed);
+
+}
+
+#endif // MERKLETREE_H
@@ -11,7 +11,22 @@
 #include <mutex>
 #include <vector>
 #include <cstring>
-#include <future>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <memory>
+#include <map>
+#include <cstdlib>
+#include <tuple>
+
+#include <dirscanner.h>
+#include <ignorerules.h>
+#include <linediff.h>
+#include <logger.h>
+#include <merkletree.h>
+#include <stats.h>
+#include <threadpool.h>
 
 namespace fs = std::filesystem;
 using namespace std::chrono;
@@ -19,47 +34,309 @@ using namespace std::chrono;
 /**
  * @brief MiniVersionControl class constructor.
  */
-MiniVersionControl::MiniVersionControl() {
+MiniVersionControl::MiniVersionControl() : objects_(".git/objects"), index_(".git/index") {
     // Constructor;
 }
 
 namespace fs = std::filesystem;
 
 /**
- * @brief Logger class for logging messages to a file.
+ * @brief Reads a small file (such as a staged reference) into a string.
+ * @param path The file to read.
+ * @param maxSize Files larger than this are not read.
+ * @param content Receives the file content.
+ * @return bool - true if the file was read.
+ */
+bool readSmallFile(const fs::path& path, std::uintmax_t maxSize, std::string& content) {
+    std::error_code ec;
+    std::uintmax_t size = fs::file_size(path, ec);
+    if (ec || size > maxSize) {
+        return false;
+    }
+    std::ifstream inputFile(path, std::ios::binary);
+    if (!inputFile.is_open()) {
+        return false;
+    }
+    content.resize(static_cast<std::size_t>(size));
+    inputFile.read(&content[0], static_cast<std::streamsize>(size));
+    return static_cast<std::uintmax_t>(inputFile.gcount()) == size;
+}
+
+/**
+ * @brief Copies a directory tree, the files being copied in parallel on the shared thread pool.
+ *
+ * Nothing is overwritten: a file that already exists in the destination fails the copy.
+ * @param source The directory to copy.
+ * @param destination The directory receiving the copy.
  */
-class Logger {
-public:
-    /**
-     * @brief Logs a message to a file with a timestamp.
-     * @param message The message to be logged.
-     */
-    static void log(const std::string& message) {
-        std::ofstream logFile("log.txt", std::ios::app);
-        if (logFile.is_open()) {
-            auto timestamp = system_clock::to_time_t(system_clock::now());
-            std::tm timeinfo = *std::localtime(&timestamp);
-            logFile << "[" << std::put_time(&timeinfo, "%d/%m/%Y %H:%M") << "]" << message << "\n";
-            logFile.close();
+void copyTree(const fs::path& source, const fs::path& destination) {
+    PathTable table;
+    DirScanner::scan(source, table);
+    const std::string sourcePrefix = source.string() + "/";
+    const std::string destinationPrefix = destination.string() + "/";
+    std::string target;
+    TaskGroup group;
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        target = destinationPrefix;
+        table.appendPath(i, target);
+        if (table[i].directory) {
+            fs::create_directories(target);
+        } else {
+            std::string file = sourcePrefix;
+            table.appendPath(i, file);
+            group.run([file = std::move(file), target] {
+                fs::copy_file(file, target, fs::copy_options::none);
+            });
         }
     }
+    group.wait();
+}
+
+// Files compared per status() task
+const std::size_t statusBatch = 256;
+
+// Files diffed in parallel before their output is written, in path order
+const std::size_t diffBatch = 64;
+
+// Walked files are added and reverted ioBatch at a time; those of up to batchFileSize bytes
+// are read and written together through BatchIo
+const std::size_t ioBatch = 128;
+const uint64_t batchFileSize = 64 << 10;
+
+// Committed references are at most this long, longer files are legacy full copies
+const std::size_t maxReferenceSize = 256;
+
+// Marks a batched file whose content is not read
+const std::size_t notRead = static_cast<std::size_t>(-1);
+
+// Ends the names of the files revert writes next to their destinations; walks of the
+// working tree skip them, so one left behind by an interrupted revert is not a file of the tree
+const std::string revertSuffix = ".revert_tmp";
+
+/**
+ * @brief Whether a name is one of a revert temporary file.
+ */
+bool isRevertTemporary(std::string_view name) {
+    return name.size() >= revertSuffix.size()
+        && name.compare(name.size() - revertSuffix.size(), revertSuffix.size(), revertSuffix) == 0;
+}
+
+/**
+ * @brief A file met by status() in the working tree, the staging area or a commit.
+ */
+struct TreeEntry
+{
+    std::string path;                      // Relative to the tree root
+    std::shared_ptr<const fs::path> root;  // Walked trees only
+    FileStat stat;                         // Working tree files
+    std::string id;                        // Stored files; empty for a full copy written by older versions
+
+    fs::path file() const { return *root / path; }
 };
 
 /**
- * @brief Computes a checksum for a given string using the FNV-1a hash algorithm.
- * @param str The string for which the checksum is calculated.
- * @return uint32_t - The computed checksum.
+ * @brief Lists the files of a tree, one task per top-level entry.
+ *
+ * Each top-level directory is walked once into its own PathTable; the file paths are
+ * built from it into a reused buffer to read the stat data or the reference.
+ * @param root The working tree, the staging area or a commit.
+ * @param working Whether to read stat data (working tree) or references (stored trees).
+ * @param skipped Top-level names that are not part of the tree.
+ * @param group Runs the walks; each one fills its own part.
+ * @param parts Receives one list per top-level entry.
+ * @param rules The ignore rules of the working tree, nullptr to keep everything.
  */
-uint32_t computeChecksum(const std::string& str) {
-    const uint32_t prime = 16777619;
-    uint32_t hash = 2166136261U;
+void collectTree(const fs::path& root, bool working, const std::vector<std::string>& skipped, TaskGroup& group,
+                 std::deque<std::vector<TreeEntry>>& parts, const IgnoreRules* rules = nullptr) {
+    auto treeRoot = std::make_shared<const fs::path>(root);
+    auto describe = [working, treeRoot](const char* file, std::string path) {
+        TreeEntry entry;
+        entry.path = std::move(path);
+        entry.root = treeRoot;
+        if (working) {
+            FileStat::read(file, entry.stat);
+            Stats::add(Stats::Counter::FilesScanned);
+        } else {
+            std::string reference;
+            if (readSmallFile(file, maxReferenceSize, reference)) {
+                ObjectStore::parseReference(reference, entry.id);
+            }
+        }
+        return entry;
+    };
 
-    for (char ch : str) {
-        hash ^= static_cast<uint32_t>(ch);
-        hash *= prime;
+    const IgnoreRules::State start = rules != nullptr ? rules->start() : IgnoreRules::none;
+    for (DirScanner::Entry& top : DirScanner::list(root)) {
+        std::string name = std::move(top.name);
+        if (std::find(skipped.begin(), skipped.end(), name) != skipped.end()) {
+            continue;
+        }
+        IgnoreFilter filter;
+        if (start != IgnoreRules::none) {
+            bool ignored;
+            filter.rules = rules;
+            filter.state = rules->descend(start, name, top.kind == DirScanner::Kind::Directory, ignored);
+            if (ignored) {
+                continue;
+            }
+        }
+        if (working && top.kind == DirScanner::Kind::File && isRevertTemporary(name)) {
+            continue;
+        }
+        std::vector<TreeEntry>& part = parts.emplace_back();
+        if (top.kind == DirScanner::Kind::File) {
+            part.push_back(describe((root / name).string().c_str(), name));
+        } else if (top.kind == DirScanner::Kind::Directory) {
+            group.run([&part, describe, working, directory = root / name, name, filter] {
+                Stats::ScopedTimer timer(Stats::Phase::Traversal);
+                PathTable table;
+                DirScanner::scan(directory, table, nullptr, filter);
+                const std::string prefix = directory.string() + "/";
+                std::string file;
+                for (uint32_t i = 0; i < table.size(); ++i) {
+                    if (table[i].directory || (working && isRevertTemporary(table.name(i)))) {
+                        continue;
+                    }
+                    file = prefix;
+                    table.appendPath(i, file);
+                    std::string path = name + "/";
+                    table.appendPath(i, path);
+                    part.push_back(describe(file.c_str(), std::move(path)));
+                }
+            });
+        }
+    }
+}
+
+/**
+ * @brief Finds the newest commit; commit folders are named after their timestamp in seconds.
+ * @return fs::path - The commit folder, empty if there is no commit.
+ */
+fs::path latestCommit() {
+    std::string latest;
+    for (const auto& entry : fs::directory_iterator(".git/commits")) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_directory() && (latest.empty() || MiniVersionControl::olderVersion(latest, name))) {
+            latest = name;
+        }
     }
+    return latest.empty() ? fs::path() : fs::path(".git/commits") / latest;
+}
 
-    return hash;
+/**
+ * @brief Reads the root tree recorded by a commit.
+ * @param commitFolder The commit folder.
+ * @param id Receives the id of its root tree.
+ * @return bool - false for commits made before trees were recorded.
+ */
+bool commitTree(const fs::path& commitFolder, std::string& id) {
+    // The tree is written last, after a message that may span lines
+    std::ifstream input(commitFolder / "commit_info.txt");
+    std::string line;
+    id.clear();
+    while (std::getline(input, line)) {
+        if (line.compare(0, 6, "Tree: ") == 0) {
+            id = line.substr(6);
+        }
+    }
+    return !id.empty();
+}
+
+/**
+ * @brief Lists the files of a commit from its trees, or by walking its folder for older commits.
+ */
+void collectCommit(const ObjectStore& objects, const fs::path& commitFolder, TaskGroup& group,
+                   std::deque<std::vector<TreeEntry>>& parts) {
+    std::string tree;
+    std::vector<TreeFile> files;
+    if (commitTree(commitFolder, tree) && MerkleTree::list(objects, tree, files)) {
+        std::vector<TreeEntry>& part = parts.emplace_back();
+        part.reserve(files.size());
+        for (TreeFile& file : files) {
+            part.push_back(TreeEntry{std::move(file.first), nullptr, FileStat(), std::move(file.second)});
+        }
+        return;
+    }
+    collectTree(commitFolder, false, {"commit_info.txt"}, group, parts);
+}
+
+/**
+ * @brief Computes the stat index key of a staging area path.
+ * @param destination A path inside .git/staging.
+ * @param key Receives the path relative to the staging area.
+ * @return bool - false if the path is not inside the staging area.
+ */
+bool stagingKey(const fs::path& destination, std::string& key) {
+    fs::path relative = destination.lexically_normal().lexically_relative(".git/staging");
+    if (relative.empty() || *relative.begin() == "..") {
+        return false;
+    }
+    key = relative.generic_string();
+    return true;
+}
+
+/**
+ * @brief Computes the stat index key of a working tree path.
+ * @param file A path inside the current directory.
+ * @param key Receives the path relative to the current directory, as used in the staging area.
+ * @return bool - false if the path is outside the current directory.
+ */
+bool workingKey(const fs::path& file, std::string& key) {
+    fs::path relative = file.lexically_normal().lexically_relative(fs::current_path());
+    if (relative.empty() || *relative.begin() == "..") {
+        return false;
+    }
+    key = relative.generic_string();
+    return true;
+}
+
+/**
+ * @brief Finds where a working tree directory is in the ignore rules.
+ * @param rules The rules of the repository root.
+ * @param directory A directory inside the current directory.
+ * @return IgnoreFilter - The filter to walk it with; inactive outside the working tree.
+ */
+IgnoreFilter ignoreFilter(const IgnoreRules& rules, const fs::path& directory) {
+    IgnoreFilter filter;
+    std::string key;
+    if (rules.size() == 0 || !workingKey(fs::absolute(directory), key)) {
+        return filter;
+    }
+    filter.rules = &rules;
+    filter.state = rules.start();
+    std::size_t begin = 0;
+    while (begin < key.size() && filter.state != IgnoreRules::none) {
+        std::size_t slash = std::min(key.find('/', begin), key.size());
+        std::string_view name(key.data() + begin, slash - begin);
+        begin = slash + 1;
+        if (name != ".") {
+            // The directory itself was named explicitly: only what it holds is filtered
+            bool ignored;
+            filter.state = rules.descend(filter.state, name, true, ignored);
+        }
+    }
+    return filter;
+}
+
+/**
+ * @brief Returns the time elapsed since a point, for the Stats phase timers.
+ */
+uint64_t nanosecondsSince(steady_clock::time_point start) {
+    return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+}
+
+/**
+ * @brief Replaces a file by another one, even where rename cannot overwrite.
+ * @param source The file to move.
+ * @param destination The file to replace.
+ */
+void replaceFile(const fs::path& source, const fs::path& destination) {
+    std::error_code ec;
+    fs::rename(source, destination, ec);
+    if (ec) {
+        fs::remove(destination, ec);
+        fs::rename(source, destination);
+    }
 }
 
 /**
@@ -70,6 +347,7 @@ void MiniVersionControl::init() {
         fs::create_directory(".git");
         fs::create_directory(".git/commits");
         fs::create_directory(".git/staging");
+        objects_.init();
     } catch (const std::exception& e) {
         Logger::log("Error during initialization: " + std::string(e.what()));
         throw;
@@ -81,92 +359,446 @@ void MiniVersionControl::init() {
  * @param path The path of the file or directory to be added.
  */
 void MiniVersionControl::add(const std::string& path) {
+    add(std::vector<std::string>{path});
+}
+
+/**
+ * @brief Adds many files and directories to the staging area as one batch.
+ *
+ * The index is loaded and saved once and every file of the batch is stored on the same
+ * task group, so a long list of paths costs about as much as one directory holding them.
+ * Paths are staged under their file name: when several share one, the last one wins.
+ * What .minigitignore matches inside the directories is skipped; the paths themselves
+ * are added even if it matches them.
+ * @param paths The paths of the files or directories to be added.
+ */
+void MiniVersionControl::add(const std::vector<std::string>& paths) {
+    Stats::Operation operation("add");
+    auto lock = Stats::timedLock(mutex_);
+    progress_.start();
+
     try {
-        const auto copyOptions = fs::copy_options::overwrite_existing | fs::copy_options::recursive;
-        // Add a specific file or directory to the staging area
-        std::string destinationPath = ".git/staging/" + fs::path(path).filename().string();
-        if (fs::exists(destinationPath)) {
-            try {
-                fs::remove_all(destinationPath);
-            } catch (const std::exception& e) {
-                Logger::log("Error removing existing file or directory: " + std::string(e.what()));
-                throw;
+        // Later paths replace earlier ones with the same name, as separate adds would
+        std::vector<std::string> batch;
+        std::vector<std::string> keys;
+        std::unordered_set<std::string> seen;
+        for (auto it = paths.rbegin(); it != paths.rend(); ++it) {
+            // "dir/" is staged as "dir"
+            fs::path named = fs::path(*it).lexically_normal();
+            if (!named.has_filename()) {
+                named = named.parent_path();
+            }
+            std::string key = named.filename().string();
+            if (key.empty() || key == "." || key == "..") {
+                Logger::log("Error: Invalid file or directory path: " + *it);
+                continue;
+            }
+            if (seen.insert(key).second) {
+                keys.push_back(key);
+                batch.push_back(*it);
             }
         }
+        std::reverse(batch.begin(), batch.end());
+        std::reverse(keys.begin(), keys.end());
 
-        if (fs::is_regular_file(path)) {
-            addFile(path, destinationPath);
-        } else if (fs::is_directory(path)) {
-            addDirectory(path, destinationPath);
-        } else {
-            Logger::log("Error: Invalid file or directory path.");
+        loadIgnoreRules();
+        index_.load();
+        uint32_t visit = index_.startVisit();
+        std::vector<std::string> directories;
+        TaskGroup group;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            // Add a specific file or directory to the staging area
+            const std::string& path = batch[i];
+            const std::string& key = keys[i];
+            std::string destinationPath = ".git/staging/" + key;
+
+            // Staged copies are kept and refreshed in place using the stat index; only what
+            // the index does not describe (or a file/directory type change) is removed first
+            if (fs::exists(destinationPath)) {
+                bool replaceAll = fs::is_directory(destinationPath)
+                    ? !fs::is_directory(path) || !index_.hasStagedUnder(key)
+                    : fs::is_directory(path);
+                if (replaceAll) {
+                    try {
+                        fs::remove_all(destinationPath);
+                        index_.unstage(key);
+                    } catch (const std::exception& e) {
+                        Logger::log("Error removing existing file or directory: " + std::string(e.what()));
+                        throw;
+                    }
+                }
+            }
+
+            progress_.throwIfCancelled();
+            if (fs::is_regular_file(path)) {
+                progress_.addQueued();
+                group.run([this, path, destinationPath] { addFile(path, destinationPath); });
+            } else if (fs::is_directory(path)) {
+                scheduleDirectory(path, destinationPath, group);
+                directories.push_back(key);
+            } else {
+                Logger::log("Error: Invalid file or directory path: " + path);
+            }
+        }
+        progress_.finishQueueing();
+        group.wait();
+
+        // Files that disappeared from the source directories since they were staged
+        for (const std::string& key : directories) {
+            for (const std::string& stale : index_.unvisitedStagedUnder(key, visit)) {
+                std::error_code ec;
+                fs::remove(".git/staging/" + stale, ec);
+                index_.unstage(stale);
+            }
         }
+        index_.save();
+    } catch (const OperationCancelled&) {
+        // Keep what was staged before the cancellation; stale files are removed by the next add
+        index_.save();
+        Logger::log(LogLevel::Info, "Add cancelled");
+        throw;
     } catch (const std::exception& e) {
         Logger::log("Error adding file or directory: " + std::string(e.what()));
         throw;
     }
 }
 
+/**
+ * @brief Stages what changed in the tracked paths since they were last added.
+ *
+ * The tracked paths are the top-level names the stat index knows, so only files added
+ * from the repository root are followed. With a watcher running (startWatching(), or
+ * "minigit watch" in another process) only the paths it reported are looked at and the
+ * cost follows the number of changes. Otherwise, or when the watcher lost events, the
+ * tracked paths are walked once, reading no file whose stat data did not change.
+ */
+void MiniVersionControl::addChanged() {
+    Stats::Operation operation("add");
+    auto lock = Stats::timedLock(mutex_);
+    progress_.start();
+
+    try {
+        loadIgnoreRules();
+        index_.load();
+        ChangeTracker::Changes changes = tracker_.pendingChanges();
+        std::vector<std::string> roots = index_.roots();
+        std::unordered_set<std::string> tracked(roots.begin(), roots.end());
+
+        std::vector<std::string> candidates;
+        if (changes.complete) {
+            for (const std::string& path : changes.paths) {
+                if (tracked.count(path.substr(0, path.find('/'))) && !ignore_.ignored(path, fs::is_directory(path))) {
+                    candidates.push_back(path);
+                }
+            }
+        } else {
+            // A missing top-level name may have been added from elsewhere: only walk what exists
+            Logger::log(LogLevel::Info, "No complete change list, rescanning the tracked paths");
+            for (const std::string& root : roots) {
+                if (fs::exists(root)) {
+                    candidates.push_back(root);
+                }
+            }
+        }
+
+        // A directory is walked whole: drop the changes below it so no file is added twice
+        std::unordered_set<std::string> walked;
+        for (const std::string& path : candidates) {
+            if (fs::is_directory(path)) {
+                walked.insert(path);
+            }
+        }
+        auto insideWalked = [&walked](const std::string& path) {
+            for (std::size_t slash = path.rfind('/'); slash != std::string::npos && slash > 0;
+                 slash = path.rfind('/', slash - 1)) {
+                if (walked.count(path.substr(0, slash))) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        uint32_t visit = index_.startVisit();
+        std::vector<std::string> directories;
+        TaskGroup group;
+        for (const std::string& path : candidates) {
+            progress_.throwIfCancelled();
+            if (insideWalked(path)) {
+                continue;
+            }
+            std::string destinationPath = ".git/staging/" + path;
+            if (fs::is_regular_file(path)) {
+                fs::create_directories(fs::path(destinationPath).parent_path());
+                progress_.addQueued();
+                group.run([this, path, destinationPath] { addFile(path, destinationPath, true); });
+            } else if (fs::is_directory(path)) {
+                fs::create_directories(fs::path(destinationPath).parent_path());
+                scheduleDirectory(path, destinationPath, group, true);
+                directories.push_back(path);
+            } else if (!fs::exists(path)) {
+                std::error_code ec;
+                fs::remove_all(destinationPath, ec);
+                index_.unstage(path);
+            }
+        }
+        progress_.finishQueueing();
+        group.wait();
+
+        for (const std::string& key : directories) {
+            for (const std::string& stale : index_.unvisitedStagedUnder(key, visit)) {
+                std::error_code ec;
+                fs::remove(".git/staging/" + stale, ec);
+                index_.unstage(stale);
+            }
+        }
+        index_.save();
+        // Also after a rescan: it covered every change the watcher saw until now
+        tracker_.acknowledge(changes);
+    } catch (const OperationCancelled&) {
+        index_.save();
+        Logger::log(LogLevel::Info, "Add cancelled");
+        throw;
+    } catch (const std::exception& e) {
+        Logger::log("Error adding changed files: " + std::string(e.what()));
+        throw;
+    }
+}
+
 /**
  * @brief Recursively adds files from a source directory to the staging area.
  * @param source The source directory.
  * @param destination The destination directory in the staging area.
  */
 void MiniVersionControl::addDirectory(const fs::path& source, const fs::path& destination) {
-    // Process directories recursively
-    fs::create_directory(destination);
-    for (const auto& entry : fs::recursive_directory_iterator(source)) {
-        fs::path nestedDestination = destination / entry.path().lexically_relative(source);
+    TaskGroup group;
+    scheduleDirectory(source, destination, group);
+    group.wait();
+}
+
+/**
+ * @brief Walks a source directory and schedules its files on a task group.
+ *
+ * The tree is walked once into a PathTable, which the batches share: directories are
+ * created from it first (parents always come first) and files are stored in parallel on
+ * the shared thread pool, in batches of table indices (see addBatch()).
+ * @param source The source directory.
+ * @param destination The destination directory in the staging area.
+ * @param group Runs the file tasks; the caller waits for it.
+ * @param onlyChanged Passed to addFile().
+ */
+void MiniVersionControl::scheduleDirectory(const fs::path& source, const fs::path& destination, TaskGroup& group,
+                                           bool onlyChanged) {
+    auto tree = std::make_shared<WalkedTree>();
+    tree->source = source.string() + "/";
+    tree->destination = destination.string() + "/";
+    if (stagingKey(destination, tree->keyPrefix)) {
+        tree->keyPrefix += '/';
+    }
+
+    std::vector<uint32_t> files;
+    {
+        Stats::ScopedTimer timer(Stats::Phase::Traversal);
+        DirScanner::scan(source, tree->table, [this] { progress_.throwIfCancelled(); },
+                         ignoreFilter(ignore_, source));
+        fs::create_directory(destination);
+        std::string directory;
+        for (uint32_t i = 0; i < tree->table.size(); ++i) {
+            if (tree->table[i].directory) {
+                directory = tree->destination;
+                tree->table.appendPath(i, directory);
+                fs::create_directory(directory);
+            } else if (!isRevertTemporary(tree->table.name(i))) {
+                files.push_back(i);
+            }
+        }
+    }
+
+    for (std::size_t first = 0; first < files.size(); first += ioBatch) {
+        progress_.throwIfCancelled();
+        std::vector<uint32_t> batch(files.begin() + first, files.begin() + std::min(files.size(), first + ioBatch));
+        progress_.addQueued(batch.size());
+        group.run([this, tree, batch = std::move(batch), onlyChanged, &group] {
+            addBatch(*tree, batch, onlyChanged, group);
+        });
+    }
+}
+
+/**
+ * @brief Adds a batch of files to the staging area, reading and writing the small ones together.
+ *
+ * The paths of the batch are built once from the table into two PathLists. The stat
+ * index is looked up first; the files it does not describe are read with one BatchIo call
+ * and stored, then the reference files of the batch are written with a second one. Files
+ * larger than batchFileSize go to addFile() on the task group, as does any file a batched
+ * step failed for (or that is not in the staging area): addFile() reports the error.
+ * @param tree The walked directory.
+ * @param files The table indices of the files.
+ * @param onlyChanged Passed to addFile().
+ * @param group The task group running the batch.
+ */
+void MiniVersionControl::addBatch(const WalkedTree& tree, const std::vector<uint32_t>& files, bool onlyChanged,
+                                  TaskGroup& group) {
+    struct Added
+    {
+        std::size_t file = 0;
+        FileStat stat;
+        std::string id;
+        std::string previousId;
+        std::size_t read = notRead;
+    };
+    PathList sources;
+    PathList destinations;
+    for (uint32_t file : files) {
+        sources.add(tree.source, tree.table, file);
+        destinations.add(tree.destination, tree.table, file);
+    }
+    // Keys are rebuilt into the same buffer each time they are needed
+    std::string key;
+    auto makeKey = [&tree, &files, &key](std::size_t i) -> const std::string& {
+        key = tree.keyPrefix;
+        tree.table.appendPath(files[i], key);
+        return key;
+    };
+    auto addAlone = [this, &sources, &destinations, onlyChanged, &group](std::size_t i) {
+        group.run([this, source = fs::path(sources[i]), destination = fs::path(destinations[i]), onlyChanged] {
+            addFile(source, destination, onlyChanged);
+        });
+    };
 
-        if (entry.is_regular_file()) {
-            MiniVersionControl::addFile(entry.path(), nestedDestination);
-        } else if (entry.is_directory()) {
-            addDirectory(entry.path(), nestedDestination);
+    try {
+        std::vector<Added> added;
+        std::vector<FileRequest> reads;
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            progress_.throwIfCancelled();
+            Added entry;
+            entry.file = i;
+            if (tree.keyPrefix.empty() || !FileStat::read(sources[i], entry.stat) || entry.stat.size > batchFileSize) {
+                addAlone(i);
+                continue;
+            }
+            Stats::add(Stats::Counter::FilesScanned);
+            StatIndex::Match match = index_.lookup(makeKey(i), entry.stat, entry.id);
+            if (match == StatIndex::Match::Staged || (onlyChanged && match == StatIndex::Match::Hashed)) {
+                progress_.addDone(entry.stat.size);
+                continue;
+            }
+            if (match == StatIndex::Match::Unknown) {
+                index_.recordedId(key, entry.previousId);
+                // One byte more than expected tells a file that grew since it was measured
+                FileRequest read;
+                read.path = sources[i];
+                read.data.resize(static_cast<std::size_t>(entry.stat.size) + 1);
+                entry.read = reads.size();
+                reads.push_back(std::move(read));
+            }
+            added.push_back(std::move(entry));
         }
+        BatchIo::readFiles(reads, ioEngine_);
+
+        std::vector<Added> referenced;
+        std::vector<FileRequest> references;
+        for (Added& entry : added) {
+            if (entry.read != notRead) {
+                std::vector<char>& content = reads[entry.read].data;
+                if (!reads[entry.read].done || content.size() != entry.stat.size) {
+                    addAlone(entry.file);
+                    continue;
+                }
+                entry.id = objects_.writeContent(content.data(), content.size(), entry.previousId);
+                std::vector<char>().swap(content);
+                if (onlyChanged && !entry.previousId.empty() && entry.id == entry.previousId) {
+                    // Touched but not changed
+                    index_.refresh(makeKey(entry.file), entry.stat, entry.id);
+                    progress_.addDone(entry.stat.size);
+                    continue;
+                }
+            }
+            std::string reference = ObjectStore::makeReference(entry.id);
+            FileRequest write;
+            write.path = destinations[entry.file];
+            write.data.assign(reference.begin(), reference.end());
+            references.push_back(std::move(write));
+            referenced.push_back(std::move(entry));
+        }
+        BatchIo::writeFiles(references, ioEngine_);
+
+        for (std::size_t i = 0; i < referenced.size(); ++i) {
+            const Added& entry = referenced[i];
+            if (!references[i].done) {
+                addAlone(entry.file);
+                continue;
+            }
+            index_.record(makeKey(entry.file), entry.stat, entry.id, true);
+            progress_.addDone(entry.stat.size);
+        }
+    } catch (const OperationCancelled&) {
+        throw;
+    } catch (const std::exception& e) {
+        Logger::log("Error adding files: " + std::string(e.what()));
+        throw;
     }
 }
 
 /**
  * @brief Adds a file to the staging area.
+ *
+ * The file is streamed into the object store, which keeps a single copy of each
+ * content. The staging area only receives a small reference file pointing to it.
  * @param source The source file.
  * @param destination The destination file in the staging area.
+ * @param onlyChanged Skip the file when its content is the one last recorded for it, even
+ * if that content is no longer staged.
  */
-void MiniVersionControl::addFile(const fs::path& source, const fs::path& destination) {
+void MiniVersionControl::addFile(const fs::path& source, const fs::path& destination, bool onlyChanged) {
     try {
+        // Files whose stat data did not change since they were hashed are not read again
+        progress_.throwIfCancelled();
+        Stats::add(Stats::Counter::FilesScanned);
+        std::string key;
+        FileStat stat;
+        bool indexed = stagingKey(destination, key) && FileStat::read(source, stat);
+        std::string id;
+        StatIndex::Match match = indexed ? index_.lookup(key, stat, id) : StatIndex::Match::Unknown;
+        if (match == StatIndex::Match::Staged || (onlyChanged && match == StatIndex::Match::Hashed)) {
+            progress_.addDone(stat.size);
+            return;
+        }
 
-        std::lock_guard<std::mutex> lock(MiniVersionControl::mutex_);
-
-        std::ifstream inputFile(source, std::ios::binary);
-        if (!inputFile.is_open()) {
-            std::string errorMessage = "Error opening source file: " + source.string();
-            Logger::log(errorMessage);
-            throw std::runtime_error(errorMessage);
+        if (match == StatIndex::Match::Unknown) {
+            // The content last recorded for this path is the base of a delta, if one pays off.
+            // No lock needed: objects are installed atomically and each destination is unique
+            std::string previousId;
+            if (indexed) {
+                index_.recordedId(key, previousId);
+            }
+            id = objects_.writeFile(source, previousId);
+            if (onlyChanged && !previousId.empty() && id == previousId) {
+                // Touched but not changed
+                index_.refresh(key, stat, id);
+                progress_.addDone(stat.size);
+                return;
+            }
         }
-        std::ostringstream contentBuffer;
-        // Add "1234" at the beginning
-        contentBuffer << "1234";
-        contentBuffer << inputFile.rdbuf();
-        inputFile.close();
-
-        // Calculate checksum
-        uint32_t checksum = computeChecksum(contentBuffer.str());
-        // Convert checksum to a 4-byte array
-        char checksumBytes[4];
-        std::memcpy(checksumBytes, &checksum, sizeof(checksum));
-        // Append checksum at the end of the content
-        contentBuffer.write(checksumBytes, sizeof(checksum));
+
+        Stats::ScopedTimer timer(Stats::Phase::Metadata);
         // Convert fs::path to std::string for the destination
         std::string destinationStr = destination.string();
-        // Write content to the destination file
+        // Write the reference to the destination file
         std::ofstream outputFile(destinationStr, std::ios::binary);
         if (!outputFile.is_open()) {
             std::string errorMessage = "Error opening destination file: " + destinationStr;
             Logger::log(errorMessage);
             throw std::runtime_error(errorMessage);
         }
-        // Write content to the destination file
-        outputFile << contentBuffer.str();
+        outputFile << ObjectStore::makeReference(id);
         outputFile.close();
+
+        if (indexed) {
+            index_.record(key, stat, id, true);
+        }
+        progress_.addDone(stat.size);
+    } catch (const OperationCancelled&) {
+        throw;
     } catch (const std::exception& e) {
         Logger::log("Error adding file: " + std::string(e.what()));
         throw;
@@ -178,38 +810,96 @@ void MiniVersionControl::addFile(const fs::path& source, const fs::path& destina
  * @param message The commit message.
  */
 void MiniVersionControl::commit(const std::string& message) {
+    Stats::Operation operation("commit");
+    auto lock = Stats::timedLock(mutex_);
+    progress_.start();
+    progress_.finishQueueing();
+
     try{
         if (fs::is_empty(".git/staging")) {
             Logger::log("Error: Staging area is empty. Nothing to commit.");
             return;
         }
 
-        // Create a unique folder for each commit using timestamp
+        // Hash the staged files into trees: only the directories that differ from every
+        // earlier version produce new tree objects. The references in the staging area
+        // are what the commit holds, so they are read rather than taken from the index.
+        // A full copy staged by older versions has no reference: what it restores to is stored
+        index_.load();
+        std::string tree;
+        {
+            Stats::ScopedTimer timer(Stats::Phase::Metadata);
+            std::deque<std::vector<TreeEntry>> parts;
+            {
+                TaskGroup group;
+                collectTree(".git/staging", false, {}, group, parts);
+                group.wait();
+                for (auto& part : parts) {
+                    for (TreeEntry& entry : part) {
+                        if (entry.id.empty()) {
+                            group.run([this, &entry] {
+                                fs::path temporary = objects_.createTemporary();
+                                try {
+                                    if (!objects_.restore(entry.file(), temporary)) {
+                                        throw std::runtime_error("Checksum validation failed for staged file: " + entry.path);
+                                    }
+                                    entry.id = objects_.writeFile(temporary);
+                                } catch (...) {
+                                    std::error_code ec;
+                                    fs::remove(temporary, ec);
+                                    throw;
+                                }
+                                std::error_code ec;
+                                fs::remove(temporary, ec);
+                            });
+                        }
+                    }
+                }
+                group.wait();
+            }
+            std::vector<TreeFile> files;
+            for (auto& part : parts) {
+                for (TreeEntry& entry : part) {
+                    files.emplace_back(std::move(entry.path), std::move(entry.id));
+                }
+            }
+            std::size_t written = 0;
+            tree = MerkleTree::build(objects_, std::move(files), &written);
+            Logger::log(LogLevel::Debug, "Commit tree " + tree + ", " + std::to_string(written) + " new trees");
+        }
+
+        // Create a unique folder for each commit using timestamp; later commits in the same
+        // second get "_2", "_3"... Creating the folder reserves its name, even against
+        // another process committing at the same time
         auto timestamp = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
         std::string commitFolder = ".git/commits/" + std::to_string(timestamp);
-        fs::create_directory(commitFolder);
-
-        // Move files from staging area to the commit folder
-        for (const auto& entry : fs::directory_iterator(".git/staging")) {
-            if (fs::is_directory(entry)) {
-                // Copy directories recursively
-                // TODO: Locks
-                fs::copy(entry, commitFolder / entry.path().filename(), fs::copy_options::recursive);
-            } else {
-                // Copy files as before
-                // TODO: Locks
-                fs::copy(entry, commitFolder / entry.path().filename());
-            }
+        for (unsigned suffix = 2; !fs::create_directory(commitFolder); ++suffix) {
+            commitFolder = ".git/commits/" + std::to_string(timestamp) + "_" + std::to_string(suffix);
+        }
+
+        // The staging area only holds references and is emptied by the commit, so it
+        // simply replaces the empty commit folder; copy it in parallel when it cannot be moved
+        std::error_code ec;
+        {
+            Stats::ScopedTimer timer(Stats::Phase::Metadata);
+            fs::rename(".git/staging", commitFolder, ec);
+        }
+        if (ec) {
+            Stats::ScopedTimer timer(Stats::Phase::Io);
+            copyTree(".git/staging", commitFolder);
+            fs::remove_all(".git/staging");
         }
 
         std::ofstream commitFile(commitFolder + "/commit_info.txt");
         commitFile << "Author: Fjer\n";
         commitFile << "Date: " << ctime(&timestamp);
         commitFile << "Message: " << message << "\n";
+        commitFile << "Tree: " << tree << "\n";
 
-        // Clear the staging area
-        fs::remove_all(".git/staging");
+        // Start a new, empty staging area
         fs::create_directory(".git/staging");
+        index_.unstageAll();
+        index_.save();
     }
     catch (const std::exception& e) {
         Logger::log("Error committing: " + std::string(e.what()));
@@ -219,11 +909,21 @@ void MiniVersionControl::commit(const std::string& message) {
 
 /**
  * @brief Reverts the files and directories in a specified commit to the previous state.
+ *
+ * Only the files that differ from the commit are rewritten (see revertFile()); the stat
+ * index remembers the files found or written with their committed content.
  * @param commitFolder The folder containing the commit to be reverted.
  */
 void MiniVersionControl::revert(const std::string& commitFolder) {
+    Stats::Operation operation("revert");
+    auto lock = Stats::timedLock(mutex_);
+    progress_.start();
+
     try {
+        index_.load();
+        TaskGroup group;
         for (const auto& entry : fs::directory_iterator(commitFolder)) {
+            progress_.throwIfCancelled();
             if (entry.is_regular_file() || entry.is_directory()) {
                 if (entry.path().filename() == "commit_info.txt") {
                     continue;
@@ -232,14 +932,26 @@ void MiniVersionControl::revert(const std::string& commitFolder) {
                 fs::path destinationPath = fs::current_path() / entry.path().filename();
 
                 if (fs::is_directory(entry)) {
-                    // Revert directories recursively
-                    revertDirectory(entry.path(), destinationPath);
+                    // Revert directories recursively, on the same group
+                    scheduleRevert(entry.path(), destinationPath, group);
                 } else {
                     // Revert individual files
-                    revertFile(entry.path(), destinationPath);
+                    progress_.addQueued();
+                    group.run([this, file = entry.path(), destinationPath] {
+                        revertFile(file, destinationPath);
+                    });
                 }
             }
         }
+        progress_.finishQueueing();
+        group.wait();
+        index_.save();
+    }
+    catch (const OperationCancelled&) {
+        // The files written so far hold committed content and are in the index
+        index_.save();
+        Logger::log(LogLevel::Info, "Revert cancelled");
+        throw;
     }
     catch (const std::exception& e) {
         Logger::log("Error reverting: " + std::string(e.what()));
@@ -253,21 +965,56 @@ void MiniVersionControl::revert(const std::string& commitFolder) {
  * @param destinationDir The destination directory where changes will be reverted.
  */
 void MiniVersionControl::revertDirectory(const fs::path& sourceDir, const fs::path& destinationDir) {
-    try{
-        fs::create_directories(destinationDir);
+    TaskGroup group;
+    scheduleRevert(sourceDir, destinationDir, group);
+    group.wait();
+}
 
-        for (const auto& entry : fs::directory_iterator(sourceDir)) {
-            const fs::path entryPath = entry.path();
-            const fs::path destinationPath = destinationDir / entryPath.filename();
+/**
+ * @brief Walks a committed directory and schedules the revert of its files on a task group.
+ *
+ * The tree is walked once into a PathTable: sub-directories are created from it, then
+ * files are reverted in parallel on the shared thread pool, in batches of table indices
+ * (see revertBatch()).
+ * @param sourceDir The source directory to be reverted.
+ * @param destinationDir The destination directory where changes will be reverted.
+ * @param group Runs the file tasks; the caller waits for it.
+ */
+void MiniVersionControl::scheduleRevert(const fs::path& sourceDir, const fs::path& destinationDir, TaskGroup& group) {
+    try{
+        auto tree = std::make_shared<WalkedTree>();
+        tree->source = sourceDir.string() + "/";
+        tree->destination = destinationDir.string() + "/";
+        if (workingKey(destinationDir, tree->keyPrefix)) {
+            tree->keyPrefix += '/';
+        }
 
-            if (fs::is_directory(entryPath)) {
-                // Revert directories recursively
-                revertDirectory(entryPath, destinationPath);
-            } else {
-                // Revert individual files
-                revertFile(entryPath, destinationPath);
+        std::vector<uint32_t> files;
+        {
+            Stats::ScopedTimer timer(Stats::Phase::Traversal);
+            DirScanner::scan(sourceDir, tree->table, [this] { progress_.throwIfCancelled(); });
+            fs::create_directories(destinationDir);
+            std::string directory;
+            for (uint32_t i = 0; i < tree->table.size(); ++i) {
+                if (tree->table[i].directory) {
+                    directory = tree->destination;
+                    tree->table.appendPath(i, directory);
+                    fs::create_directories(directory);
+                } else {
+                    files.push_back(i);
+                }
             }
         }
+
+        for (std::size_t first = 0; first < files.size(); first += ioBatch) {
+            progress_.throwIfCancelled();
+            std::vector<uint32_t> batch(files.begin() + first, files.begin() + std::min(files.size(), first + ioBatch));
+            progress_.addQueued(batch.size());
+            group.run([this, tree, batch = std::move(batch), &group] { revertBatch(*tree, batch, group); });
+        }
+    }
+    catch (const OperationCancelled&) {
+        throw;
     }
     catch (const std::exception& e) {
         Logger::log("Error reverting directory: " + std::string(e.what()));
@@ -275,49 +1022,184 @@ void MiniVersionControl::revertDirectory(const fs::path& sourceDir, const fs::pa
     }
 }
 
+/**
+ * @brief Reverts a batch of committed files, reading and writing the small ones together.
+ *
+ * The paths of the batch are built once from the table into PathLists and the reference
+ * files are read with one BatchIo call. A working copy the stat index knows is checked
+ * without building a path object for it. The contents of the files whose working copy
+ * does not match are loaded (and verified) from the store and written next to their
+ * destinations with a second BatchIo call, then moved into place. Legacy full copies,
+ * contents larger than batchFileSize and any file a batched step failed for go to
+ * revertFile() on the task group.
+ * @param tree The walked commit directory.
+ * @param files The table indices of the files.
+ * @param group The task group running the batch.
+ */
+void MiniVersionControl::revertBatch(const WalkedTree& tree, const std::vector<uint32_t>& files, TaskGroup& group) {
+    struct Reverted
+    {
+        std::size_t file = 0;
+        std::string id;
+        uint64_t storedLength = 0;
+    };
+    PathList sources;
+    PathList destinations;
+    PathList temporaries;
+    std::string suffix;
+    for (uint32_t file : files) {
+        sources.add(tree.source, tree.table, file);
+        destinations.add(tree.destination, tree.table, file);
+        suffix = revertTemporarySuffix();
+        temporaries.add(tree.destination, tree.table, file, suffix.c_str());
+    }
+    std::string key;
+    auto makeKey = [&tree, &files, &key](std::size_t i) -> const std::string& {
+        key = tree.keyPrefix;
+        tree.table.appendPath(files[i], key);
+        return key;
+    };
+    auto revertAlone = [this, &sources, &destinations, &group](std::size_t i) {
+        group.run([this, source = fs::path(sources[i]), destination = fs::path(destinations[i])] {
+            revertFile(source, destination);
+        });
+    };
+
+    try {
+        progress_.throwIfCancelled();
+        std::vector<FileRequest> references(files.size());
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            references[i].path = sources[i];
+            references[i].data.resize(maxReferenceSize + 1);
+        }
+        BatchIo::readFiles(references, ioEngine_);
+
+        std::vector<Reverted> reverted;
+        std::vector<FileRequest> writes;
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            progress_.throwIfCancelled();
+            const std::vector<char>& data = references[i].data;
+            Reverted entry;
+            entry.file = i;
+            ObjectLocation stored;
+            if (!references[i].done || data.size() > maxReferenceSize || tree.keyPrefix.empty()
+                || !ObjectStore::parseReference(std::string(data.begin(), data.end()), entry.id)
+                || !objects_.locate(entry.id, stored)) {
+                revertAlone(i);
+                continue;
+            }
+            Stats::add(Stats::Counter::FilesScanned);
+
+            // The index answers for most working copies; the others are compared by content
+            FileStat stat;
+            std::string knownId;
+            bool exists = FileStat::read(destinations[i], stat);
+            StatIndex::Match match = exists ? index_.lookup(makeKey(i), stat, knownId) : StatIndex::Match::Unknown;
+            bool matches = match != StatIndex::Match::Unknown
+                ? knownId == entry.id
+                : exists && workingCopyMatches(fs::path(destinations[i]), key, stored, entry.id);
+            if (matches) {
+                progress_.addDone(stored.length);
+                continue;
+            }
+
+            FileRequest write;
+            if (!objects_.readObject(stored, batchFileSize, write.data)) {
+                revertAlone(i);
+                continue;
+            }
+            write.path = temporaries[i];
+            entry.storedLength = stored.length;
+            writes.push_back(std::move(write));
+            reverted.push_back(std::move(entry));
+        }
+        BatchIo::writeFiles(writes, ioEngine_);
+
+        for (std::size_t i = 0; i < reverted.size(); ++i) {
+            const Reverted& entry = reverted[i];
+            if (!writes[i].done) {
+                std::error_code ec;
+                fs::remove(writes[i].path, ec);
+                revertAlone(entry.file);
+                continue;
+            }
+            {
+                Stats::ScopedTimer timer(Stats::Phase::Metadata);
+                replaceFile(writes[i].path, destinations[entry.file]);
+            }
+            FileStat stat;
+            if (FileStat::read(destinations[entry.file], stat)) {
+                index_.refresh(makeKey(entry.file), stat, entry.id);
+            }
+            progress_.addDone(entry.storedLength);
+        }
+    } catch (const OperationCancelled&) {
+        throw;
+    } catch (const std::exception& e) {
+        Logger::log("Error reverting files: " + std::string(e.what()));
+        throw;
+    }
+}
+
 /**
  * @brief Reverts the contents of a file to a previous state.
+ *
+ * A destination that already holds the committed content is left untouched. Otherwise
+ * the stored file is streamed into a temporary file next to the destination while
+ * its checksum is verified; the destination is only replaced if the checksum matches.
  * @param source The source file to be reverted.
  * @param destination The destination file where changes will be reverted.
  */
 void MiniVersionControl::revertFile(const fs::path& source, const fs::path& destination) {
     try {
-        std::lock_guard<std::mutex> lock(MiniVersionControl::mutex_);
-
+        progress_.throwIfCancelled();
         if (fs::is_regular_file(source)) {
-            std::ifstream inputFile(source, std::ios::binary);
-            if (inputFile.is_open()) {
-                // Read file content into a buffer
-                std::ostringstream contentBuffer;
-                contentBuffer << inputFile.rdbuf();
-                inputFile.close();
-                // Calculate checksum for the content (excluding just the last 4 bytes)
-                uint32_t calculatedChecksum = computeChecksum(contentBuffer.str().substr(0, contentBuffer.str().size() - 4));
-                // Extract stored checksum from the last 4 bytes
-                uint32_t storedChecksum;
-                std::memcpy(&storedChecksum, contentBuffer.str().c_str() + contentBuffer.str().size() - 4, sizeof(storedChecksum));
-                // Compare checksums
-                if (calculatedChecksum != storedChecksum) {
-                    // Log an error and return without reverting
-                    Logger::log("Checksum validation failed for file: " + source.filename().string()+ " (skipping revert) some changes may have been lost.");
-                    return;
-                }
-                // Write the content back to the file (excluding just the last 4 bytes)
-                std::ofstream outputFile(destination, std::ios::binary);
-                if (!outputFile.is_open()) {
-                    std::string errorMessage = "Error opening destination file: " + destination.filename().string();
-                    Logger::log(errorMessage);
-                    throw std::runtime_error(errorMessage);
+            Stats::add(Stats::Counter::FilesScanned);
+            // Staged and committed files are references into the object store,
+            // older commits hold the full content directly
+            ObjectLocation stored;
+            stored.file = source;
+            std::string reference;
+            std::string id;
+            std::string key;
+            bool indexed;
+            {
+                Stats::ScopedTimer timer(Stats::Phase::Metadata);
+                stored.length = fs::file_size(source);
+                if (readSmallFile(source, maxReferenceSize, reference) && ObjectStore::parseReference(reference, id)) {
+                    // The object is read from its loose file or straight from its pack
+                    if (!objects_.locate(id, stored)) {
+                        std::string errorMessage = "Missing object " + id + " for file: " + source.string();
+                        Logger::log(errorMessage);
+                        throw std::runtime_error(errorMessage);
+                    }
                 }
+                indexed = !id.empty() && workingKey(destination, key);
+            }
+            if (indexed && workingCopyMatches(destination, key, stored, id)) {
+                progress_.addDone(stored.length);
+                return;
+            }
 
-                outputFile << contentBuffer.str().substr(4, contentBuffer.str().size() - 8);
-                outputFile.close();
-            } else {
-                std::string errorMessage = "Error opening source file: " + source.string();
-                Logger::log(errorMessage);
-                throw std::runtime_error(errorMessage);
+            fs::path temporary = destination;
+            temporary += revertTemporarySuffix();
+            if (!objects_.restore(stored, temporary)) {
+                // Log an error and return without reverting
+                Logger::log(LogLevel::Warning, "Checksum validation failed for file: " + source.filename().string()+ " (skipping revert) some changes may have been lost.");
+                progress_.addDone(stored.length);
+                return;
             }
+            Stats::ScopedTimer timer(Stats::Phase::Metadata);
+            replaceFile(temporary, destination);
+
+            FileStat stat;
+            if (indexed && FileStat::read(destination, stat)) {
+                index_.refresh(key, stat, id);
+            }
+            progress_.addDone(stored.length);
         }
+    } catch (const OperationCancelled&) {
+        throw;
     } catch (const std::exception& e) {
         Logger::log("Error reverting file: " + std::string(e.what()));
         throw;
@@ -326,22 +1208,75 @@ void MiniVersionControl::revertFile(const fs::path& source, const fs::path& dest
 
 
 /**
- * @brief Lists all files and directories in the current directory.
+ * @brief Checks whether a working file already holds a committed content.
+ *
+ * The stat index answers for files whose stat data did not change since they were last
+ * hashed; other files are compared by size, then hashed, and recorded in the index.
+ * @param file The working file.
+ * @param key Its stat index key.
+ * @param stored The stored object of the committed content.
+ * @param id The id of the committed content.
+ * @return bool - true if the file does not need to be rewritten.
+ */
+bool MiniVersionControl::workingCopyMatches(const fs::path& file, const std::string& key,
+                                            const ObjectLocation& stored, const std::string& id) {
+    FileStat stat;
+    if (!FileStat::read(file, stat)) {
+        return false;
+    }
+    std::string knownId;
+    if (index_.lookup(key, stat, knownId) != StatIndex::Match::Unknown) {
+        return knownId == id;
+    }
+
+    uint64_t size;
+    if (objects_.contentSize(stored, size) && size != stat.size) {
+        return false;
+    }
+    if (!fs::is_regular_file(file) || objects_.contentId(file) != id) {
+        return false;
+    }
+    index_.refresh(key, stat, id);
+    return true;
+}
+
+
+/**
+ * @brief Lists all files and directories in the current directory, but the ignored ones.
  * @return std::vector<std::string> - A vector of file and directory names.
  */
 std::vector<std::string> MiniVersionControl::listFilesAndFolders() {
     std::vector<std::string> res;
-    for (const auto& entry : fs::directory_iterator(".")) {
-        fs::path filePath = entry.path();
-        std::string filename = filePath.filename().string();
-        if (filename != "main.exe" && filename != ".git" && filename != "log.txt") {
-            res.push_back(filename);
+    IgnoreRules rules;
+    rules.load(".minigitignore");
+    for (DirScanner::Entry& entry : DirScanner::list(".")) {
+        if (entry.name != "main.exe" && entry.name != ".git" && entry.name != "log.txt"
+            && !isRevertTemporary(entry.name) && !rules.ignored(entry.name, entry.kind == DirScanner::Kind::Directory)) {
+            res.push_back(std::move(entry.name));
         }
     }
     return res;
 }
 
 
+/**
+ * @brief Returns the suffix of a file revert writes next to its destination before moving
+ * it into place. It is unique like the names of the store temporaries, so reverts running
+ * at once (the GUI and the CLI) never write the same file, nor a file of the commit.
+ */
+std::string MiniVersionControl::revertTemporarySuffix() const {
+    return "." + objects_.createTemporary().filename().string() + revertSuffix;
+}
+
+/**
+ * @brief Reads .minigitignore at the repository root; without one nothing is ignored.
+ */
+void MiniVersionControl::loadIgnoreRules() {
+    if (ignore_.load(".minigitignore")) {
+        Logger::log(LogLevel::Debug, "Ignore rules: " + std::to_string(ignore_.size()) + " patterns");
+    }
+}
+
 /**
  * @brief Lists all files and directories in the staging area.
  * @return std::vector<std::string> - A vector of file and directory names.
@@ -353,8 +1288,8 @@ std::vector<std::string> MiniVersionControl::listStagingArea() {
         const fs::path stagingPath = ".git/staging";
 
         if (fs::exists(stagingPath)) {
-            for (const auto& entry : fs::directory_iterator(stagingPath)) {
-                result.push_back(entry.path().filename().string());
+            for (DirScanner::Entry& entry : DirScanner::list(stagingPath)) {
+                result.push_back(std::move(entry.name));
             }
         } else {
             std::cerr << "Staging area not found." << std::endl;
@@ -367,6 +1302,395 @@ std::vector<std::string> MiniVersionControl::listStagingArea() {
 }
 
 
+/**
+ * @brief Compares the working tree with the staging area and the newest commit.
+ *
+ * The three trees are walked in parallel, one task per top-level entry, and the files
+ * present on both sides are compared in parallel batches. A working file is only read
+ * when the index has no id for its stat data and its size matches the stored content;
+ * files found equal that way go into the index so the next status does not read them.
+ * Like the staging area, it follows the files added from the repository root. Paths
+ * matched by .minigitignore are not walked nor reported.
+ * @return std::vector<FileStatus> - Every file of the three trees, sorted by path.
+ */
+std::vector<FileStatus> MiniVersionControl::status() {
+    Stats::Operation operation("status");
+    auto lock = Stats::timedLock(mutex_);
+    progress_.start();
+
+    try {
+        loadIgnoreRules();
+        index_.load();
+        std::deque<std::vector<TreeEntry>> working;
+        std::deque<std::vector<TreeEntry>> staged;
+        std::deque<std::vector<TreeEntry>> committed;
+        {
+            TaskGroup group;
+            collectTree(".", true, {".git", "log.txt", "main.exe"}, group, working, &ignore_);
+            if (fs::is_directory(".git/staging")) {
+                collectTree(".git/staging", false, {}, group, staged);
+            }
+            fs::path commit = latestCommit();
+            if (!commit.empty()) {
+                collectCommit(objects_, commit, group, committed);
+            }
+            group.wait();
+        }
+
+        struct Sides
+        {
+            const TreeEntry* working = nullptr;
+            const TreeEntry* staged = nullptr;
+            const TreeEntry* committed = nullptr;
+        };
+        std::unordered_map<std::string, Sides> paths;
+        for (const auto& part : working) {
+            for (const TreeEntry& entry : part) {
+                paths[entry.path].working = &entry;
+            }
+        }
+        for (const auto& part : staged) {
+            for (const TreeEntry& entry : part) {
+                paths[entry.path].staged = &entry;
+            }
+        }
+        for (const auto& part : committed) {
+            for (const TreeEntry& entry : part) {
+                paths[entry.path].committed = &entry;
+            }
+        }
+
+        // Only the files with a working copy and a stored one need a comparison
+        std::vector<FileStatus> result;
+        std::vector<std::pair<std::size_t, const Sides*>> compared;
+        result.reserve(paths.size());
+        for (const auto& item : paths) {
+            FileStatus status;
+            status.path = item.first;
+            const Sides& sides = item.second;
+            if (sides.working == nullptr) {
+                if (ignore_.ignored(item.first, false)) {
+                    // Not walked rather than deleted: ignored paths are not reported
+                    continue;
+                }
+                status.state = FileState::Deleted;
+            } else if (sides.staged == nullptr && sides.committed == nullptr) {
+                status.state = FileState::Untracked;
+            } else {
+                compared.emplace_back(result.size(), &sides);
+                progress_.addQueued();
+            }
+            result.push_back(std::move(status));
+        }
+        progress_.finishQueueing();
+
+        auto sameContent = [this](const TreeEntry& file, const TreeEntry& stored) {
+            try {
+                std::string storedId = stored.id;
+                if (storedId.empty()) {
+                    // A full copy written by an older version: hash what it restores to
+                    fs::path temporary = objects_.createTemporary();
+                    bool restored = objects_.restore(stored.file(), temporary);
+                    storedId = restored ? objects_.contentId(temporary) : std::string();
+                    std::error_code ec;
+                    fs::remove(temporary, ec);
+                    if (storedId.empty()) {
+                        return false;
+                    }
+                }
+
+                std::string id;
+                if (index_.lookup(file.path, file.stat, id) != StatIndex::Match::Unknown) {
+                    return id == storedId;
+                }
+                ObjectLocation location;
+                uint64_t size;
+                if (objects_.locate(storedId, location) && objects_.contentSize(location, size) && size != file.stat.size) {
+                    return false;
+                }
+                // Only an id whose object exists may go into the index: add() trusts it
+                id = objects_.contentId(file.file());
+                if (id != storedId) {
+                    return false;
+                }
+                index_.refresh(file.path, file.stat, id);
+                return true;
+            } catch (const std::exception& e) {
+                Logger::log(LogLevel::Warning, "Cannot compare " + file.path + ": " + e.what());
+                return false;
+            }
+        };
+
+        TaskGroup group;
+        for (std::size_t first = 0; first < compared.size(); first += statusBatch) {
+            std::size_t last = std::min(compared.size(), first + statusBatch);
+            group.run([this, &compared, &result, &sameContent, first, last] {
+                for (std::size_t i = first; i < last; ++i) {
+                    progress_.throwIfCancelled();
+                    const Sides& sides = *compared[i].second;
+                    if (sides.staged != nullptr) {
+                        result[compared[i].first].state = sameContent(*sides.working, *sides.staged)
+                            ? FileState::Staged : FileState::Modified;
+                    } else {
+                        result[compared[i].first].state = sameContent(*sides.working, *sides.committed)
+                            ? FileState::Unchanged : FileState::Modified;
+                    }
+                    progress_.addDone(sides.working->stat.size);
+                }
+            });
+        }
+        group.wait();
+        index_.save();
+
+        std::sort(result.begin(), result.end(), [](const FileStatus& a, const FileStatus& b) {
+            return a.path < b.path;
+        });
+        return result;
+    } catch (const OperationCancelled&) {
+        index_.save();
+        Logger::log(LogLevel::Info, "Status cancelled");
+        throw;
+    } catch (const std::exception& e) {
+        Logger::log("Error computing the status: " + std::string(e.what()));
+        throw;
+    }
+}
+
+/**
+ * @brief Writes the unified diff between two versions, or between a version and the working tree.
+ *
+ * Files whose stored ids are equal are skipped without reading them; a working file is
+ * compared through the stat index, then by size and hash, before any line is looked at.
+ * The others are restored through the object store (so their checksums are verified)
+ * into temporary files and streamed through LineDiff, several files at a time.
+ * @param oldFolder The commit folder of the old version.
+ * @param newFolder The commit folder of the new version, empty for the working tree.
+ * @param output Receives the diff, files in path order.
+ * @param context Unchanged lines shown around each change.
+ * @return std::size_t - The number of files that differ.
+ */
+std::size_t MiniVersionControl::diff(const std::string& oldFolder, const std::string& newFolder,
+                                     std::ostream& output, unsigned context) {
+    Stats::Operation operation("diff");
+    auto lock = Stats::timedLock(mutex_);
+
+    try {
+        bool working = newFolder.empty();
+        std::deque<std::vector<TreeEntry>> oldParts;
+        std::deque<std::vector<TreeEntry>> newParts;
+        std::string oldTree;
+        std::string newTree;
+        bool trees = !working && commitTree(oldFolder, oldTree) && commitTree(newFolder, newTree);
+        if (trees) {
+            // Only the directories on changed paths are read; both parts hold changed files only
+            std::vector<TreeEntry>& oldPart = oldParts.emplace_back();
+            std::vector<TreeEntry>& newPart = newParts.emplace_back();
+            trees = MerkleTree::compare(objects_, oldTree, newTree,
+                [&oldPart, &newPart](const std::string& path, const std::string& oldId, const std::string& newId) {
+                    if (!oldId.empty()) {
+                        oldPart.push_back(TreeEntry{path, nullptr, FileStat(), oldId});
+                    }
+                    if (!newId.empty()) {
+                        newPart.push_back(TreeEntry{path, nullptr, FileStat(), newId});
+                    }
+                });
+            if (!trees) {
+                Logger::log(LogLevel::Warning, "Unreadable tree, comparing the commit folders instead");
+                oldParts.clear();
+                newParts.clear();
+            }
+        }
+        if (!trees) {
+            TaskGroup group;
+            collectCommit(objects_, oldFolder, group, oldParts);
+            if (working) {
+                loadIgnoreRules();
+                collectTree(".", true, {".git", "log.txt", "main.exe"}, group, newParts, &ignore_);
+            } else {
+                collectCommit(objects_, newFolder, group, newParts);
+            }
+            group.wait();
+        }
+        if (working) {
+            index_.load();
+        }
+
+        std::map<std::string, std::pair<const TreeEntry*, const TreeEntry*>> paths;
+        for (const auto& part : oldParts) {
+            for (const TreeEntry& entry : part) {
+                paths[entry.path].first = &entry;
+            }
+        }
+        for (const auto& part : newParts) {
+            for (const TreeEntry& entry : part) {
+                paths[entry.path].second = &entry;
+            }
+        }
+
+        // Same content without reading a line: equal ids, or a working file hashing to the old id
+        auto unchanged = [this, working](const TreeEntry& oldEntry, const TreeEntry& newEntry) {
+            if (oldEntry.id.empty()) {
+                return false;
+            }
+            if (!working) {
+                return oldEntry.id == newEntry.id;
+            }
+            std::string id;
+            if (index_.lookup(newEntry.path, newEntry.stat, id) != StatIndex::Match::Unknown) {
+                return id == oldEntry.id;
+            }
+            ObjectLocation location;
+            uint64_t size;
+            if (objects_.locate(oldEntry.id, location) && objects_.contentSize(location, size)
+                && size != newEntry.stat.size) {
+                return false;
+            }
+            id = objects_.contentId(newEntry.file());
+            if (id != oldEntry.id) {
+                return false;
+            }
+            index_.refresh(newEntry.path, newEntry.stat, id);
+            return true;
+        };
+
+        auto restoreStored = [this](const TreeEntry& entry, const fs::path& temporary) {
+            bool restored;
+            if (entry.id.empty()) {
+                restored = objects_.restore(entry.file(), temporary);
+            } else {
+                ObjectLocation location;
+                if (!objects_.locate(entry.id, location)) {
+                    throw std::runtime_error("Missing object " + entry.id + " for file: " + entry.path);
+                }
+                restored = objects_.restore(location, temporary);
+            }
+            if (!restored) {
+                throw std::runtime_error("Checksum validation failed for file: " + entry.path);
+            }
+        };
+
+        std::vector<std::pair<const std::string*, std::pair<const TreeEntry*, const TreeEntry*>>> candidates;
+        for (const auto& item : paths) {
+            const TreeEntry* oldEntry = item.second.first;
+            const TreeEntry* newEntry = item.second.second;
+            if (working && newEntry == nullptr && ignore_.ignored(item.first, false)) {
+                continue;
+            }
+            if (oldEntry == nullptr || newEntry == nullptr || !unchanged(*oldEntry, *newEntry)) {
+                candidates.emplace_back(&item.first, item.second);
+            }
+        }
+
+        std::size_t differing = 0;
+        for (std::size_t first = 0; first < candidates.size(); first += diffBatch) {
+            std::size_t last = std::min(candidates.size(), first + diffBatch);
+            std::vector<std::string> texts(last - first);
+            {
+                TaskGroup group;
+                for (std::size_t i = first; i < last; ++i) {
+                    group.run([&, i] {
+                        const std::string& path = *candidates[i].first;
+                        const TreeEntry* oldEntry = candidates[i].second.first;
+                        const TreeEntry* newEntry = candidates[i].second.second;
+                        fs::path oldFile;
+                        fs::path newFile;
+                        std::vector<fs::path> temporaries;
+                        try {
+                            if (oldEntry != nullptr) {
+                                oldFile = objects_.createTemporary();
+                                temporaries.push_back(oldFile);
+                                restoreStored(*oldEntry, oldFile);
+                            }
+                            if (newEntry != nullptr && working) {
+                                newFile = newEntry->file();
+                            } else if (newEntry != nullptr) {
+                                newFile = objects_.createTemporary();
+                                temporaries.push_back(newFile);
+                                restoreStored(*newEntry, newFile);
+                            }
+                            std::ostringstream text;
+                            if (LineDiff::writeUnified(text, oldFile, newFile, "a/" + path, "b/" + path, context)) {
+                                texts[i - first] = text.str();
+                            }
+                        } catch (...) {
+                            std::error_code ec;
+                            for (const fs::path& temporary : temporaries) {
+                                fs::remove(temporary, ec);
+                            }
+                            throw;
+                        }
+                        std::error_code ec;
+                        for (const fs::path& temporary : temporaries) {
+                            fs::remove(temporary, ec);
+                        }
+                    });
+                }
+                group.wait();
+            }
+            for (const std::string& text : texts) {
+                if (!text.empty()) {
+                    output << text;
+                    ++differing;
+                }
+            }
+        }
+        if (working) {
+            index_.save();
+        }
+        return differing;
+    } catch (const std::exception& e) {
+        Logger::log("Error computing the diff: " + std::string(e.what()));
+        throw;
+    }
+}
+
+/**
+ * @brief Lists the files of a version; commits with trees are listed without walking their folder.
+ * @param commitFolder The commit folder.
+ * @return std::vector<std::string> - The paths, sorted.
+ */
+std::vector<std::string> MiniVersionControl::listVersionFiles(const std::string& commitFolder) {
+    try {
+        std::deque<std::vector<TreeEntry>> parts;
+        {
+            TaskGroup group;
+            collectCommit(objects_, commitFolder, group, parts);
+            group.wait();
+        }
+        std::vector<std::string> paths;
+        for (const auto& part : parts) {
+            for (const TreeEntry& entry : part) {
+                paths.push_back(entry.path);
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    } catch (const std::exception& e) {
+        Logger::log("Error listing the files of a version: " + std::string(e.what()));
+        throw;
+    }
+}
+
+/**
+ * @brief Returns the name of a state, as printed by the command line and the GUI.
+ */
+const char* FileStatus::stateName(FileState state) {
+    switch (state) {
+    case FileState::Unchanged:
+        return "unchanged";
+    case FileState::Modified:
+        return "modified";
+    case FileState::Staged:
+        return "staged";
+    case FileState::Deleted:
+        return "deleted";
+    case FileState::Untracked:
+        return "untracked";
+    }
+    return "unknown";
+}
+
+
 /**
  * @brief Lists all available versions (commits) in the repository.
  * @return std::vector<std::string> - A vector of version (commit) folder names.
@@ -386,13 +1710,32 @@ std::vector<std::string> MiniVersionControl::listVersions() {
     }
 }
 
+/**
+ * @brief Orders version names by commit time.
+ *
+ * A version is named after its timestamp in seconds, followed by "_2", "_3"... for the
+ * later commits of the same second.
+ * @param a A version name.
+ * @param b Another version name.
+ * @return bool - true if a was committed before b.
+ */
+bool MiniVersionControl::olderVersion(const std::string& a, const std::string& b) {
+    auto split = [](const std::string& name) {
+        std::size_t separator = std::min(name.find('_'), name.size());
+        std::string time = name.substr(0, separator);
+        unsigned long sequence = separator < name.size() ? std::strtoul(name.c_str() + separator + 1, nullptr, 10) : 1;
+        return std::make_tuple(time.size(), time, sequence);
+    };
+    return split(a) < split(b);
+}
+
 
 /**
  * @brief Deletes a file or directory from the staging area.
  * @param name The name of the file or directory to be deleted.
  */
 void MiniVersionControl::deleteFromStaging(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex_); // Lock the mutex for this scope
+    auto lock = Stats::timedLock(mutex_); // Lock the mutex for this scope
 
     try {
         const fs::path stagingPath = ".git/staging";
@@ -408,8 +1751,11 @@ void MiniVersionControl::deleteFromStaging(const std::string& name) {
                     // Remove file
                     fs::remove(itemPath);
                 }
+                index_.load();
+                index_.unstage(name);
+                index_.save();
             } else {
-                Logger::log("Item '" + name + "' not found in the staging area.");
+                Logger::log(LogLevel::Warning, "Item '" + name + "' not found in the staging area.");
             }
         } else {
             Logger::log("Staging area not found.");
@@ -422,49 +1768,135 @@ void MiniVersionControl::deleteFromStaging(const std::string& name) {
 
 /**
  * @brief Adds a directory to the staging area with enhanced performance using multithreading.
+ *
+ * addDirectory itself now stores the files on the shared thread pool, so this is the same
+ * operation with its errors logged.
  * @param source The source directory path.
  * @param destination The destination directory path in the staging area.
  */
 void MiniVersionControl::enhancedAddDirectoy(const fs::path& source, const fs::path& destination) {
     try {
-        fs::create_directory(destination);
-        std::vector<std::future<void>> futures;  // Use vector to store futures for threads
+        addDirectory(source, destination);
+    } catch (const std::exception& e) {
+        Logger::log("Error adding directory: " + std::string(e.what()));
+        throw;
+    }
 
-        const int maxThreads = 4;  // Set the maximum number of threads
+}
 
-        for (const auto& entry : fs::recursive_directory_iterator(source)) {
-            fs::path nestedDestination = destination / entry.path().lexically_relative(source);
 
-            if (entry.is_regular_file()) {
-                // Launch a new thread only if the number of active threads is less than the maximum
-                if (futures.size() < maxThreads) {
-                    // Use std::async to launch the function in a separate thread
-                    futures.push_back(std::async(std::launch::async, &MiniVersionControl::addFile, this, entry.path(), nestedDestination));
-                } else {
-                    // Wait for any thread to finish before launching a new one
-                    auto it = std::find_if(futures.begin(), futures.end(), [](const std::future<void>& f) {
-                        return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
-                    });
-                    if (it != futures.end()) {
-                        it->wait();  // Wait for the thread to finish
-                        futures.erase(it);
-                    }
-                    // Launch a new thread
-                    futures.push_back(std::async(std::launch::async, &MiniVersionControl::addFile, this, entry.path(), nestedDestination));
-                }
-            } else if (entry.is_directory()) {
-                // Reuse the current thread for handling directories
-                addDirectory(entry.path(), nestedDestination);
-            }
-        }
+/**
+ * @brief Selects how file data is copied between the working tree and the object store.
+ * @param mode Auto (reflink, then kernel copy, then buffered) or the first method to try.
+ */
+void MiniVersionControl::setCopyMode(CopyMode mode) {
+    objects_.setCopyMode(mode);
+}
 
-        // Wait for all remaining threads to finish
-        for (auto& future : futures) {
-            future.wait();
-        }
+
+/**
+ * @brief Selects how the contents added from now on are compressed in the object store.
+ * @param level None, Fast (LZ4-class, the default) or High (slower, better ratio).
+ */
+void MiniVersionControl::setCompression(Compression level) {
+    objects_.setCompression(level);
+}
+
+
+/**
+ * @brief Sets how many deltas may be chained before a version is stored in full again.
+ * @param depth The maximum delta chain length (8 by default); 0 stores every version in full.
+ */
+void MiniVersionControl::setDeltaDepth(unsigned depth) {
+    objects_.setDeltaDepth(depth);
+}
+
+
+/**
+ * @brief Sets the size from which files are stored as lists of content-defined chunks.
+ * @param size The smallest file size chunked (8 MiB by default); 0 stores every file whole.
+ */
+void MiniVersionControl::setChunkThreshold(uint64_t size) {
+    objects_.setChunkThreshold(size);
+}
+
+
+/**
+ * @brief Selects how batches of small files are read and written by add and revert.
+ * @param engine Auto (io_uring where available, the default from MINIGIT_IO_ENGINE), Uring or Threads.
+ */
+void MiniVersionControl::setIoEngine(IoEngine engine) {
+    if (engine == IoEngine::Uring && !BatchIo::uringSupported()) {
+        Logger::log(LogLevel::Warning, "io_uring is not available, small files use blocking I/O");
+    }
+    ioEngine_ = engine;
+}
+
+
+/**
+ * @brief Packs the loose objects into a single pack file with a sorted index.
+ * @return std::size_t - The number of objects packed.
+ */
+std::size_t MiniVersionControl::pack() {
+    Stats::Operation operation("pack");
+    auto lock = Stats::timedLock(mutex_);
+
+    try {
+        return objects_.pack();
     } catch (const std::exception& e) {
-        Logger::log("Error adding directory: " + std::string(e.what()));
+        Logger::log("Error packing objects: " + std::string(e.what()));
         throw;
     }
+}
+
+
+/**
+ * @brief Reports the storage ratio of the repository and the compression throughput of this session.
+ * @return StorageReport - The statistics, also written to the log.
+ */
+StorageReport MiniVersionControl::storageReport() {
+    try {
+        StorageReport report = objects_.storageReport();
+        Logger::log(LogLevel::Info, "Storage: " + report.summary());
+        return report;
+    } catch (const std::exception& e) {
+        Logger::log("Error reading storage statistics: " + std::string(e.what()));
+        throw;
+    }
+}
+
 
+/**
+ * @brief Returns the progress of the running add, commit or revert.
+ *
+ * It may be read, and the operation cancelled, from any thread while the operation runs.
+ */
+Progress& MiniVersionControl::progress() {
+    return progress_;
+}
+
+/**
+ * @brief Starts watching the working tree, so addChanged() only looks at what changed.
+ * @return bool - false if watching is not supported here or another process already watches.
+ */
+bool MiniVersionControl::startWatching() {
+    return tracker_.start();
+}
+
+void MiniVersionControl::stopWatching() {
+    tracker_.stop();
+}
+
+/**
+ * @brief Counts the changes seen by this process's watcher; it only grows.
+ */
+uint64_t MiniVersionControl::changeCount() const {
+    return tracker_.changeCount();
+}
+
+/**
+ * @brief Returns the changes not yet added, as known to the watcher of the repository.
+ */
+ChangeTracker::Changes MiniVersionControl::pendingChanges() const {
+    return tracker_.pendingChanges();
 }
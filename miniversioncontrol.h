@@ -3,12 +3,45 @@
 
 #include <filesystem>
 #include <chrono>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <mutex>
+#include <utility>
+#include <vector>
+
+#include <batchio.h>
+#include <changetracker.h>
+#include <ignorerules.h>
+#include <objectstore.h>
+#include <pathtable.h>
+#include <progress.h>
+#include <statindex.h>
+
+class TaskGroup;
 
 namespace fs = std::filesystem;
 using namespace std::chrono;
 
+/**
+ * @brief What status() found for a path.
+ */
+enum class FileState {
+    Unchanged,  // Same content as in the newest commit, nothing staged
+    Modified,   // Differs from the staged content, or from the newest commit when nothing is staged
+    Staged,     // The staged content is the working tree content
+    Deleted,    // Staged or committed, but gone from the working tree
+    Untracked   // Neither staged nor committed
+};
+
+struct FileStatus
+{
+    std::string path;  // Relative to the repository root
+    FileState state = FileState::Untracked;
+
+    static const char* stateName(FileState state);
+};
+
 class MiniVersionControl
 {
 public:
@@ -16,15 +49,23 @@ public:
 
     void init();
     void add(const std::string& path);
+    void add(const std::vector<std::string>& paths);
+    void addChanged();
     void commit(const std::string& message);
     void revert(const std::string& commitFolder);
     std::vector<std::string> listFilesAndFolders();
     void revertFile(const fs::path& source, const fs::path& destination);
-    void addFile(const fs::path& source, const fs::path& destination);
+    void addFile(const fs::path& source, const fs::path& destination, bool onlyChanged = false);
     std::vector<std::string> listStagingArea();
+    std::vector<FileStatus> status();
+    std::size_t diff(const std::string& oldFolder, const std::string& newFolder, std::ostream& output,
+                     unsigned context = 3);
 
 
     std::vector<std::string> listVersions();
+    static bool olderVersion(const std::string& a, const std::string& b);
+
+    std::vector<std::string> listVersionFiles(const std::string& commitFolder);
 
 
     void revertDirectory(const fs::path& sourceDir, const fs::path& destinationDir);
@@ -36,11 +77,62 @@ public:
 
     void enhancedAddDirectoy(const fs::path& source, const fs::path& destination);
 
+    void setCopyMode(CopyMode mode);
+
+    void setCompression(Compression level);
+
+    void setDeltaDepth(unsigned depth);
+
+    void setChunkThreshold(uint64_t size);
+
+    void setIoEngine(IoEngine engine);
+
+    std::size_t pack();
+
+    StorageReport storageReport();
+
+    Progress& progress();
+
+    bool startWatching();
+
+    void stopWatching();
+
+    uint64_t changeCount() const;
+
+    ChangeTracker::Changes pendingChanges() const;
+
 
 
 private:
+    /**
+     * @brief A directory walked by scheduleDirectory() or scheduleRevert(), shared by its batches.
+     */
+    struct WalkedTree
+    {
+        PathTable table;
+        std::string source;       // Root prefixes of the table paths, ending with '/'
+        std::string destination;
+        std::string keyPrefix;    // Stat index key of the destination root and '/', empty if not indexed
+    };
+
+    void scheduleDirectory(const fs::path& source, const fs::path& destination, TaskGroup& group,
+                           bool onlyChanged = false);
+    void addBatch(const WalkedTree& tree, const std::vector<uint32_t>& files, bool onlyChanged, TaskGroup& group);
+    void scheduleRevert(const fs::path& sourceDir, const fs::path& destinationDir, TaskGroup& group);
+    void revertBatch(const WalkedTree& tree, const std::vector<uint32_t>& files, TaskGroup& group);
+    bool workingCopyMatches(const fs::path& file, const std::string& key, const ObjectLocation& stored,
+                            const std::string& id);
+    std::string revertTemporarySuffix() const;
+    void loadIgnoreRules();
+
     // Your class members go here
     std::mutex mutex_; // Mutex for synchronization
+    ObjectStore objects_; // Content-addressable blob store
+    StatIndex index_; // Stat cache of the staged files
+    Progress progress_; // Progress and cancellation of the running operation
+    ChangeTracker tracker_; // Working tree watcher, when watching
+    IgnoreRules ignore_; // .minigitignore patterns, reloaded by each operation that walks the working tree
+    IoEngine ioEngine_ = BatchIo::engineFromEnvironment(); // How batches of small files are read and written
 
 };
 
@@ -0,0 +1,1719 @@
+#include <objectstore.h>
+
+#include <checksum.h>
+#include <chunker.h>
+#include <delta.h>
+#include <stats.h>
+#include <threadpool.h>
+#include <widehash.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Marker written at the start of every staging/commit reference file.
+const std::string referencePrefix = "ref ";
+
+// Size of the chunks files are streamed through, so memory stays fixed whatever the file size
+const std::size_t ioBufferSize = 1 << 20;
+
+// Layout of the footer ending every object
+const char footerMagic[] = "MGO1";
+const std::size_t footerSize = 32;
+
+// Object types of the footer (byte 5): chunks are only stored for the chunked objects listing them
+enum class ObjectType : uint8_t {
+    Content = 0,
+    Chunk = 1
+};
+
+// Codecs of the footer (byte 6)
+enum class Codec : uint8_t {
+    None = 0,
+    LzBlocks = 1,
+    Delta = 2,
+    Chunked = 3
+};
+
+// Compressed objects: the block table entries flag the blocks stored raw, and are
+// followed by the block count and the block size
+const uint32_t storedRawFlag = 0x80000000U;
+const std::size_t blockTrailerSize = 8;
+
+// Contents below this size are stored raw, the block table would outweigh any gain
+const uint64_t minCompressedSize = 64;
+
+// At most this many blocks are in flight per object, bounding the memory of parallel adds
+const std::size_t maxBatchBlocks = 8;
+
+// Delta objects end with the id length and the chain depth, one byte each
+const std::size_t deltaTrailerSize = 2;
+
+// Deltas are computed in memory, so only for contents (and bases) in this size range
+const uint64_t minDeltaSize = 1024;
+const uint64_t maxDeltaSize = 32 << 20;
+
+// Guards against corrupted delta objects referring to each other in a loop
+const unsigned maxDeltaWalk = 255;
+
+// Chunked objects: each entry of the chunk list is the chunk size (4 bytes), the id length
+// (1 byte) and the id, and the list is followed by the chunk count
+const std::size_t chunkEntryHeaderSize = 5;
+const std::size_t chunkListTrailerSize = 4;
+
+// Content read per chunking batch, and at most this many chunks are restored in parallel
+const std::size_t chunkWindowSize = 8 << 20;
+const std::size_t maxBatchChunks = 64;
+
+// Header of pack files: magic and version
+const char packMagic[] = "MGPK\x01\0\0\0";
+const std::size_t packHeaderSize = 8;
+
+// Layout of files written before the footer existed
+const std::size_t legacyPrefixSize = 4;
+const std::size_t legacyTrailerSize = 4;
+
+struct ObjectFooter
+{
+    HashAlgorithm algorithm = HashAlgorithm::Wide128;
+    ObjectType type = ObjectType::Content;
+    Codec codec = Codec::None;
+    uint64_t contentSize = 0;
+    Digest checksum;
+};
+
+void encodeFooter(const ObjectFooter& footer, char* out) {
+    std::memset(out, 0, footerSize);
+    std::memcpy(out, footerMagic, 4);
+    out[4] = static_cast<char>(footer.algorithm);
+    out[5] = static_cast<char>(footer.type);
+    out[6] = static_cast<char>(footer.codec);
+    for (std::size_t i = 0; i < 8; ++i) {
+        out[8 + i] = static_cast<char>(footer.contentSize >> (8 * i));
+    }
+    std::memcpy(out + 16, footer.checksum.bytes, footer.checksum.size);
+}
+
+bool decodeFooter(const char* in, uint64_t fileSize, ObjectFooter& footer) {
+    if (std::memcmp(in, footerMagic, 4) != 0) {
+        return false;
+    }
+    footer.algorithm = static_cast<HashAlgorithm>(static_cast<uint8_t>(in[4]));
+    footer.type = static_cast<ObjectType>(static_cast<uint8_t>(in[5]));
+    footer.codec = static_cast<Codec>(static_cast<uint8_t>(in[6]));
+    footer.contentSize = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        footer.contentSize |= static_cast<uint64_t>(static_cast<uint8_t>(in[8 + i])) << (8 * i);
+    }
+    if (footer.type > ObjectType::Chunk || footer.algorithm != HashAlgorithm::Wide128) {
+        return false;
+    }
+    switch (footer.codec) {
+    case Codec::None:
+        if (footer.contentSize != fileSize - footerSize) {
+            return false;
+        }
+        break;
+    case Codec::LzBlocks:
+        if (fileSize < footerSize + blockTrailerSize) {
+            return false;
+        }
+        break;
+    case Codec::Delta:
+        if (fileSize < footerSize + deltaTrailerSize) {
+            return false;
+        }
+        break;
+    case Codec::Chunked:
+        if (fileSize < footerSize + chunkListTrailerSize) {
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+    footer.checksum.size = 16;
+    std::memcpy(footer.checksum.bytes, in + 16, 16);
+    return true;
+}
+
+uint32_t readU32(const char* p) {
+    uint32_t value = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return value;
+}
+
+void putU32(char* p, uint32_t value) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        p[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+/**
+ * Reads the block table of a compressed object (the input is positioned anywhere) and
+ * checks it against the content size and the stored size. Returns false if it is corrupted.
+ */
+bool readBlockTable(std::istream& input, const ObjectLocation& stored, uint64_t contentSize,
+                    std::vector<uint32_t>& blocks, uint64_t& blockSize) {
+    const uint64_t tableEnd = stored.length - footerSize - blockTrailerSize;
+    char trailer[blockTrailerSize];
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(stored.offset + tableEnd));
+    input.read(trailer, blockTrailerSize);
+    if (!input) {
+        return false;
+    }
+    uint64_t count = readU32(trailer);
+    blockSize = readU32(trailer + 4);
+    if (blockSize == 0 || count != (contentSize + blockSize - 1) / blockSize || count * 4 > tableEnd) {
+        return false;
+    }
+
+    std::vector<char> table(static_cast<std::size_t>(count * 4));
+    input.seekg(static_cast<std::streamoff>(stored.offset + tableEnd - table.size()));
+    input.read(table.data(), static_cast<std::streamsize>(table.size()));
+    if (!input) {
+        return false;
+    }
+    blocks.resize(static_cast<std::size_t>(count));
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i] = readU32(table.data() + 4 * i);
+        uint64_t rawSize = std::min(blockSize, contentSize - i * blockSize);
+        uint64_t size = blocks[i] & ~storedRawFlag;
+        if ((blocks[i] & storedRawFlag) != 0 && size != rawSize) {
+            return false;
+        }
+        total += size;
+    }
+    return total == tableEnd - table.size();
+}
+
+/**
+ * Encodes the block table of a compressed object, with its block count and block size.
+ */
+std::vector<char> encodeBlockTable(const std::vector<uint32_t>& blocks) {
+    std::vector<char> table(blocks.size() * 4 + blockTrailerSize);
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        putU32(table.data() + 4 * i, blocks[i]);
+    }
+    putU32(table.data() + 4 * blocks.size(), static_cast<uint32_t>(blocks.size()));
+    putU32(table.data() + 4 * blocks.size() + 4, static_cast<uint32_t>(ioBufferSize));
+    return table;
+}
+
+/**
+ * Reads the trailer of a delta object: the id of its base, the depth of the delta chain
+ * and the size of the instructions. Returns false if it is corrupted.
+ */
+bool readDeltaTrailer(std::istream& input, const ObjectLocation& stored, std::string& baseId,
+                      unsigned& depth, uint64_t& payloadSize) {
+    const uint64_t trailerEnd = stored.length - footerSize;
+    unsigned char trailer[deltaTrailerSize];
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(stored.offset + trailerEnd - deltaTrailerSize));
+    input.read(reinterpret_cast<char*>(trailer), deltaTrailerSize);
+    std::size_t idLength = trailer[0];
+    if (!input || idLength == 0 || trailerEnd < deltaTrailerSize + idLength) {
+        return false;
+    }
+    depth = trailer[1];
+    payloadSize = trailerEnd - deltaTrailerSize - idLength;
+    baseId.resize(idLength);
+    input.seekg(static_cast<std::streamoff>(stored.offset + payloadSize));
+    input.read(&baseId[0], static_cast<std::streamsize>(idLength));
+    return static_cast<bool>(input);
+}
+
+struct ChunkEntry
+{
+    std::string id;
+    uint32_t size = 0;
+};
+
+/**
+ * Reads the chunk list of a chunked object and checks it against the content size.
+ * Returns false if it is corrupted.
+ */
+bool readChunkList(std::istream& input, const ObjectLocation& stored, uint64_t contentSize,
+                   std::vector<ChunkEntry>& chunks) {
+    std::vector<char> list(static_cast<std::size_t>(stored.length - footerSize));
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(stored.offset));
+    input.read(list.data(), static_cast<std::streamsize>(list.size()));
+    if (!input) {
+        return false;
+    }
+
+    const std::size_t end = list.size() - chunkListTrailerSize;
+    uint64_t total = 0;
+    chunks.clear();
+    for (std::size_t position = 0; position < end;) {
+        if (end - position < chunkEntryHeaderSize) {
+            return false;
+        }
+        ChunkEntry chunk;
+        chunk.size = readU32(list.data() + position);
+        std::size_t idLength = static_cast<uint8_t>(list[position + 4]);
+        position += chunkEntryHeaderSize;
+        if (chunk.size == 0 || idLength == 0 || end - position < idLength) {
+            return false;
+        }
+        chunk.id.assign(list.data() + position, idLength);
+        position += idLength;
+        total += chunk.size;
+        chunks.push_back(std::move(chunk));
+    }
+    return chunks.size() == readU32(list.data() + end) && total == contentSize;
+}
+
+/**
+ * Appends the entry of a chunk to the chunk list of a chunked object.
+ */
+void appendChunkEntry(std::vector<char>& list, const std::string& id, std::size_t size) {
+    char header[chunkEntryHeaderSize];
+    putU32(header, static_cast<uint32_t>(size));
+    header[4] = static_cast<char>(id.size());
+    list.insert(list.end(), header, header + chunkEntryHeaderSize);
+    list.insert(list.end(), id.begin(), id.end());
+}
+
+/**
+ * Compresses a block, or keeps it raw when compression does not make it smaller.
+ * Returns the block table entry.
+ */
+uint32_t compressStoredBlock(const char* raw, std::size_t size, Compression level, std::vector<char>& packed) {
+    Stats::ScopedTimer timer(Stats::Phase::Compression);
+    LzCodec::compressBlock(raw, size, level, packed);
+    if (packed.size() >= size) {
+        packed.assign(raw, raw + size);
+        return static_cast<uint32_t>(size) | storedRawFlag;
+    }
+    return static_cast<uint32_t>(packed.size());
+}
+
+/**
+ * Reads the footer of a stored object. Returns false for legacy files.
+ */
+bool readFooter(std::istream& input, const ObjectLocation& stored, ObjectFooter& footer) {
+    if (stored.length < footerSize) {
+        return false;
+    }
+    char footerBytes[footerSize];
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(stored.offset + stored.length - footerSize));
+    input.read(footerBytes, footerSize);
+    return input && decodeFooter(footerBytes, stored.length, footer);
+}
+
+uint64_t elapsedNanos(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * Reads, writes and hashes the chunks of the object data paths, accounting for them in Stats.
+ */
+std::size_t readChunk(std::istream& input, char* data, std::size_t size) {
+    Stats::ScopedTimer timer(Stats::Phase::Io);
+    input.read(data, static_cast<std::streamsize>(size));
+    std::size_t count = static_cast<std::size_t>(input.gcount());
+    Stats::add(Stats::Counter::BytesRead, count);
+    return count;
+}
+
+void writeChunk(std::ostream& output, const char* data, std::size_t size) {
+    Stats::ScopedTimer timer(Stats::Phase::Io);
+    output.write(data, static_cast<std::streamsize>(size));
+    Stats::add(Stats::Counter::BytesWritten, size);
+}
+
+void hashChunk(Hasher& hasher, const char* data, std::size_t size) {
+    Stats::ScopedTimer timer(Stats::Phase::Hashing);
+    hasher.update(data, size);
+    Stats::add(Stats::Counter::BytesHashed, size);
+}
+
+/**
+ * Streams a byte range of a stored file to a destination file while hashing a (possibly
+ * larger) range with the given hasher. Returns false if the input ended early.
+ */
+bool copyVerified(std::ifstream& input, uint64_t hashedSize, uint64_t skippedPrefix,
+                  Hasher& hasher, std::ofstream& output) {
+    std::vector<char> buffer(ioBufferSize);
+    uint64_t position = 0;
+    while (position < hashedSize) {
+        std::size_t wanted = static_cast<std::size_t>(std::min<uint64_t>(hashedSize - position, buffer.size()));
+        std::size_t count = readChunk(input, buffer.data(), wanted);
+        if (count == 0) {
+            return false;
+        }
+        hashChunk(hasher, buffer.data(), count);
+        std::size_t skip = position < skippedPrefix
+            ? static_cast<std::size_t>(std::min<uint64_t>(skippedPrefix - position, count))
+            : 0;
+        writeChunk(output, buffer.data() + skip, count - skip);
+        position += count;
+    }
+    return true;
+}
+
+/**
+ * Hashes the first bytes of a stream. Returns false if the input ended early.
+ */
+bool hashStream(std::istream& input, uint64_t size, Hasher& hasher) {
+    std::vector<char> buffer(ioBufferSize);
+    uint64_t position = 0;
+    while (position < size) {
+        std::size_t wanted = static_cast<std::size_t>(std::min<uint64_t>(size - position, buffer.size()));
+        std::size_t count = readChunk(input, buffer.data(), wanted);
+        if (count == 0) {
+            return false;
+        }
+        hashChunk(hasher, buffer.data(), count);
+        position += count;
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief ObjectStore constructor.
+ * @param root The directory holding the objects (usually .git/objects).
+ */
+ObjectStore::ObjectStore(const fs::path& root)
+    : root_(root), copyMode_(FastCopy::modeFromEnvironment()), compression_(LzCodec::levelFromEnvironment()) {
+}
+
+/**
+ * @brief Selects how file data is copied in and out of the store.
+ * @param mode The copy mode; the default comes from MINIGIT_COPY_MODE, or Auto.
+ */
+void ObjectStore::setCopyMode(CopyMode mode) {
+    copyMode_ = mode;
+}
+
+/**
+ * @brief Returns the copy mode in use.
+ * @return CopyMode - The copy mode.
+ */
+CopyMode ObjectStore::copyMode() const {
+    return copyMode_;
+}
+
+/**
+ * @brief Selects how new objects are compressed.
+ * @param level The compression level; the default comes from MINIGIT_COMPRESSION, or Fast.
+ */
+void ObjectStore::setCompression(Compression level) {
+    compression_ = level;
+}
+
+/**
+ * @brief Returns the compression level of new objects.
+ * @return Compression - The level.
+ */
+Compression ObjectStore::compression() const {
+    return compression_;
+}
+
+/**
+ * @brief Sets the longest delta chain a new object may end.
+ * @param depth The maximum number of delta applications to rebuild a content; 0 disables deltas.
+ */
+void ObjectStore::setDeltaDepth(unsigned depth) {
+    deltaDepth_ = std::min(depth, 255u);
+}
+
+/**
+ * @brief Returns the longest delta chain a new object may end.
+ * @return unsigned - The maximum depth, 0 when deltas are disabled.
+ */
+unsigned ObjectStore::deltaDepth() const {
+    return deltaDepth_;
+}
+
+/**
+ * @brief Sets the size from which files are stored as lists of content-defined chunks.
+ * @param size The smallest file size chunked; 0 disables chunking.
+ */
+void ObjectStore::setChunkThreshold(uint64_t size) {
+    chunkThreshold_ = size;
+}
+
+/**
+ * @brief Returns the size from which files are stored as lists of chunks.
+ * @return uint64_t - The threshold, 0 when chunking is disabled.
+ */
+uint64_t ObjectStore::chunkThreshold() const {
+    return chunkThreshold_;
+}
+
+/**
+ * @brief Creates the object directory if it does not exist yet.
+ */
+void ObjectStore::init() const {
+    fs::create_directories(root_);
+}
+
+/**
+ * @brief Returns the location of an object inside the store.
+ * @param id The hex identifier of the object.
+ * @return fs::path - root/xx/yyyy... where xx are the first two characters of the id.
+ */
+fs::path ObjectStore::objectPath(const std::string& id) const {
+    if (id.size() < 3) {
+        throw std::runtime_error("Invalid object id: " + id);
+    }
+    return root_ / id.substr(0, 2) / id.substr(2);
+}
+
+/**
+ * @brief Checks whether an object is already stored.
+ * @param id The hex identifier of the object.
+ * @return bool - true if the object exists.
+ */
+bool ObjectStore::contains(const std::string& id) const {
+    ObjectLocation location;
+    return locate(id, location);
+}
+
+/**
+ * @brief Finds where the bytes of an object are stored.
+ * @param id The hex identifier of the object.
+ * @param location Receives the loose object file, or the pack and the range in it.
+ * @return bool - false if the object is not stored.
+ */
+bool ObjectStore::locate(const std::string& id, ObjectLocation& location) const {
+    std::error_code ec;
+    fs::path loose = objectPath(id);
+    uint64_t size = fs::file_size(loose, ec);
+    if (!ec) {
+        location.file = loose;
+        location.offset = 0;
+        location.length = size;
+        return true;
+    }
+
+    for (const auto& pack : packs()) {
+        if (pack->find(id, location)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the indexes of the pack files, loading them on first use.
+ * @return std::vector<std::shared_ptr<PackIndex>> - The packs, newest first.
+ */
+std::vector<std::shared_ptr<PackIndex>> ObjectStore::packs() const {
+    {
+        std::shared_lock<std::shared_mutex> lock(packMutex_);
+        if (packsLoaded_) {
+            return packs_;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(packMutex_);
+    if (!packsLoaded_) {
+        packs_.clear();
+        std::error_code ec;
+        std::vector<std::pair<fs::file_time_type, fs::path>> indexes;
+        for (const auto& entry : fs::directory_iterator(root_ / "pack", ec)) {
+            if (entry.path().extension() == ".idx") {
+                indexes.emplace_back(fs::last_write_time(entry.path(), ec), entry.path());
+            }
+        }
+        std::sort(indexes.begin(), indexes.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (const auto& index : indexes) {
+            packs_.push_back(std::make_shared<PackIndex>(index.second));
+        }
+        packsLoaded_ = true;
+    }
+    return packs_;
+}
+
+/**
+ * @brief Returns a unique path inside the store where a new object can be written.
+ *
+ * Objects are streamed into such a file while their id is being computed, then
+ * moved into place with install(). The name holds the process id, so processes sharing
+ * the repository (the GUI and the CLI) never pick the same one.
+ * @return fs::path - A path that does not exist yet.
+ */
+fs::path ObjectStore::createTemporary() const {
+    static std::atomic<unsigned long long> counter{0};
+#ifdef _WIN32
+    static const long process = static_cast<long>(_getpid());
+#else
+    static const long process = static_cast<long>(::getpid());
+#endif
+
+    std::ostringstream name;
+    name << "tmp_" << process << "_" << std::this_thread::get_id() << "_" << counter++;
+    return root_ / name.str();
+}
+
+/**
+ * @brief Moves a fully written temporary file into the store under its id.
+ *
+ * If the object already exists the temporary file is discarded. The rename makes
+ * sure concurrent writers and interrupted writes never leave a partial object.
+ * @param temporary The file returned by createTemporary().
+ * @param id The hex identifier of its content.
+ */
+void ObjectStore::install(const fs::path& temporary, const std::string& id) const {
+    std::error_code ec;
+    if (contains(id)) {
+        fs::remove(temporary, ec);
+        return;
+    }
+
+    fs::path destination = objectPath(id);
+    fs::create_directories(destination.parent_path());
+
+    fs::rename(temporary, destination, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        if (!contains(id)) {
+            throw std::runtime_error("Error storing object: " + id);
+        }
+    }
+}
+
+/**
+ * @brief Stores the content of a file.
+ *
+ * When the id of the previous version of the file is given, the file is stored as a delta
+ * against it if that is much smaller (see writeDelta()). Otherwise files of at least
+ * chunkThreshold() bytes are split into chunks (see writeChunked()). Smaller files are,
+ * without compression and where the filesystem supports reflinks, first cloned into the
+ * store, which copies no data and gives a stable snapshot to hash, or streamed through
+ * writeBlob().
+ * @param source The file to store.
+ * @param baseId The id of the previous version of the file, or empty.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::writeFile(const fs::path& source, const std::string& baseId) const {
+    if (!baseId.empty() && deltaDepth_ > 0) {
+        std::string id;
+        if (writeDelta(source, baseId, id)) {
+            return id;
+        }
+    }
+
+    if (chunkThreshold_ > 0) {
+        std::error_code ec;
+        uint64_t size = fs::file_size(source, ec);
+        if (!ec && size >= chunkThreshold_) {
+            std::ifstream inputFile(source, std::ios::binary);
+            if (!inputFile.is_open()) {
+                throw std::runtime_error("Error opening source file: " + source.string());
+            }
+            return writeChunked(inputFile);
+        }
+    }
+
+    if (compression_ == Compression::None && (copyMode_ == CopyMode::Auto || copyMode_ == CopyMode::Reflink)) {
+        fs::path temporary = createTemporary();
+        bool cloned;
+        {
+            Stats::ScopedTimer timer(Stats::Phase::Metadata);
+            cloned = FastCopy::cloneFile(source, temporary);
+        }
+        if (cloned) {
+            std::ifstream clone(temporary, std::ios::binary);
+            WideHasher hasher;
+            uint64_t size = fs::file_size(temporary);
+            bool complete = clone.is_open() && hashStream(clone, size, hasher);
+            clone.close();
+            if (!complete) {
+                std::error_code ec;
+                fs::remove(temporary, ec);
+                throw std::runtime_error("Error reading object file: " + temporary.string());
+            }
+            return finishObject(temporary, size, hasher.finish());
+        }
+    }
+
+    std::ifstream inputFile(source, std::ios::binary);
+    if (!inputFile.is_open()) {
+        throw std::runtime_error("Error opening source file: " + source.string());
+    }
+    return writeBlob(inputFile);
+}
+
+/**
+ * @brief Stores a content already read in memory, like writeFile() would store the file holding it.
+ *
+ * Meant for small files read in batches: a delta against the previous version is tried
+ * the same way, and a content the store already has is only hashed.
+ * @param data The content.
+ * @param size The size of the content.
+ * @param baseId The id of the previous version of the file, or empty.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::writeContent(const char* data, std::size_t size, const std::string& baseId) const {
+    if (!baseId.empty() && deltaDepth_ > 0) {
+        std::string id;
+        if (writeDelta(data, size, baseId, id)) {
+            return id;
+        }
+    }
+    if (size > ioBufferSize) {
+        std::istringstream input(std::string(data, size));
+        return writeBlob(input);
+    }
+    return writeBuffer(data, size, static_cast<uint8_t>(ObjectType::Content));
+}
+
+/**
+ * @brief Streams a content into the store.
+ *
+ * The input is read in fixed-size chunks that are hashed and written to a temporary
+ * object as they arrive; the object is kept only if this content was never stored before.
+ * @param input The content to store.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::writeBlob(std::istream& input) const {
+    if (compression_ != Compression::None) {
+        return writeCompressed(input);
+    }
+
+    fs::path temporary = createTemporary();
+    std::ofstream objectFile(temporary, std::ios::binary);
+    if (!objectFile.is_open()) {
+        throw std::runtime_error("Error opening object file: " + temporary.string());
+    }
+
+    WideHasher hasher;
+    uint64_t contentSize = 0;
+    std::vector<char> buffer(ioBufferSize);
+    while (input) {
+        std::size_t count = readChunk(input, buffer.data(), buffer.size());
+        if (count == 0) {
+            break;
+        }
+        hashChunk(hasher, buffer.data(), count);
+        writeChunk(objectFile, buffer.data(), count);
+        contentSize += count;
+    }
+    objectFile.close();
+    if (!objectFile || input.bad()) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+        throw std::runtime_error("Error writing object file: " + temporary.string());
+    }
+
+    return finishObject(temporary, contentSize, hasher.finish());
+}
+
+/**
+ * @brief Streams a content into the store as independently compressed blocks.
+ *
+ * Batches of blocks are read, compressed in parallel on the shared thread pool while
+ * this thread hashes them, and written in order. Blocks that do not shrink are kept raw,
+ * and contents too small to gain anything are stored uncompressed.
+ * @param input The content to store.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::writeCompressed(std::istream& input) const {
+    ThreadPool& pool = ThreadPool::shared();
+    const std::size_t batchSize = std::min(std::max<std::size_t>(pool.size(), 1), maxBatchBlocks);
+
+    fs::path temporary = createTemporary();
+    try {
+        std::ofstream objectFile(temporary, std::ios::binary);
+        if (!objectFile.is_open()) {
+            throw std::runtime_error("Error opening object file: " + temporary.string());
+        }
+
+        WideHasher hasher;
+        uint64_t contentSize = 0;
+        std::vector<uint32_t> blocks;
+        std::vector<std::vector<char>> raw(batchSize);
+        std::vector<std::vector<char>> packed(batchSize);
+        std::vector<std::size_t> rawSizes(batchSize);
+        std::vector<uint32_t> entries(batchSize);
+        while (input) {
+            std::size_t count = 0;
+            while (count < batchSize) {
+                raw[count].resize(ioBufferSize);
+                rawSizes[count] = readChunk(input, raw[count].data(), ioBufferSize);
+                if (rawSizes[count] == 0) {
+                    break;
+                }
+                if (rawSizes[count++] < ioBufferSize) {
+                    break;
+                }
+            }
+            if (count == 0) {
+                break;
+            }
+            if (contentSize == 0 && count == 1 && rawSizes[0] < minCompressedSize) {
+                hashChunk(hasher, raw[0].data(), rawSizes[0]);
+                writeChunk(objectFile, raw[0].data(), rawSizes[0]);
+                contentSize = rawSizes[0];
+                break;
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            if (count == 1) {
+                entries[0] = compressStoredBlock(raw[0].data(), rawSizes[0], compression_, packed[0]);
+                hashChunk(hasher, raw[0].data(), rawSizes[0]);
+            } else {
+                TaskGroup group(pool);
+                for (std::size_t i = 0; i < count; ++i) {
+                    group.run([&, i] {
+                        entries[i] = compressStoredBlock(raw[i].data(), rawSizes[i], compression_, packed[i]);
+                    });
+                }
+                for (std::size_t i = 0; i < count; ++i) {
+                    hashChunk(hasher, raw[i].data(), rawSizes[i]);
+                }
+                group.wait();
+            }
+            compressNanos_ += elapsedNanos(started);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                writeChunk(objectFile, packed[i].data(), packed[i].size());
+                blocks.push_back(entries[i]);
+                contentSize += rawSizes[i];
+                compressedInput_ += rawSizes[i];
+            }
+        }
+        objectFile.close();
+        if (!objectFile || input.bad()) {
+            throw std::runtime_error("Error writing object file: " + temporary.string());
+        }
+        if (blocks.empty()) {
+            return finishObject(temporary, contentSize, hasher.finish());
+        }
+        return finishObject(temporary, contentSize, hasher.finish(), static_cast<uint8_t>(Codec::LzBlocks),
+                            encodeBlockTable(blocks));
+    } catch (...) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+        throw;
+    }
+}
+
+/**
+ * @brief Streams a content into the store as a list of content-defined chunks.
+ *
+ * The content is read in 8 MiB windows cut with Chunker::cut(); the chunks of a window
+ * are hashed and stored on the shared thread pool while this thread hashes the window,
+ * and chunks the store already has (from any file or version) are not written again.
+ * The object itself only holds the chunk list, so a large file edited in place costs
+ * the few chunks around the edit and a new list.
+ * @param input The content to store.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::writeChunked(std::istream& input) const {
+    ThreadPool& pool = ThreadPool::shared();
+    std::vector<char> window(chunkWindowSize);
+    std::vector<char> list;
+    uint32_t chunkCount = 0;
+    WideHasher hasher;
+    uint64_t contentSize = 0;
+    std::size_t filled = 0;
+    bool ended = false;
+    while (!ended) {
+        filled += readChunk(input, window.data() + filled, window.size() - filled);
+        ended = filled < window.size();
+
+        // Bytes after the end of the window could move the boundary of its last chunk
+        std::vector<std::pair<std::size_t, std::size_t>> chunks;
+        std::size_t position = 0;
+        while (position < filled && (ended || filled - position >= Chunker::maxSize)) {
+            std::size_t length = Chunker::cut(window.data() + position, filled - position);
+            chunks.emplace_back(position, length);
+            position += length;
+        }
+
+        std::vector<std::string> ids(chunks.size());
+        {
+            TaskGroup group(pool);
+            for (std::size_t i = 0; i < chunks.size(); ++i) {
+                group.run([&, i] {
+                    ids[i] = writeBuffer(window.data() + chunks[i].first, chunks[i].second,
+                                         static_cast<uint8_t>(ObjectType::Chunk));
+                });
+            }
+            hashChunk(hasher, window.data(), position);
+            group.wait();
+        }
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            appendChunkEntry(list, ids[i], chunks[i].second);
+        }
+        chunkCount += static_cast<uint32_t>(chunks.size());
+        contentSize += position;
+
+        std::memmove(window.data(), window.data() + position, filled - position);
+        filled -= position;
+    }
+    if (input.bad()) {
+        throw std::runtime_error("Error reading content to store");
+    }
+
+    // The chunks are installed before the list, so a chunked object never misses one
+    fs::path temporary = createTemporary();
+    std::ofstream objectFile(temporary, std::ios::binary);
+    if (!objectFile.is_open()) {
+        throw std::runtime_error("Error opening object file: " + temporary.string());
+    }
+    writeChunk(objectFile, list.data(), list.size());
+    objectFile.close();
+    if (!objectFile) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+        throw std::runtime_error("Error writing object file: " + temporary.string());
+    }
+    std::vector<char> trailer(chunkListTrailerSize);
+    putU32(trailer.data(), chunkCount);
+    return finishObject(temporary, contentSize, hasher.finish(), static_cast<uint8_t>(Codec::Chunked), trailer);
+}
+
+/**
+ * @brief Stores a content held in memory as a single object, unless the store already has it.
+ *
+ * The content is compressed as a single block when that makes it smaller, so it must not
+ * exceed the 1 MiB block size.
+ * @param data The content.
+ * @param size The size of the content.
+ * @param type The object type: a file content or a chunk of a chunked object.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::writeBuffer(const char* data, std::size_t size, uint8_t type) const {
+    WideHasher hasher;
+    hashChunk(hasher, data, size);
+    Digest checksum = hasher.finish();
+    std::string id = checksum.hex();
+    if (contains(id)) {
+        return id;
+    }
+
+    std::vector<char> packed;
+    uint32_t entry = storedRawFlag;
+    if (compression_ != Compression::None && size >= minCompressedSize) {
+        auto started = std::chrono::steady_clock::now();
+        entry = compressStoredBlock(data, size, compression_, packed);
+        compressNanos_ += elapsedNanos(started);
+        compressedInput_ += size;
+    }
+    const bool raw = (entry & storedRawFlag) != 0;
+
+    fs::path temporary = createTemporary();
+    std::ofstream objectFile(temporary, std::ios::binary);
+    if (!objectFile.is_open()) {
+        throw std::runtime_error("Error opening object file: " + temporary.string());
+    }
+    if (raw) {
+        writeChunk(objectFile, data, size);
+    } else {
+        writeChunk(objectFile, packed.data(), packed.size());
+    }
+    objectFile.close();
+    if (!objectFile) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+        throw std::runtime_error("Error writing object file: " + temporary.string());
+    }
+    if (raw) {
+        return finishObject(temporary, size, checksum, static_cast<uint8_t>(Codec::None), {}, type);
+    }
+    return finishObject(temporary, size, checksum, static_cast<uint8_t>(Codec::LzBlocks), encodeBlockTable({entry}), type);
+}
+
+/**
+ * @brief Stores a file as a delta against the previous version of its content.
+ *
+ * The file and the base are held in memory, so this is only tried for files of up to
+ * 32 MiB, and only kept if the delta is under a quarter of the content; the delta chain
+ * of the base must also be shorter than deltaDepth().
+ * @param source The file to store.
+ * @param baseId The id of the previous version.
+ * @param id Receives the id of the content.
+ * @return bool - false if the file was not stored and must be stored in full.
+ */
+bool ObjectStore::writeDelta(const fs::path& source, const std::string& baseId, std::string& id) const {
+    std::error_code ec;
+    uint64_t size = fs::file_size(source, ec);
+    ObjectLocation baseLocation;
+    unsigned baseDepth = 0;
+    if (ec || size < minDeltaSize || size > maxDeltaSize || !deltaBase(baseId, baseLocation, baseDepth)) {
+        return false;
+    }
+
+    // One byte more than expected tells a file that grew since it was measured
+    std::ifstream input(source, std::ios::binary);
+    if (!input.is_open()) {
+        throw std::runtime_error("Error opening source file: " + source.string());
+    }
+    std::vector<char> content(static_cast<std::size_t>(size) + 1);
+    std::size_t count = readChunk(input, content.data(), content.size());
+    if (input.bad() || count > size) {
+        return false;
+    }
+    return encodeDelta(content.data(), count, baseId, baseLocation, baseDepth, id);
+}
+
+/**
+ * @brief Stores a content held in memory as a delta, see writeDelta().
+ * @return bool - false if the content was not stored and must be stored in full.
+ */
+bool ObjectStore::writeDelta(const char* data, std::size_t size, const std::string& baseId, std::string& id) const {
+    ObjectLocation baseLocation;
+    unsigned baseDepth = 0;
+    return size >= minDeltaSize && size <= maxDeltaSize && deltaBase(baseId, baseLocation, baseDepth)
+        && encodeDelta(data, size, baseId, baseLocation, baseDepth, id);
+}
+
+/**
+ * @brief Checks that an object can be the base of a new delta.
+ * @param baseId The id of the base.
+ * @param location Receives where the base is stored.
+ * @param depth Receives the length of the delta chain ending at the base.
+ * @return bool - false if the base is missing, too large or ends a chain of deltaDepth() deltas.
+ */
+bool ObjectStore::deltaBase(const std::string& baseId, ObjectLocation& location, unsigned& depth) const {
+    if (!locate(baseId, location)) {
+        return false;
+    }
+    std::ifstream baseFile(location.file, std::ios::binary);
+    ObjectFooter footer;
+    if (!baseFile.is_open() || !readFooter(baseFile, location, footer) || footer.contentSize > maxDeltaSize) {
+        return false;
+    }
+    depth = 0;
+    std::string baseOfBase;
+    uint64_t payloadSize;
+    if (footer.codec == Codec::Delta && !readDeltaTrailer(baseFile, location, baseOfBase, depth, payloadSize)) {
+        return false;
+    }
+    return depth < deltaDepth_;
+}
+
+/**
+ * @brief Encodes a content against a checked base (see deltaBase()) and keeps the delta if it pays off.
+ * @return bool - false if the content was not stored and must be stored in full.
+ */
+bool ObjectStore::encodeDelta(const char* data, std::size_t size, const std::string& baseId,
+                              const ObjectLocation& baseLocation, unsigned baseDepth, std::string& id) const {
+    WideHasher hasher;
+    hashChunk(hasher, data, size);
+    Digest checksum = hasher.finish();
+    id = checksum.hex();
+    if (contains(id)) {
+        return true;
+    }
+
+    std::vector<char> base;
+    if (!loadContent(baseLocation, base)) {
+        return false;
+    }
+    std::vector<char> delta;
+    {
+        Stats::ScopedTimer timer(Stats::Phase::Compression);
+        Delta::encode(base.data(), base.size(), data, size, delta);
+    }
+    if (delta.size() + baseId.size() + deltaTrailerSize >= size / 4) {
+        return false;
+    }
+
+    fs::path temporary = createTemporary();
+    std::ofstream objectFile(temporary, std::ios::binary);
+    if (!objectFile.is_open()) {
+        throw std::runtime_error("Error opening object file: " + temporary.string());
+    }
+    const char trailer[deltaTrailerSize] = {static_cast<char>(baseId.size()), static_cast<char>(baseDepth + 1)};
+    writeChunk(objectFile, delta.data(), delta.size());
+    objectFile.write(baseId.data(), static_cast<std::streamsize>(baseId.size()));
+    objectFile.write(trailer, deltaTrailerSize);
+    objectFile.close();
+    if (!objectFile) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+        throw std::runtime_error("Error writing object file: " + temporary.string());
+    }
+    id = finishObject(temporary, size, checksum, static_cast<uint8_t>(Codec::Delta));
+    return true;
+}
+
+/**
+ * @brief Appends the footer to a temporary object holding the content and installs it.
+ * @param temporary The temporary object.
+ * @param contentSize The size of the content.
+ * @param checksum The hash of the content, which is also its id.
+ * @param codec How the content is encoded in the temporary object (the footer codec byte).
+ * @param trailer Bytes written before the footer, e.g. the block table of a compressed content.
+ * @param type The object type (the footer type byte): a file content or a chunk of one.
+ * @return std::string - The id of the content.
+ */
+std::string ObjectStore::finishObject(const fs::path& temporary, uint64_t contentSize, const Digest& checksum,
+                                      uint8_t codec, const std::vector<char>& trailer, uint8_t type) const {
+    ObjectFooter footer;
+    footer.type = static_cast<ObjectType>(type);
+    footer.codec = static_cast<Codec>(codec);
+    footer.contentSize = contentSize;
+    footer.checksum = checksum;
+
+    char footerBytes[footerSize];
+    encodeFooter(footer, footerBytes);
+    std::ofstream objectFile(temporary, std::ios::binary | std::ios::app);
+    objectFile.write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+    objectFile.write(footerBytes, footerSize);
+    objectFile.close();
+    if (!objectFile) {
+        std::error_code ec;
+        fs::remove(temporary, ec);
+        throw std::runtime_error("Error writing object file: " + temporary.string());
+    }
+
+    std::string id = footer.checksum.hex();
+    install(temporary, id);
+    return id;
+}
+
+/**
+ * @brief Reads the size of the content of a stored object from its footer.
+ * @param stored The file and byte range holding the object.
+ * @param size Receives the content size.
+ * @return bool - false for legacy files, which have no footer.
+ */
+bool ObjectStore::contentSize(const ObjectLocation& stored, uint64_t& size) const {
+    std::ifstream input(stored.file, std::ios::binary);
+    ObjectFooter footer;
+    if (!input.is_open() || !readFooter(input, stored, footer)) {
+        return false;
+    }
+    size = footer.contentSize;
+    return true;
+}
+
+/**
+ * @brief Computes the id a file would have in the store, without storing it.
+ * @param file The file to hash.
+ * @return std::string - The id of its content.
+ */
+std::string ObjectStore::contentId(const fs::path& file) const {
+    std::ifstream input(file, std::ios::binary);
+    WideHasher hasher;
+    if (!input.is_open() || !hashStream(input, fs::file_size(file), hasher)) {
+        throw std::runtime_error("Error reading file: " + file.string());
+    }
+    return hasher.finish().hex();
+}
+
+/**
+ * @brief Reads a whole object in memory after verifying it; meant for small objects such as trees.
+ * @param id The hex identifier of the object.
+ * @param content Receives the content.
+ * @return bool - false if the object is missing or corrupted.
+ */
+bool ObjectStore::readObject(const std::string& id, std::vector<char>& content) const {
+    ObjectLocation location;
+    return locate(id, location) && loadContent(location, content);
+}
+
+/**
+ * @brief Reads the content of a stored object in memory after verifying it, unless it is too large.
+ * @param stored The file and byte range holding the object.
+ * @param maxSize The largest content read.
+ * @param content Receives the content.
+ * @return bool - false if the object is legacy, corrupted or larger than maxSize.
+ */
+bool ObjectStore::readObject(const ObjectLocation& stored, uint64_t maxSize, std::vector<char>& content) const {
+    return loadContent(stored, content, 0, maxSize);
+}
+
+/**
+ * @brief Writes the content of a stored file to a destination after verifying it.
+ *
+ * Works for objects and for full copies written by older versions. The destination
+ * is removed again if the checksum does not match.
+ * @param storedFile The object or legacy stored file.
+ * @param destination The file receiving the content.
+ * @return bool - false if the stored file is corrupted.
+ */
+bool ObjectStore::restore(const fs::path& storedFile, const fs::path& destination) const {
+    ObjectLocation stored;
+    stored.file = storedFile;
+    stored.length = fs::file_size(storedFile);
+    return restore(stored, destination);
+}
+
+/**
+ * @brief Writes the content of a stored object (loose or packed) to a destination after verifying it.
+ * @param stored The file and byte range holding the object.
+ * @param destination The file receiving the content.
+ * @return bool - false if the stored object is corrupted.
+ */
+bool ObjectStore::restore(const ObjectLocation& stored, const fs::path& destination) const {
+    const fs::path& storedFile = stored.file;
+    std::ifstream inputFile(storedFile, std::ios::binary);
+    if (!inputFile.is_open()) {
+        throw std::runtime_error("Error opening stored file: " + storedFile.string());
+    }
+
+    uint64_t storedSize = stored.length;
+    const std::streamoff base = static_cast<std::streamoff>(stored.offset);
+    if (storedSize < legacyPrefixSize + legacyTrailerSize) {
+        return false;
+    }
+
+    // Objects end with a footer, legacy files with a 4-byte FNV-1a trailer
+    ObjectFooter footer;
+    bool hasFooter = false;
+    if (storedSize >= footerSize) {
+        char footerBytes[footerSize];
+        inputFile.seekg(base + static_cast<std::streamoff>(storedSize - footerSize));
+        inputFile.read(footerBytes, footerSize);
+        hasFooter = inputFile && decodeFooter(footerBytes, storedSize, footer);
+    }
+    if (hasFooter && (footer.codec == Codec::LzBlocks || footer.codec == Codec::Chunked)) {
+        return restoreDecoded(inputFile, stored, static_cast<uint8_t>(footer.codec), footer.contentSize,
+                              footer.checksum, destination);
+    }
+    if (hasFooter && footer.codec == Codec::Delta) {
+        inputFile.close();
+        std::vector<char> content;
+        if (!loadContent(stored, content)) {
+            return false;
+        }
+        std::ofstream outputFile(destination, std::ios::binary);
+        writeChunk(outputFile, content.data(), content.size());
+        outputFile.close();
+        if (!outputFile) {
+            std::error_code ec;
+            fs::remove(destination, ec);
+            throw std::runtime_error("Error writing destination file: " + destination.string());
+        }
+        return true;
+    }
+
+    Digest expected;
+    uint64_t hashedSize;
+    uint64_t skippedPrefix;
+    std::unique_ptr<Hasher> hasher;
+    if (hasFooter) {
+        expected = footer.checksum;
+        hashedSize = footer.contentSize;
+        skippedPrefix = 0;
+        hasher = Hasher::create(footer.algorithm);
+    } else {
+        inputFile.clear();
+        inputFile.seekg(base + static_cast<std::streamoff>(storedSize - legacyTrailerSize));
+        expected.size = legacyTrailerSize;
+        inputFile.read(reinterpret_cast<char*>(expected.bytes), legacyTrailerSize);
+        hashedSize = storedSize - legacyTrailerSize;
+        skippedPrefix = legacyPrefixSize;
+        hasher = Hasher::create(HashAlgorithm::Fnv1a32);
+    }
+    inputFile.clear();
+    inputFile.seekg(base);
+
+    if (copyMode_ != CopyMode::Buffered) {
+        // Verify first, then let the kernel copy (or reflink) the content range
+        bool complete = hashStream(inputFile, hashedSize, *hasher);
+        inputFile.close();
+        if (!complete || hasher->finish() != expected) {
+            return false;
+        }
+        Stats::ScopedTimer timer(Stats::Phase::Io);
+        FastCopy::copyRange(storedFile, stored.offset + skippedPrefix, hashedSize - skippedPrefix, destination, copyMode_);
+        Stats::add(Stats::Counter::BytesWritten, hashedSize - skippedPrefix);
+        return true;
+    }
+
+    // Single pass through user space: hash and write each chunk
+    std::ofstream outputFile(destination, std::ios::binary);
+    if (!outputFile.is_open()) {
+        throw std::runtime_error("Error opening destination file: " + destination.string());
+    }
+    bool complete = copyVerified(inputFile, hashedSize, skippedPrefix, *hasher, outputFile);
+    outputFile.close();
+
+    if (!complete || hasher->finish() != expected) {
+        std::error_code ec;
+        fs::remove(destination, ec);
+        return false;
+    }
+    if (!outputFile) {
+        std::error_code ec;
+        fs::remove(destination, ec);
+        throw std::runtime_error("Error writing destination file: " + destination.string());
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the content of a compressed or chunked object to a destination after verifying it.
+ *
+ * The content is streamed block by block or chunk by chunk, and the destination is
+ * removed again if a block, a chunk or the checksum is corrupted.
+ * @param input The opened stored file.
+ * @param stored The file and byte range holding the object.
+ * @param codec The codec of the object (the footer codec byte).
+ * @param contentSize The size of the raw content.
+ * @param expected The checksum of the raw content.
+ * @param destination The file receiving the content.
+ * @return bool - false if the stored object is corrupted.
+ */
+bool ObjectStore::restoreDecoded(std::istream& input, const ObjectLocation& stored, uint8_t codec,
+                                 uint64_t contentSize, const Digest& expected, const fs::path& destination) const {
+    std::ofstream outputFile(destination, std::ios::binary);
+    if (!outputFile.is_open()) {
+        throw std::runtime_error("Error opening destination file: " + destination.string());
+    }
+
+    WideHasher hasher;
+    auto sink = [&](const char* data, std::size_t size) {
+        hashChunk(hasher, data, size);
+        writeChunk(outputFile, data, size);
+    };
+    bool complete = static_cast<Codec>(codec) == Codec::Chunked
+        ? decodeChunks(input, stored, contentSize, 0, sink)
+        : decodeBlocks(input, stored, contentSize, sink);
+    outputFile.close();
+
+    if (!complete || hasher.finish() != expected) {
+        std::error_code ec;
+        fs::remove(destination, ec);
+        return false;
+    }
+    if (!outputFile) {
+        std::error_code ec;
+        fs::remove(destination, ec);
+        throw std::runtime_error("Error writing destination file: " + destination.string());
+    }
+    return true;
+}
+
+/**
+ * @brief Decompresses the blocks of a compressed object, in content order.
+ *
+ * Batches of blocks are read in order, decompressed in parallel on the shared thread
+ * pool, then passed to the sink in order.
+ * @param input The opened stored file.
+ * @param stored The file and byte range holding the object.
+ * @param contentSize The size of the raw content.
+ * @param sink Receives the raw content, one block at a time.
+ * @return bool - false if the block table or a block is corrupted.
+ */
+bool ObjectStore::decodeBlocks(std::istream& input, const ObjectLocation& stored, uint64_t contentSize,
+                               const std::function<void(const char*, std::size_t)>& sink) const {
+    std::vector<uint32_t> blocks;
+    uint64_t blockSize = 0;
+    if (!readBlockTable(input, stored, contentSize, blocks, blockSize)) {
+        return false;
+    }
+    input.clear();
+    input.seekg(static_cast<std::streamoff>(stored.offset));
+
+    ThreadPool& pool = ThreadPool::shared();
+    const std::size_t batchSize = std::min(std::max<std::size_t>(pool.size(), 1), maxBatchBlocks);
+    std::vector<std::vector<char>> packed(batchSize);
+    std::vector<std::vector<char>> raw(batchSize);
+    std::unique_ptr<bool[]> decoded(new bool[batchSize]);
+    for (std::size_t first = 0; first < blocks.size(); first += batchSize) {
+        std::size_t count = std::min(batchSize, blocks.size() - first);
+        for (std::size_t i = 0; i < count; ++i) {
+            packed[i].resize(blocks[first + i] & ~storedRawFlag);
+            raw[i].resize(static_cast<std::size_t>(std::min(blockSize, contentSize - (first + i) * blockSize)));
+            readChunk(input, packed[i].data(), packed[i].size());
+        }
+        if (!input) {
+            return false;
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        auto decode = [&](std::size_t i) {
+            if ((blocks[first + i] & storedRawFlag) != 0) {
+                raw[i].swap(packed[i]);
+                decoded[i] = true;
+            } else {
+                Stats::ScopedTimer timer(Stats::Phase::Compression);
+                decoded[i] = LzCodec::decompressBlock(packed[i].data(), packed[i].size(), raw[i].data(), raw[i].size());
+            }
+        };
+        if (count == 1) {
+            decode(0);
+        } else {
+            TaskGroup group(pool);
+            for (std::size_t i = 0; i < count; ++i) {
+                group.run([&decode, i] { decode(i); });
+            }
+            group.wait();
+        }
+        decompressNanos_ += elapsedNanos(started);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!decoded[i]) {
+                return false;
+            }
+            sink(raw[i].data(), raw[i].size());
+            decompressedOutput_ += raw[i].size();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the chunks of a chunked object, in content order.
+ *
+ * Batches of chunks are located and loaded (each one verified) in parallel on the shared
+ * thread pool, then passed to the sink in order.
+ * @param input The opened stored file.
+ * @param stored The file and byte range holding the object.
+ * @param contentSize The size of the raw content.
+ * @param level Number of objects already being rebuilt above this one.
+ * @param sink Receives the raw content, one chunk at a time.
+ * @return bool - false if the chunk list or a chunk is missing or corrupted.
+ */
+bool ObjectStore::decodeChunks(std::istream& input, const ObjectLocation& stored, uint64_t contentSize,
+                               unsigned level, const std::function<void(const char*, std::size_t)>& sink) const {
+    std::vector<ChunkEntry> chunks;
+    if (level >= maxDeltaWalk || !readChunkList(input, stored, contentSize, chunks)) {
+        return false;
+    }
+
+    ThreadPool& pool = ThreadPool::shared();
+    const std::size_t batchSize = std::min(std::max<std::size_t>(pool.size(), 1) * 4, maxBatchChunks);
+    std::vector<std::vector<char>> contents(batchSize);
+    std::unique_ptr<bool[]> loaded(new bool[batchSize]);
+    for (std::size_t first = 0; first < chunks.size(); first += batchSize) {
+        std::size_t count = std::min(batchSize, chunks.size() - first);
+        auto load = [&](std::size_t i) {
+            const ChunkEntry& chunk = chunks[first + i];
+            ObjectLocation location;
+            loaded[i] = locate(chunk.id, location) && loadContent(location, contents[i], level + 1)
+                && contents[i].size() == chunk.size;
+        };
+        if (count == 1) {
+            load(0);
+        } else {
+            TaskGroup group(pool);
+            for (std::size_t i = 0; i < count; ++i) {
+                group.run([&load, i] { load(i); });
+            }
+            group.wait();
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!loaded[i]) {
+                return false;
+            }
+            sink(contents[i].data(), contents[i].size());
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the whole content of an object in memory and verifies it.
+ *
+ * Delta objects are rebuilt from their base, which is loaded the same way, and chunked
+ * objects are assembled from their chunks.
+ * @param stored The file and byte range holding the object.
+ * @param content Receives the content.
+ * @param level Number of deltas already being rebuilt above this object.
+ * @param maxSize The largest content loaded.
+ * @return bool - false if the object (or a base) is missing, legacy, corrupted or too large.
+ */
+bool ObjectStore::loadContent(const ObjectLocation& stored, std::vector<char>& content, unsigned level,
+                              uint64_t maxSize) const {
+    std::ifstream input(stored.file, std::ios::binary);
+    if (!input.is_open()) {
+        throw std::runtime_error("Error opening stored file: " + stored.file.string());
+    }
+    ObjectFooter footer;
+    if (!readFooter(input, stored, footer) || footer.contentSize > maxSize) {
+        return false;
+    }
+
+    content.clear();
+    content.reserve(static_cast<std::size_t>(footer.contentSize));
+    if (footer.codec == Codec::None) {
+        content.resize(static_cast<std::size_t>(footer.contentSize));
+        input.clear();
+        input.seekg(static_cast<std::streamoff>(stored.offset));
+        readChunk(input, content.data(), content.size());
+        if (!input) {
+            return false;
+        }
+    } else if (footer.codec == Codec::LzBlocks) {
+        bool complete = decodeBlocks(input, stored, footer.contentSize, [&content](const char* data, std::size_t size) {
+            content.insert(content.end(), data, data + size);
+        });
+        if (!complete) {
+            return false;
+        }
+    } else if (footer.codec == Codec::Chunked) {
+        bool complete = decodeChunks(input, stored, footer.contentSize, level, [&content](const char* data, std::size_t size) {
+            content.insert(content.end(), data, data + size);
+        });
+        if (!complete) {
+            return false;
+        }
+    } else {
+        std::string baseId;
+        unsigned depth;
+        uint64_t payloadSize;
+        ObjectLocation baseLocation;
+        if (level >= maxDeltaWalk || !readDeltaTrailer(input, stored, baseId, depth, payloadSize)
+            || !locate(baseId, baseLocation)) {
+            return false;
+        }
+        std::vector<char> payload(static_cast<std::size_t>(payloadSize));
+        input.seekg(static_cast<std::streamoff>(stored.offset));
+        readChunk(input, payload.data(), payload.size());
+        input.close();
+        std::vector<char> base;
+        if (!input || !loadContent(baseLocation, base, level + 1)) {
+            return false;
+        }
+        Stats::ScopedTimer timer(Stats::Phase::Compression);
+        if (!Delta::apply(base.data(), base.size(), payload.data(), payload.size(), content)) {
+            return false;
+        }
+    }
+
+    WideHasher hasher;
+    hashChunk(hasher, content.data(), content.size());
+    return content.size() == footer.contentSize && hasher.finish() == footer.checksum;
+}
+
+/**
+ * @brief Moves every loose object into a new pack file.
+ *
+ * The pack is written and indexed under temporary names and renamed into place (pack
+ * first, index last) before the loose copies are removed, so readers always find each
+ * object either loose or packed. Must not run concurrently with add().
+ * @return std::size_t - The number of objects packed.
+ */
+std::size_t ObjectStore::pack() const {
+    std::vector<std::pair<std::string, fs::path>> loose = looseObjects();
+    if (loose.empty()) {
+        return 0;
+    }
+    std::sort(loose.begin(), loose.end());
+
+    fs::path packDirectory = root_ / "pack";
+    fs::create_directories(packDirectory);
+    fs::path temporaryPack = createTemporary();
+    std::vector<PackIndex::Entry> entries;
+    WideHasher nameHasher;
+    {
+        std::ofstream packFile(temporaryPack, std::ios::binary);
+        if (!packFile.is_open()) {
+            throw std::runtime_error("Error opening pack file: " + temporaryPack.string());
+        }
+        packFile.write(packMagic, packHeaderSize);
+
+        uint64_t offset = packHeaderSize;
+        std::vector<char> buffer(ioBufferSize);
+        for (const auto& object : loose) {
+            std::ifstream objectFile(object.second, std::ios::binary);
+            PackIndex::Entry entry;
+            entry.id = object.first;
+            entry.offset = offset;
+            while (objectFile) {
+                std::size_t count = readChunk(objectFile, buffer.data(), buffer.size());
+                writeChunk(packFile, buffer.data(), count);
+                entry.length += count;
+            }
+            offset += entry.length;
+            nameHasher.update(object.first);
+            entries.push_back(std::move(entry));
+        }
+        packFile.close();
+        if (!packFile) {
+            std::error_code ec;
+            fs::remove(temporaryPack, ec);
+            throw std::runtime_error("Error writing pack file: " + temporaryPack.string());
+        }
+    }
+
+    std::string name = "pack-" + nameHasher.finish().hex();
+    fs::path temporaryIndex = createTemporary();
+    PackIndex::write(temporaryIndex, entries);
+    fs::rename(temporaryPack, packDirectory / (name + ".pack"));
+    fs::rename(temporaryIndex, packDirectory / (name + ".idx"));
+    {
+        std::unique_lock<std::shared_mutex> lock(packMutex_);
+        packsLoaded_ = false;
+    }
+
+    std::error_code ec;
+    for (const auto& object : loose) {
+        fs::remove(object.second, ec);
+        fs::remove(object.second.parent_path(), ec);  // Only succeeds once the directory is empty
+    }
+    return loose.size();
+}
+
+/**
+ * @brief Lists the loose objects of the store.
+ * @return std::vector<std::pair<std::string, fs::path>> - The id and file of each loose object.
+ */
+std::vector<std::pair<std::string, fs::path>> ObjectStore::looseObjects() const {
+    std::vector<std::pair<std::string, fs::path>> loose;
+    for (const auto& directory : fs::directory_iterator(root_)) {
+        std::string prefix = directory.path().filename().string();
+        if (!directory.is_directory() || prefix.size() != 2) {
+            continue;
+        }
+        for (const auto& entry : fs::directory_iterator(directory.path())) {
+            if (entry.is_regular_file()) {
+                loose.emplace_back(prefix + entry.path().filename().string(), entry.path());
+            }
+        }
+    }
+    return loose;
+}
+
+/**
+ * @brief Reports the storage ratio of the repository and the compression throughput.
+ *
+ * Sizes come from the footers of the loose and packed objects; throughputs are measured
+ * over the blocks compressed and decompressed by this store since it was created.
+ * @return StorageReport - The statistics.
+ */
+StorageReport ObjectStore::storageReport() const {
+    StorageReport report;
+    auto account = [&report](std::istream& input, const ObjectLocation& stored) {
+        ObjectFooter footer;
+        ++report.objects;
+        report.storedBytes += stored.length;
+        if (!readFooter(input, stored, footer)) {
+            report.contentBytes += stored.length - std::min<uint64_t>(stored.length, legacyPrefixSize + legacyTrailerSize);
+            return;
+        }
+        // The content of chunks is already counted by the chunked objects listing them
+        if (footer.type == ObjectType::Chunk) {
+            ++report.chunks;
+        } else {
+            report.contentBytes += footer.contentSize;
+        }
+        if (footer.codec == Codec::LzBlocks) {
+            ++report.compressedObjects;
+        } else if (footer.codec == Codec::Delta) {
+            ++report.deltaObjects;
+        } else if (footer.codec == Codec::Chunked) {
+            ++report.chunkedObjects;
+        }
+    };
+
+    for (const auto& object : looseObjects()) {
+        std::ifstream input(object.second, std::ios::binary);
+        ObjectLocation stored;
+        stored.file = object.second;
+        stored.length = fs::file_size(object.second);
+        account(input, stored);
+    }
+    for (const auto& pack : packs()) {
+        std::ifstream input(pack->packFile(), std::ios::binary);
+        for (std::size_t i = 0; i < pack->size(); ++i) {
+            ObjectLocation stored;
+            if (pack->find(pack->idAt(i), stored)) {
+                account(input, stored);
+            }
+        }
+    }
+
+    report.compressedInput = compressedInput_;
+    report.compressSeconds = compressNanos_ / 1e9;
+    report.decompressedOutput = decompressedOutput_;
+    report.decompressSeconds = decompressNanos_ / 1e9;
+    return report;
+}
+
+/**
+ * @brief Builds the content of a reference file pointing to an object.
+ * @param id The hex identifier of the object.
+ * @return std::string - The reference file content.
+ */
+std::string ObjectStore::makeReference(const std::string& id) {
+    return referencePrefix + id + "\n";
+}
+
+/**
+ * @brief Extracts the object id from the content of a reference file.
+ * @param content The content of a staged or committed file.
+ * @param id Receives the object id when the content is a reference.
+ * @return bool - false if the content is not a reference (e.g. a legacy full copy).
+ */
+bool ObjectStore::parseReference(const std::string& content, std::string& id) {
+    if (content.compare(0, referencePrefix.size(), referencePrefix) != 0) {
+        return false;
+    }
+    std::size_t end = content.find('\n', referencePrefix.size());
+    if (end == std::string::npos) {
+        end = content.size();
+    }
+    id = content.substr(referencePrefix.size(), end - referencePrefix.size());
+    return !id.empty();
+}
+
+/**
+ * @brief Returns the storage ratio.
+ * @return double - Content bytes per stored byte (1 when nothing is stored).
+ */
+double StorageReport::ratio() const {
+    return storedBytes == 0 ? 1.0 : static_cast<double>(contentBytes) / storedBytes;
+}
+
+/**
+ * @brief Returns the compression throughput.
+ * @return double - Raw MB compressed per second, 0 if nothing was compressed.
+ */
+double StorageReport::compressThroughput() const {
+    return compressSeconds <= 0 ? 0.0 : compressedInput / 1e6 / compressSeconds;
+}
+
+/**
+ * @brief Returns the decompression throughput.
+ * @return double - Raw MB restored per second, 0 if nothing was decompressed.
+ */
+double StorageReport::decompressThroughput() const {
+    return decompressSeconds <= 0 ? 0.0 : decompressedOutput / 1e6 / decompressSeconds;
+}
+
+/**
+ * @brief Formats the report on one line.
+ * @return std::string - The summary.
+ */
+std::string StorageReport::summary() const {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2)
+         << objects << " objects (" << compressedObjects << " compressed, " << deltaObjects << " deltas, "
+         << chunkedObjects << " chunked in " << chunks << " chunks), "
+         << contentBytes << " content bytes in " << storedBytes << " stored bytes, ratio " << ratio()
+         << ", compression " << compressThroughput() << " MB/s, decompression " << decompressThroughput() << " MB/s";
+    return text.str();
+}
@@ -0,0 +1,150 @@
+#ifndef OBJECTSTORE_H
+#define OBJECTSTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <checksum.h>
+#include <fastcopy.h>
+#include <lzcodec.h>
+#include <packfile.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Storage statistics of a repository: what the objects take on disk and how fast
+ * the compression stage ran during this session.
+ */
+struct StorageReport
+{
+    std::size_t objects = 0;
+    std::size_t compressedObjects = 0;
+    std::size_t deltaObjects = 0;
+    std::size_t chunkedObjects = 0;
+    std::size_t chunks = 0;
+    uint64_t contentBytes = 0;
+    uint64_t storedBytes = 0;
+    uint64_t compressedInput = 0;
+    double compressSeconds = 0;
+    uint64_t decompressedOutput = 0;
+    double decompressSeconds = 0;
+
+    double ratio() const;
+    double compressThroughput() const;
+    double decompressThroughput() const;
+    std::string summary() const;
+};
+
+/**
+ * @brief Content-addressable blob store living under .git/objects.
+ *
+ * Every unique file content is written once to .git/objects/xx/yyyy..., where
+ * xxyyyy... is the hex identifier of the content. The staging area and the
+ * commits only hold small reference files pointing into the store.
+ *
+ * An object holds the raw content followed by a 32-byte footer: the magic "MGO1",
+ * the hash algorithm, the object type and codec bytes, the content size and the 128-bit
+ * checksum of the content. Files written by older versions ("1234" + content +
+ * 4-byte FNV-1a trailer) are still accepted by restore().
+ *
+ * When compression is on, the content is split into 1 MiB blocks compressed independently
+ * (on the shared thread pool) and the object holds the compressed blocks, a table of their
+ * sizes, the block count and block size, then the footer with the codec byte set. The id
+ * is always the checksum of the raw content, so it does not depend on the compression.
+ *
+ * A new version of a path can also be stored as a delta against the previous version's
+ * object: the copy/insert instructions, the hex id of the base, its length and the depth
+ * of the delta chain, then the footer. Chains are at most deltaDepth() long, so rebuilding
+ * a version never takes more than that many delta applications.
+ *
+ * Files of at least chunkThreshold() bytes are split into content-defined chunks (see
+ * Chunker) stored as objects of their own, with the chunk type in the footer; the object
+ * of the file lists the size and id of each chunk, then the chunk count and the footer.
+ * Identical chunks are stored once whatever file or version they come from.
+ *
+ * pack() moves the loose objects into an immutable pack file under .git/objects/pack
+ * with a sorted index, so that repositories with many small files do not need one
+ * inode per object. Objects are looked up loose first, then in the packs.
+ */
+class ObjectStore
+{
+public:
+    explicit ObjectStore(const fs::path& root = ".git/objects");
+
+    void init() const;
+
+    fs::path objectPath(const std::string& id) const;
+    bool contains(const std::string& id) const;
+    bool locate(const std::string& id, ObjectLocation& location) const;
+    fs::path createTemporary() const;
+    void install(const fs::path& temporary, const std::string& id) const;
+
+    void setCopyMode(CopyMode mode);
+    CopyMode copyMode() const;
+    void setCompression(Compression level);
+    Compression compression() const;
+    void setDeltaDepth(unsigned depth);
+    unsigned deltaDepth() const;
+    void setChunkThreshold(uint64_t size);
+    uint64_t chunkThreshold() const;
+
+    std::string writeFile(const fs::path& source, const std::string& baseId = std::string()) const;
+    std::string writeBlob(std::istream& input) const;
+    std::string writeContent(const char* data, std::size_t size, const std::string& baseId = std::string()) const;
+    bool contentSize(const ObjectLocation& stored, uint64_t& size) const;
+    std::string contentId(const fs::path& file) const;
+    bool readObject(const std::string& id, std::vector<char>& content) const;
+    bool readObject(const ObjectLocation& stored, uint64_t maxSize, std::vector<char>& content) const;
+    bool restore(const fs::path& storedFile, const fs::path& destination) const;
+    bool restore(const ObjectLocation& stored, const fs::path& destination) const;
+
+    std::size_t pack() const;
+    StorageReport storageReport() const;
+
+    static std::string makeReference(const std::string& id);
+    static bool parseReference(const std::string& content, std::string& id);
+
+private:
+    std::string writeCompressed(std::istream& input) const;
+    bool writeDelta(const fs::path& source, const std::string& baseId, std::string& id) const;
+    bool writeDelta(const char* data, std::size_t size, const std::string& baseId, std::string& id) const;
+    bool deltaBase(const std::string& baseId, ObjectLocation& location, unsigned& depth) const;
+    bool encodeDelta(const char* data, std::size_t size, const std::string& baseId, const ObjectLocation& baseLocation,
+                     unsigned baseDepth, std::string& id) const;
+    std::string writeChunked(std::istream& input) const;
+    std::string writeBuffer(const char* data, std::size_t size, uint8_t type) const;
+    bool restoreDecoded(std::istream& input, const ObjectLocation& stored, uint8_t codec, uint64_t contentSize,
+                        const Digest& expected, const fs::path& destination) const;
+    bool decodeBlocks(std::istream& input, const ObjectLocation& stored, uint64_t contentSize,
+                      const std::function<void(const char*, std::size_t)>& sink) const;
+    bool decodeChunks(std::istream& input, const ObjectLocation& stored, uint64_t contentSize, unsigned level,
+                      const std::function<void(const char*, std::size_t)>& sink) const;
+    bool loadContent(const ObjectLocation& stored, std::vector<char>& content, unsigned level = 0,
+                     uint64_t maxSize = UINT64_MAX) const;
+    std::string finishObject(const fs::path& temporary, uint64_t contentSize, const Digest& checksum,
+                             uint8_t codec = 0, const std::vector<char>& trailer = {}, uint8_t type = 0) const;
+    std::vector<std::pair<std::string, fs::path>> looseObjects() const;
+    std::vector<std::shared_ptr<PackIndex>> packs() const;
+
+    fs::path root_;
+    CopyMode copyMode_;
+    Compression compression_;
+    unsigned deltaDepth_ = 8;
+    uint64_t chunkThreshold_ = 8 << 20;
+    mutable std::atomic<uint64_t> compressedInput_{0};
+    mutable std::atomic<uint64_t> compressNanos_{0};
+    mutable std::atomic<uint64_t> decompressedOutput_{0};
+    mutable std::atomic<uint64_t> decompressNanos_{0};
+    mutable std::shared_mutex packMutex_;
+    mutable std::vector<std::shared_ptr<PackIndex>> packs_;
+    mutable bool packsLoaded_ = false;
+};
+
+#endif // OBJECTSTORE_H
@@ -0,0 +1,244 @@
+#include <packfile.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char indexMagic[] = "MGPI";
+const uint32_t indexVersion = 1;
+const std::size_t headerSize = 16;
+const std::size_t idBytes = 16;
+const std::size_t entrySize = 40;
+
+uint64_t readU64(const unsigned char* p) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+void putU64(unsigned char* p, uint64_t value) {
+    for (std::size_t i = 0; i < 8; ++i) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * Encodes a hex id as the 17-byte sort key of the index: 16 zero-padded bytes and the length.
+ */
+bool encodeId(const std::string& id, unsigned char key[idBytes + 1]) {
+    if (id.empty() || id.size() % 2 != 0 || id.size() > 2 * idBytes) {
+        return false;
+    }
+    std::memset(key, 0, idBytes + 1);
+    for (std::size_t i = 0; i < id.size() / 2; ++i) {
+        int high = hexValue(id[2 * i]);
+        int low = hexValue(id[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        key[i] = static_cast<unsigned char>(high << 4 | low);
+    }
+    key[idBytes] = static_cast<unsigned char>(id.size() / 2);
+    return true;
+}
+
+}
+
+/**
+ * @brief Maps a file in memory.
+ * @param path The file to map.
+ */
+MappedFile::MappedFile(const fs::path& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Error opening " + path.string());
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Error reading " + path.string());
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* map = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            data_ = static_cast<const unsigned char*>(map);
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+    if (mapped_ || size_ == 0) {
+        return;
+    }
+#endif
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        throw std::runtime_error("Error opening " + path.string());
+    }
+    copy_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    data_ = copy_.data();
+    size_ = copy_.size();
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+}
+
+/**
+ * @brief Opens the index of a pack.
+ * @param indexFile The .idx file; the pack is the .pack file with the same name.
+ */
+PackIndex::PackIndex(const fs::path& indexFile) : map_(indexFile) {
+    packFile_ = indexFile;
+    packFile_.replace_extension(".pack");
+
+    if (map_.size() < headerSize || std::memcmp(map_.data(), indexMagic, 4) != 0) {
+        throw std::runtime_error("Invalid pack index: " + indexFile.string());
+    }
+    uint32_t version = map_.data()[4] | map_.data()[5] << 8 | map_.data()[6] << 16
+                     | static_cast<uint32_t>(map_.data()[7]) << 24;
+    count_ = static_cast<std::size_t>(readU64(map_.data() + 8));
+    if (version != indexVersion || map_.size() != headerSize + count_ * entrySize) {
+        throw std::runtime_error("Invalid pack index: " + indexFile.string());
+    }
+}
+
+/**
+ * @brief Looks an object up with a binary search over the sorted entries.
+ * @param id The hex id of the object.
+ * @param location Receives the pack file, offset and length of the object.
+ * @return bool - true if the pack holds the object.
+ */
+bool PackIndex::find(const std::string& id, ObjectLocation& location) const {
+    unsigned char key[idBytes + 1];
+    if (!encodeId(id, key)) {
+        return false;
+    }
+
+    std::size_t low = 0;
+    std::size_t high = count_;
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        int order = std::memcmp(entryAt(middle), key, idBytes + 1);
+        if (order == 0) {
+            const unsigned char* entry = entryAt(middle);
+            location.file = packFile_;
+            location.offset = readU64(entry + 24);
+            location.length = readU64(entry + 32);
+            return true;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the number of objects in the pack.
+ * @return std::size_t - The number of entries.
+ */
+std::size_t PackIndex::size() const {
+    return count_;
+}
+
+/**
+ * @brief Returns the id of an entry.
+ * @param position The entry, in id order.
+ * @return std::string - The hex id.
+ */
+std::string PackIndex::idAt(std::size_t position) const {
+    static const char digits[] = "0123456789abcdef";
+    const unsigned char* entry = entryAt(position);
+    std::string id;
+    for (std::size_t i = 0; i < entry[idBytes]; ++i) {
+        id += digits[entry[i] >> 4];
+        id += digits[entry[i] & 0xf];
+    }
+    return id;
+}
+
+/**
+ * @brief Returns the pack file this index describes.
+ * @return const fs::path& - The .pack file.
+ */
+const fs::path& PackIndex::packFile() const {
+    return packFile_;
+}
+
+/**
+ * @brief Writes the index of a pack.
+ * @param indexFile The .idx file to create.
+ * @param entries The objects of the pack, in any order.
+ */
+void PackIndex::write(const fs::path& indexFile, std::vector<Entry> entries) {
+    std::vector<unsigned char> data(headerSize + entries.size() * entrySize, 0);
+    std::memcpy(data.data(), indexMagic, 4);
+    data[4] = static_cast<unsigned char>(indexVersion);
+    putU64(data.data() + 8, entries.size());
+
+    std::vector<std::pair<std::vector<unsigned char>, const Entry*>> keyed;
+    keyed.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        std::vector<unsigned char> key(idBytes + 1);
+        if (!encodeId(entry.id, key.data())) {
+            throw std::runtime_error("Invalid object id: " + entry.id);
+        }
+        keyed.emplace_back(std::move(key), &entry);
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    unsigned char* out = data.data() + headerSize;
+    for (const auto& item : keyed) {
+        std::memcpy(out, item.first.data(), idBytes + 1);
+        putU64(out + 24, item.second->offset);
+        putU64(out + 32, item.second->length);
+        out += entrySize;
+    }
+
+    std::ofstream output(indexFile, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    output.close();
+    if (!output) {
+        throw std::runtime_error("Error writing pack index: " + indexFile.string());
+    }
+}
+
+/**
+ * @brief Returns a pointer to an entry of the mapped index.
+ */
+const unsigned char* PackIndex::entryAt(std::size_t position) const {
+    return map_.data() + headerSize + position * entrySize;
+}
@@ -0,0 +1,80 @@
+#ifndef PACKFILE_H
+#define PACKFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Where the bytes of a stored object live: a loose file or a range of a pack.
+ */
+struct ObjectLocation
+{
+    fs::path file;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file (read into memory where mmap is missing).
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const fs::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<unsigned char> copy_;
+    bool mapped_ = false;
+};
+
+/**
+ * @brief Sorted offset index of a pack file (pack-<name>.idx next to pack-<name>.pack).
+ *
+ * A pack is the concatenation of objects exactly as they are stored loose (content and
+ * footer), written once and never modified. Its index is a header ("MGPI", version,
+ * count) followed by fixed-size entries sorted by id: 16 id bytes, the id length, padding,
+ * the offset and the length of the object in the pack. The index is memory mapped and a
+ * lookup is a binary search.
+ */
+class PackIndex
+{
+public:
+    struct Entry
+    {
+        std::string id;
+        uint64_t offset = 0;
+        uint64_t length = 0;
+    };
+
+    explicit PackIndex(const fs::path& indexFile);
+
+    bool find(const std::string& id, ObjectLocation& location) const;
+    std::size_t size() const;
+    std::string idAt(std::size_t position) const;
+    const fs::path& packFile() const;
+
+    static void write(const fs::path& indexFile, std::vector<Entry> entries);
+
+private:
+    const unsigned char* entryAt(std::size_t position) const;
+
+    fs::path packFile_;
+    MappedFile map_;
+    std::size_t count_ = 0;
+};
+
+#endif // PACKFILE_H
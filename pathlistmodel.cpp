@@ -0,0 +1,303 @@
+#include "pathlistmodel.h"
+
+#include <QBrush>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace {
+
+// Rows handed to the view per fetchMore()
+const std::size_t fetchBatch = 1000;
+
+// Past this many changed ranges, one reset is cheaper than the row signals
+const std::size_t maxChangedRanges = 256;
+
+struct Change
+{
+    bool insert;
+    std::size_t row;    // In the list as it is when the change is applied
+    std::size_t first;  // Insertions: position in the new list
+    std::size_t count;
+};
+
+}
+
+PathListModel::PathListModel(QObject* parent) : QAbstractListModel(parent) {
+}
+
+int PathListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(fetched_);
+}
+
+QVariant PathListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() < 0 || static_cast<std::size_t>(index.row()) >= fetched_) {
+        return QVariant();
+    }
+    std::size_t row = static_cast<std::size_t>(index.row());
+    if (role == Qt::DisplayRole) {
+        QString text = QString::fromStdString(entries_[row]);
+        if (numbered_) {
+            text += " - Version: " + QString::number(row + 1);
+        }
+        auto tag = tags_.find(entries_[row]);
+        if (tag != tags_.end()) {
+            text += "  [" + QString::fromStdString(tag->second) + "]";
+        }
+        return text;
+    }
+    if (role == Qt::BackgroundRole && selected_[row]) {
+        return QBrush(Qt::yellow);
+    }
+    return QVariant();
+}
+
+bool PathListModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && fetched_ < entries_.size();
+}
+
+void PathListModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) {
+        return;
+    }
+    std::size_t count = std::min(fetchBatch, entries_.size() - fetched_);
+    if (count == 0) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), static_cast<int>(fetched_), static_cast<int>(fetched_ + count - 1));
+    fetched_ += count;
+    endInsertRows();
+}
+
+/**
+ * @brief Replaces the list, only touching the rows that changed.
+ * @param entries The new names, in any order; they are sorted (see setOrder()) and deduplicated.
+ */
+void PathListModel::setEntries(std::vector<std::string> entries) {
+    std::sort(entries.begin(), entries.end(), [this](const std::string& a, const std::string& b) {
+        return before(a, b);
+    });
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    // Merge both sorted lists into runs of removed and inserted names
+    std::vector<Change> changes;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    std::size_t row = 0;
+    while (i < entries_.size() || j < entries.size()) {
+        if (i < entries_.size() && j < entries.size() && entries_[i] == entries[j]) {
+            ++i;
+            ++j;
+            ++row;
+        } else if (j == entries.size() || (i < entries_.size() && before(entries_[i], entries[j]))) {
+            std::size_t end = i;
+            while (end < entries_.size() && (j == entries.size() || before(entries_[end], entries[j]))) {
+                ++end;
+            }
+            changes.push_back({false, row, 0, end - i});
+            i = end;
+        } else {
+            std::size_t end = j;
+            while (end < entries.size() && (i == entries_.size() || before(entries[end], entries_[i]))) {
+                ++end;
+            }
+            changes.push_back({true, row, j, end - j});
+            row += end - j;
+            j = end;
+        }
+    }
+    if (changes.empty()) {
+        return;
+    }
+
+    if (changes.size() > maxChangedRanges) {
+        // Too scattered: reset, keeping the selection of the names still there
+        std::vector<bool> selected(entries.size(), false);
+        std::size_t selectedCount = 0;
+        for (i = 0, j = 0; i < entries_.size() && j < entries.size();) {
+            if (entries_[i] == entries[j]) {
+                if (selected_[i]) {
+                    selected[j] = true;
+                    ++selectedCount;
+                }
+                ++i;
+                ++j;
+            } else if (before(entries_[i], entries[j])) {
+                ++i;
+            } else {
+                ++j;
+            }
+        }
+        beginResetModel();
+        entries_ = std::move(entries);
+        selected_ = std::move(selected);
+        selectedCount_ = selectedCount;
+        fetched_ = std::min(entries_.size(), fetchBatch);
+        endResetModel();
+        return;
+    }
+
+    for (const Change& change : changes) {
+        if (change.insert) {
+            auto first = entries.begin() + static_cast<std::ptrdiff_t>(change.first);
+            insertRange(change.row, first, first + static_cast<std::ptrdiff_t>(change.count));
+        } else {
+            removeRange(change.row, change.row + change.count);
+        }
+    }
+    if (fetched_ < std::min(entries_.size(), fetchBatch)) {
+        fetchMore(QModelIndex());
+    }
+    if (numbered_ && fetched_ > 0) {
+        // The numbers of the rows after a change moved
+        emit dataChanged(index(0), index(static_cast<int>(fetched_ - 1)), {Qt::DisplayRole});
+    }
+}
+
+/**
+ * @brief Returns the name at a row.
+ */
+const std::string& PathListModel::entry(int row) const {
+    return entries_.at(static_cast<std::size_t>(row));
+}
+
+void PathListModel::setNumbered(bool numbered) {
+    numbered_ = numbered;
+    if (fetched_ > 0) {
+        emit dataChanged(index(0), index(static_cast<int>(fetched_ - 1)), {Qt::DisplayRole});
+    }
+}
+
+/**
+ * @brief Sets the order of the names, e.g. MiniVersionControl::olderVersion for versions,
+ * so the rows and their numbers follow the order of the core.
+ * @param less Strict weak order; names it finds equivalent are in byte order.
+ */
+void PathListModel::setOrder(std::function<bool(const std::string&, const std::string&)> less) {
+    less_ = std::move(less);
+    if (entries_.empty()) {
+        return;
+    }
+
+    // Sort the current names again, along with their selection
+    std::vector<std::size_t> order(entries_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return before(entries_[a], entries_[b]);
+    });
+    std::vector<std::string> entries;
+    std::vector<bool> selected;
+    entries.reserve(order.size());
+    selected.reserve(order.size());
+    for (std::size_t i : order) {
+        entries.push_back(std::move(entries_[i]));
+        selected.push_back(selected_[i]);
+    }
+    beginResetModel();
+    entries_ = std::move(entries);
+    selected_ = std::move(selected);
+    endResetModel();
+}
+
+void PathListModel::setTags(std::unordered_map<std::string, std::string> tags) {
+    tags_ = std::move(tags);
+    if (fetched_ > 0) {
+        emit dataChanged(index(0), index(static_cast<int>(fetched_ - 1)), {Qt::DisplayRole});
+    }
+}
+
+void PathListModel::toggleSelected(int row) {
+    if (row < 0 || static_cast<std::size_t>(row) >= entries_.size()) {
+        return;
+    }
+    std::size_t position = static_cast<std::size_t>(row);
+    selected_[position] = !selected_[position];
+    if (selected_[position]) {
+        ++selectedCount_;
+    } else {
+        --selectedCount_;
+    }
+    emit dataChanged(index(row), index(row), {Qt::BackgroundRole});
+}
+
+void PathListModel::selectAll() {
+    selected_.assign(entries_.size(), true);
+    selectedCount_ = entries_.size();
+    if (fetched_ > 0) {
+        emit dataChanged(index(0), index(static_cast<int>(fetched_ - 1)), {Qt::BackgroundRole});
+    }
+}
+
+void PathListModel::clearSelection() {
+    selected_.assign(entries_.size(), false);
+    selectedCount_ = 0;
+    if (fetched_ > 0) {
+        emit dataChanged(index(0), index(static_cast<int>(fetched_ - 1)), {Qt::BackgroundRole});
+    }
+}
+
+std::size_t PathListModel::selectedCount() const {
+    return selectedCount_;
+}
+
+/**
+ * @brief Returns the selected names, in list order.
+ */
+std::vector<std::string> PathListModel::selectedEntries() const {
+    std::vector<std::string> result;
+    result.reserve(selectedCount_);
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        if (selected_[i]) {
+            result.push_back(entries_[i]);
+        }
+    }
+    return result;
+}
+
+// The order of the rows: less_, then byte order among the names it finds equivalent.
+bool PathListModel::before(const std::string& a, const std::string& b) const {
+    if (less_(a, b)) {
+        return true;
+    }
+    return !less_(b, a) && a < b;
+}
+
+// Removes rows [first, last); only the part the view already fetched is signalled.
+void PathListModel::removeRange(std::size_t first, std::size_t last) {
+    std::size_t visibleEnd = std::min(last, fetched_);
+    bool visible = first < visibleEnd;
+    if (visible) {
+        beginRemoveRows(QModelIndex(), static_cast<int>(first), static_cast<int>(visibleEnd - 1));
+    }
+    for (std::size_t i = first; i < last; ++i) {
+        if (selected_[i]) {
+            --selectedCount_;
+        }
+    }
+    entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(first),
+                   entries_.begin() + static_cast<std::ptrdiff_t>(last));
+    selected_.erase(selected_.begin() + static_cast<std::ptrdiff_t>(first),
+                    selected_.begin() + static_cast<std::ptrdiff_t>(last));
+    if (visible) {
+        fetched_ -= visibleEnd - first;
+        endRemoveRows();
+    }
+}
+
+// Inserts names before a row; rows past what the view fetched are fetched later.
+void PathListModel::insertRange(std::size_t row, std::vector<std::string>::iterator first,
+                                std::vector<std::string>::iterator last) {
+    std::size_t count = static_cast<std::size_t>(last - first);
+    bool visible = row < fetched_;
+    if (visible) {
+        beginInsertRows(QModelIndex(), static_cast<int>(row), static_cast<int>(row + count - 1));
+    }
+    entries_.insert(entries_.begin() + static_cast<std::ptrdiff_t>(row),
+                    std::make_move_iterator(first), std::make_move_iterator(last));
+    selected_.insert(selected_.begin() + static_cast<std::ptrdiff_t>(row), count, false);
+    if (visible) {
+        fetched_ += count;
+        endInsertRows();
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef PATHLISTMODEL_H
+#define PATHLISTMODEL_H
+
+#include <QAbstractListModel>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Sorted list of names (files, staged entries or versions) for a QListView.
+ *
+ * Rows are handed to the view in batches as it scrolls (canFetchMore/fetchMore), so a
+ * 200k-entry list costs one vector of strings and no per-row widget. setEntries() diffs
+ * the new list against the current one and only inserts and removes the rows that
+ * changed, keeping the scroll position and the selection of the other rows. The
+ * selection is one bit per entry and is drawn as a yellow background.
+ */
+class PathListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit PathListModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    void setEntries(std::vector<std::string> entries);
+    const std::string& entry(int row) const;
+
+    // Versions are shown as "<name> - Version: <number>"
+    void setNumbered(bool numbered);
+
+    // Sorts the names with this order instead of their byte order
+    void setOrder(std::function<bool(const std::string&, const std::string&)> less);
+
+    // Shown after the names they belong to as "<name>  [<tag>]"; names without one show alone
+    void setTags(std::unordered_map<std::string, std::string> tags);
+
+    void toggleSelected(int row);
+    void selectAll();
+    void clearSelection();
+    std::size_t selectedCount() const;
+    std::vector<std::string> selectedEntries() const;
+
+private:
+    bool before(const std::string& a, const std::string& b) const;
+    void removeRange(std::size_t first, std::size_t last);
+    void insertRange(std::size_t row, std::vector<std::string>::iterator first,
+                     std::vector<std::string>::iterator last);
+
+    std::vector<std::string> entries_;
+    std::vector<bool> selected_;
+    std::size_t selectedCount_ = 0;
+    std::size_t fetched_ = 0;  // Rows the view knows about
+    bool numbered_ = false;
+    std::function<bool(const std::string&, const std::string&)> less_ = std::less<std::string>();
+    std::unordered_map<std::string, std::string> tags_;
+};
+
+#endif // PATHLISTMODEL_H
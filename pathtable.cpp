@@ -0,0 +1,178 @@
+#include <pathtable.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+/**
+ * @brief Appends the files and directories under a directory, in one walk.
+ *
+ * Only regular files and directories are listed; a symbolic link is listed as what it
+ * points to, but the walk does not follow links to directories.
+ * @param root The directory to walk; entries are relative to it.
+ * @param onDirectory Called before each directory is read, for example to stop the walk
+ * by throwing.
+ * @param filter The ignore rules at root: ignored entries are left out, ignored directories
+ * are not read.
+ */
+void PathTable::scan(const fs::path& root, const std::function<void()>& onDirectory, const IgnoreFilter& filter) {
+    const std::string rootPath = root.string();
+    std::string directoryPath;
+    std::vector<std::pair<uint32_t, IgnoreRules::State>> pending{{noParent, filter.state}};
+    std::vector<std::pair<uint32_t, IgnoreRules::State>> subdirectories;
+    while (!pending.empty()) {
+        auto [directory, state] = pending.back();
+        pending.pop_back();
+        if (onDirectory) {
+            onDirectory();
+        }
+        directoryPath = rootPath;
+        if (directory != noParent) {
+            directoryPath += '/';
+            appendPath(directory, directoryPath);
+        }
+
+        subdirectories.clear();
+        for (const auto& entry : fs::directory_iterator(directoryPath)) {
+            std::error_code ec;
+            bool isDirectory = entry.is_directory(ec);
+            if (!isDirectory && !entry.is_regular_file(ec)) {
+                continue;
+            }
+            std::string name = entry.path().filename().string();
+            IgnoreRules::State childState = IgnoreRules::none;
+            if (filter.rules != nullptr && state != IgnoreRules::none) {
+                bool ignored;
+                childState = filter.rules->descend(state, name, isDirectory, ignored);
+                if (ignored) {
+                    continue;
+                }
+            }
+            uint32_t index = add(directory, name, isDirectory);
+            if (isDirectory && !entry.is_symlink(ec)) {
+                subdirectories.emplace_back(index, childState);
+            }
+        }
+        // Read in the order they were met
+        pending.insert(pending.end(), subdirectories.rbegin(), subdirectories.rend());
+    }
+}
+
+/**
+ * @brief Appends an entry.
+ * @param parent The index of its directory, noParent for an entry directly under the root.
+ * @param name Its file name.
+ * @param directory Whether it is a directory.
+ * @return uint32_t - Its index.
+ */
+uint32_t PathTable::add(uint32_t parent, std::string_view name, bool directory) {
+    Entry entry;
+    entry.parent = parent;
+    entry.name = intern(name);
+    entry.directory = directory;
+    entries_.push_back(entry);
+    return static_cast<uint32_t>(entries_.size() - 1);
+}
+
+/**
+ * @brief Removes every entry and name, keeping the memory for the next walk.
+ */
+void PathTable::clear() {
+    entries_.clear();
+    names_.clear();
+    nameOffsets_.assign(1, 0);
+    std::fill(slots_.begin(), slots_.end(), 0);
+}
+
+/**
+ * @brief Returns the file name of an entry; valid until the next entry is added.
+ */
+std::string_view PathTable::name(uint32_t index) const {
+    return nameText(entries_[index].name);
+}
+
+/**
+ * @brief Appends the path of an entry relative to the root, with '/' separators.
+ *
+ * The path is written from its end, once its length is known, so out only grows once
+ * and does not allocate at all when its capacity suffices.
+ * @param index The entry.
+ * @param out Receives the path after its current content.
+ */
+void PathTable::appendPath(uint32_t index, std::string& out) const {
+    std::size_t length = 0;
+    for (uint32_t i = index; i != noParent; i = entries_[i].parent) {
+        length += nameText(entries_[i].name).size() + 1;
+    }
+    std::size_t end = out.size() + length - 1;
+    out.resize(end);
+    for (uint32_t i = index;;) {
+        std::string_view text = nameText(entries_[i].name);
+        end -= text.size();
+        std::memcpy(&out[end], text.data(), text.size());
+        i = entries_[i].parent;
+        if (i == noParent) {
+            break;
+        }
+        out[--end] = '/';
+    }
+}
+
+uint32_t PathTable::intern(std::string_view name) {
+    std::size_t mask = slots_.size() - 1;
+    for (std::size_t slot = std::hash<std::string_view>()(name) & mask;; slot = (slot + 1) & mask) {
+        uint32_t id = slots_[slot];
+        if (id == 0) {
+            uint32_t added = static_cast<uint32_t>(nameOffsets_.size() - 1);
+            names_.append(name.data(), name.size());
+            nameOffsets_.push_back(static_cast<uint32_t>(names_.size()));
+            slots_[slot] = added + 1;
+            // Kept at most half full
+            if (2 * nameCount() > slots_.size()) {
+                growSlots();
+            }
+            return added;
+        }
+        if (nameText(id - 1) == name) {
+            return id - 1;
+        }
+    }
+}
+
+std::string_view PathTable::nameText(uint32_t name) const {
+    return std::string_view(names_.data() + nameOffsets_[name], nameOffsets_[name + 1] - nameOffsets_[name]);
+}
+
+void PathTable::growSlots() {
+    std::vector<uint32_t> slots(slots_.size() * 2, 0);
+    std::size_t mask = slots.size() - 1;
+    for (uint32_t name = 0; name < nameCount(); ++name) {
+        std::size_t slot = std::hash<std::string_view>()(nameText(name)) & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = name + 1;
+    }
+    slots_.swap(slots);
+}
+
+/**
+ * @brief Appends prefix, the path of a table entry and suffix as one NUL-terminated path.
+ * @return std::size_t - Its position in the list.
+ */
+std::size_t PathList::add(const std::string& prefix, const PathTable& table, uint32_t index, const char* suffix) {
+    offsets_.push_back(buffer_.size());
+    buffer_ += prefix;
+    table.appendPath(index, buffer_);
+    buffer_ += suffix;
+    buffer_ += '\0';
+    return offsets_.size() - 1;
+}
+
+/**
+ * @brief Removes every path, keeping the memory.
+ */
+void PathList::clear() {
+    buffer_.clear();
+    offsets_.clear();
+}
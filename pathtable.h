@@ -0,0 +1,84 @@
+#ifndef PATHTABLE_H
+#define PATHTABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ignorerules.h>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief The files and directories under a root, as one flat table.
+ *
+ * Every entry is the index of its parent directory and the id of its name. Names are
+ * interned: each distinct one is stored once in a single contiguous arena, so a walk
+ * costs a few growing buffers instead of several path objects per entry. Entries are
+ * appended while walking and a directory always comes before what it contains, which
+ * lets a copy create directories by going through the table in order. Paths are only
+ * built on demand, into buffers the caller reuses (appendPath(), PathList).
+ *
+ * scan() walks with std::filesystem, one directory after the other; DirScanner::scan()
+ * fills the same table with native, parallel directory reads.
+ */
+class PathTable
+{
+public:
+    static const uint32_t noParent = UINT32_MAX;
+
+    struct Entry
+    {
+        uint32_t parent = noParent;  // Entries directly under the root have none
+        uint32_t name = 0;           // Interned name id
+        bool directory = false;
+    };
+
+    void scan(const fs::path& root, const std::function<void()>& onDirectory = nullptr,
+              const IgnoreFilter& filter = IgnoreFilter());
+    uint32_t add(uint32_t parent, std::string_view name, bool directory);
+    void clear();
+
+    std::size_t size() const { return entries_.size(); }
+    const Entry& operator[](uint32_t index) const { return entries_[index]; }
+    std::string_view name(uint32_t index) const;
+    void appendPath(uint32_t index, std::string& out) const;
+
+    std::size_t nameCount() const { return nameOffsets_.size() - 1; }
+    std::size_t arenaBytes() const { return names_.size(); }
+
+private:
+    uint32_t intern(std::string_view name);
+    std::string_view nameText(uint32_t name) const;
+    void growSlots();
+
+    std::vector<Entry> entries_;
+    std::string names_;                           // Every distinct name, back to back
+    std::vector<uint32_t> nameOffsets_{0};        // Start of each name, then the arena end
+    std::vector<uint32_t> slots_ = std::vector<uint32_t>(1024, 0);  // Name id + 1, 0 when free
+};
+
+/**
+ * @brief NUL-terminated paths built back to back into one buffer.
+ *
+ * The pointers returned by operator[] stay valid until the next add() or clear().
+ */
+class PathList
+{
+public:
+    std::size_t add(const std::string& prefix, const PathTable& table, uint32_t index, const char* suffix = "");
+    void clear();
+
+    std::size_t size() const { return offsets_.size(); }
+    const char* operator[](std::size_t i) const { return buffer_.c_str() + offsets_[i]; }
+
+private:
+    std::string buffer_;
+    std::vector<std::size_t> offsets_;
+};
+
+#endif // PATHTABLE_H
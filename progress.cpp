@@ -0,0 +1,99 @@
+#include <progress.h>
+
+namespace {
+
+int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+/**
+ * @brief Returns the part of the work done, between 0 and 1.
+ */
+double Progress::Snapshot::fraction() const {
+    if (filesTotal == 0) {
+        return totalKnown ? 1.0 : 0.0;
+    }
+    return static_cast<double>(filesDone) / static_cast<double>(filesTotal);
+}
+
+/**
+ * @brief Resets the counters and the cancellation for a new operation.
+ */
+void Progress::start() {
+    filesDone_ = 0;
+    filesTotal_ = 0;
+    bytesDone_ = 0;
+    totalKnown_ = false;
+    cancelled_ = false;
+    startedNanos_ = nowNanoseconds();
+}
+
+/**
+ * @brief Counts files found by the walk.
+ * @param files The number of files queued.
+ */
+void Progress::addQueued(uint64_t files) {
+    filesTotal_.fetch_add(files, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Marks the total number of files as final.
+ */
+void Progress::finishQueueing() {
+    totalKnown_ = true;
+}
+
+/**
+ * @brief Counts a finished file.
+ * @param bytes The size of its content.
+ */
+void Progress::addDone(uint64_t bytes) {
+    filesDone_.fetch_add(1, std::memory_order_relaxed);
+    bytesDone_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Asks the running operation to stop. Safe to call from any thread.
+ */
+void Progress::cancel() {
+    cancelled_ = true;
+}
+
+/**
+ * @brief Returns whether the running operation was asked to stop.
+ */
+bool Progress::cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Throws OperationCancelled if the running operation was asked to stop.
+ */
+void Progress::throwIfCancelled() const {
+    if (cancelled()) {
+        throw OperationCancelled();
+    }
+}
+
+/**
+ * @brief Reads the counters and estimates the remaining time.
+ * @return Snapshot - The progress so far.
+ */
+Progress::Snapshot Progress::snapshot() const {
+    Snapshot snapshot;
+    snapshot.filesDone = filesDone_.load(std::memory_order_relaxed);
+    snapshot.filesTotal = filesTotal_.load(std::memory_order_relaxed);
+    snapshot.bytesDone = bytesDone_.load(std::memory_order_relaxed);
+    snapshot.totalKnown = totalKnown_.load();
+    snapshot.elapsedSeconds = (nowNanoseconds() - startedNanos_.load()) / 1e9;
+
+    // Files left at the rate of the files done so far
+    if (snapshot.totalKnown && snapshot.filesDone > 0 && snapshot.filesTotal >= snapshot.filesDone) {
+        snapshot.remainingSeconds = snapshot.elapsedSeconds * (snapshot.filesTotal - snapshot.filesDone) /
+                                    snapshot.filesDone;
+    }
+    return snapshot;
+}
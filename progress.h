@@ -0,0 +1,61 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * @brief Thrown by an operation that stopped because it was cancelled.
+ */
+class OperationCancelled : public std::runtime_error
+{
+public:
+    OperationCancelled() : std::runtime_error("Operation cancelled") {}
+};
+
+/**
+ * @brief Progress and cancellation of the running add, commit or revert.
+ *
+ * The operation updates relaxed atomic counters from the worker threads; a user
+ * interface polls snapshot() from its own thread at its frame rate, so per-file
+ * updates never wait for it. cancel() is checked before every file: the files already
+ * written stay valid, the rest are skipped and the operation throws OperationCancelled.
+ */
+class Progress
+{
+public:
+    struct Snapshot
+    {
+        uint64_t filesDone = 0;
+        uint64_t filesTotal = 0;    // Grows while the tree is walked
+        uint64_t bytesDone = 0;
+        bool totalKnown = false;    // The walk is over: filesTotal is final
+        double elapsedSeconds = 0;
+        double remainingSeconds = -1; // -1 while it cannot be estimated
+
+        double fraction() const;
+    };
+
+    void start();
+    void addQueued(uint64_t files = 1);
+    void finishQueueing();
+    void addDone(uint64_t bytes);
+
+    void cancel();
+    bool cancelled() const;
+    void throwIfCancelled() const;
+
+    Snapshot snapshot() const;
+
+private:
+    std::atomic<uint64_t> filesDone_{0};
+    std::atomic<uint64_t> filesTotal_{0};
+    std::atomic<uint64_t> bytesDone_{0};
+    std::atomic<bool> totalKnown_{false};
+    std::atomic<bool> cancelled_{false};
+    std::atomic<int64_t> startedNanos_{0};
+};
+
+#endif // PROGRESS_H
@@ -0,0 +1,449 @@
+#include <statindex.h>
+#include <stats.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const char indexMagic[] = "MGIX";
+const uint32_t indexVersion = 1;
+
+// Keys are paths and ids short hashes: anything longer is a corrupted index
+const uint32_t maxKeySize = 64 << 10;
+const uint32_t maxIdSize = 1 << 10;
+
+void writeU64(std::ostream& out, uint64_t value) {
+    char bytes[8];
+    for (std::size_t i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>(value >> (8 * i));
+    }
+    out.write(bytes, 8);
+}
+
+void writeU32(std::ostream& out, uint32_t value) {
+    char bytes[4];
+    for (std::size_t i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<char>(value >> (8 * i));
+    }
+    out.write(bytes, 4);
+}
+
+uint64_t readU64(std::istream& in) {
+    unsigned char bytes[8] = {};
+    in.read(reinterpret_cast<char*>(bytes), 8);
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+uint32_t readU32(std::istream& in) {
+    unsigned char bytes[4] = {};
+    in.read(reinterpret_cast<char*>(bytes), 4);
+    uint32_t value = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+int64_t nowNanoseconds() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+/**
+ * @brief Reads the stat data of a file.
+ * @param path The file.
+ * @param stat Receives the stat data.
+ * @return bool - false if the file cannot be accessed.
+ */
+bool FileStat::read(const fs::path& path, FileStat& stat) {
+#ifndef _WIN32
+    return read(path.c_str(), stat);
+#else
+    Stats::ScopedTimer timer(Stats::Phase::Metadata);
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    std::uintmax_t size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    stat.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    stat.size = size;
+    stat.inode = 0;
+    return true;
+#endif
+}
+
+/**
+ * @brief Reads the stat data of a file named by a NUL-terminated path, such as one built
+ * into a PathList, without making a path object of it.
+ * @param path The file.
+ * @param stat Receives the stat data.
+ * @return bool - false if the file cannot be accessed.
+ */
+bool FileStat::read(const char* path, FileStat& stat) {
+#ifndef _WIN32
+    Stats::ScopedTimer timer(Stats::Phase::Metadata);
+    struct ::stat info;
+    if (::stat(path, &info) != 0) {
+        return false;
+    }
+#if defined(__APPLE__)
+    stat.mtime = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    stat.mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    stat.size = static_cast<uint64_t>(info.st_size);
+    stat.inode = static_cast<uint64_t>(info.st_ino);
+    return true;
+#else
+    return read(fs::path(path), stat);
+#endif
+}
+
+/**
+ * @brief Compares two stat records.
+ * @param other The record to compare with.
+ * @return bool - true if nothing changed.
+ */
+bool FileStat::operator==(const FileStat& other) const {
+    return mtime == other.mtime && size == other.size && inode == other.inode;
+}
+
+/**
+ * @brief StatIndex constructor; the file is only read by load().
+ * @param file The index file.
+ */
+StatIndex::StatIndex(const fs::path& file) : file_(file) {
+}
+
+/**
+ * @brief Reads the index file, unless it did not change since it was last loaded or saved.
+ *
+ * A missing or unreadable index starts empty. Changes not saved yet are dropped when
+ * another process rewrote the file: the index is only a cache.
+ */
+void StatIndex::load() {
+    Stats::ScopedTimer timer(Stats::Phase::Metadata);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    FileStat current;
+    if (!FileStat::read(file_, current)) {
+        current = FileStat();
+    }
+    if (loaded_ && current == loadedStat_) {
+        return;
+    }
+    loaded_ = true;
+    loadedStat_ = current;
+    dirty_ = false;
+    entries_.clear();
+
+    std::ifstream input(file_, std::ios::binary);
+    if (!input.is_open()) {
+        return;
+    }
+
+    char magic[4] = {};
+    input.read(magic, 4);
+    if (!input || std::memcmp(magic, indexMagic, 4) != 0 || readU32(input) != indexVersion) {
+        return;
+    }
+    savedAt_ = static_cast<int64_t>(readU64(input));
+    uint64_t count = readU64(input);
+
+    for (uint64_t i = 0; i < count && input; ++i) {
+        uint32_t keySize = readU32(input);
+        if (keySize > maxKeySize || keySize > current.size) {
+            input.setstate(std::ios::failbit);
+            break;
+        }
+        std::string key(keySize, '\0');
+        input.read(&key[0], keySize);
+
+        Entry entry;
+        entry.stat.mtime = static_cast<int64_t>(readU64(input));
+        entry.stat.size = readU64(input);
+        entry.stat.inode = readU64(input);
+        char flags = 0;
+        input.read(&flags, 1);
+        entry.staged = (flags & 1) != 0;
+        uint32_t idSize = readU32(input);
+        if (idSize > maxIdSize) {
+            input.setstate(std::ios::failbit);
+            break;
+        }
+        entry.id.resize(idSize);
+        input.read(&entry.id[0], idSize);
+
+        if (input) {
+            entries_[key] = std::move(entry);
+        }
+    }
+    if (!input) {
+        // A truncated or corrupted index is only a cache: drop it rather than trust part of it
+        entries_.clear();
+    }
+}
+
+/**
+ * @brief Writes the index file if it changed, through a temporary file.
+ */
+void StatIndex::save() {
+    Stats::ScopedTimer timer(Stats::Phase::Metadata);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!dirty_) {
+        return;
+    }
+
+    std::vector<const std::pair<const std::string, Entry>*> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto& item : entries_) {
+        sorted.push_back(&item);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    fs::path temporary = file_;
+    temporary += ".tmp";
+    std::ofstream output(temporary, std::ios::binary);
+    if (!output.is_open()) {
+        throw std::runtime_error("Error opening index file: " + temporary.string());
+    }
+
+    int64_t savedAt = nowNanoseconds();
+    output.write(indexMagic, 4);
+    writeU32(output, indexVersion);
+    writeU64(output, static_cast<uint64_t>(savedAt));
+    writeU64(output, sorted.size());
+    for (const auto* item : sorted) {
+        const Entry& entry = item->second;
+        writeU32(output, static_cast<uint32_t>(item->first.size()));
+        output.write(item->first.data(), static_cast<std::streamsize>(item->first.size()));
+        writeU64(output, static_cast<uint64_t>(entry.stat.mtime));
+        writeU64(output, entry.stat.size);
+        writeU64(output, entry.stat.inode);
+        char flags = entry.staged ? 1 : 0;
+        output.write(&flags, 1);
+        writeU32(output, static_cast<uint32_t>(entry.id.size()));
+        output.write(entry.id.data(), static_cast<std::streamsize>(entry.id.size()));
+    }
+    output.close();
+    if (!output) {
+        throw std::runtime_error("Error writing index file: " + temporary.string());
+    }
+
+    std::error_code ec;
+    fs::rename(temporary, file_, ec);
+    if (ec) {
+        fs::remove(file_, ec);
+        fs::rename(temporary, file_);
+    }
+    savedAt_ = savedAt;
+    dirty_ = false;
+    // The file now holds this copy: the next load() keeps it unless another process saves
+    if (!FileStat::read(file_, loadedStat_)) {
+        loadedStat_ = FileStat();
+    }
+    loaded_ = true;
+}
+
+/**
+ * @brief Looks a path up and marks it as seen by the current add().
+ * @param key The path relative to the staging area.
+ * @param stat The current stat data of the source file.
+ * @param id Receives the content id when the stat data still matches.
+ * @return Match - What is left to do for this file.
+ */
+StatIndex::Match StatIndex::lookup(const std::string& key, const FileStat& stat, std::string& id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return Match::Unknown;
+        }
+        const Entry& entry = it->second;
+        if (!(entry.stat == stat) || entry.stat.mtime >= savedAt_ || entry.id.empty()) {
+            return Match::Unknown;
+        }
+        id = entry.id;
+        if (!entry.staged) {
+            return Match::Hashed;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    entries_[key].visit = visit_;
+    return Match::Staged;
+}
+
+/**
+ * @brief Records the stat data and content id of a path and marks it as seen.
+ * @param key The path relative to the staging area.
+ * @param stat The stat data read before the file was hashed.
+ * @param id The content id.
+ * @param staged Whether a reference to this content is now in the staging area.
+ */
+void StatIndex::record(const std::string& key, const FileStat& stat, const std::string& id, bool staged) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    Entry& entry = entries_[key];
+    entry.stat = stat;
+    entry.id = id;
+    entry.staged = staged;
+    entry.visit = visit_;
+    dirty_ = true;
+}
+
+/**
+ * @brief Starts a new add(): entries recorded or looked up from now on are marked with the returned visit.
+ * @return uint32_t - The visit number.
+ */
+uint32_t StatIndex::startVisit() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return ++visit_;
+}
+
+/**
+ * @brief Records the stat data of a file found (or written) with a known content, outside of add().
+ *
+ * The staged flag is kept when the id does not change; an entry staged with another
+ * content is left alone, the file will simply be hashed again by the next add().
+ * @param key The path relative to the staging area.
+ * @param stat The stat data of the file.
+ * @param id The content id of the file.
+ */
+void StatIndex::refresh(const std::string& key, const FileStat& stat, const std::string& id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        Entry& entry = entries_[key];
+        entry.stat = stat;
+        entry.id = id;
+    } else if (it->second.id == id) {
+        it->second.stat = stat;
+    } else if (!it->second.staged) {
+        it->second.stat = stat;
+        it->second.id = id;
+    } else {
+        return;
+    }
+    dirty_ = true;
+}
+
+/**
+ * @brief Returns the id last recorded for a path, whatever its stat data.
+ *
+ * Entries survive commits, so this is the content the path had in the latest version
+ * that included it (or in the staging area).
+ * @param key The path relative to the staging area.
+ * @param id Receives the content id.
+ * @return bool - false if the path was never recorded.
+ */
+bool StatIndex::recordedId(const std::string& key, std::string& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.id.empty()) {
+        return false;
+    }
+    id = it->second.id;
+    return true;
+}
+
+/**
+ * @brief Checks whether the index knows staged files under a path.
+ * @param prefix The path relative to the staging area.
+ * @return bool - true if at least one staged entry is the path or below it.
+ */
+bool StatIndex::hasStagedUnder(const std::string& prefix) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& item : entries_) {
+        if (item.second.staged && isUnder(item.first, prefix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Lists the staged entries under a path that were not seen since a visit started.
+ * @param prefix The path relative to the staging area.
+ * @param visit The visit returned by startVisit().
+ * @return std::vector<std::string> - Staged paths whose source disappeared.
+ */
+std::vector<std::string> StatIndex::unvisitedStagedUnder(const std::string& prefix, uint32_t visit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<std::string> result;
+    for (const auto& item : entries_) {
+        if (item.second.staged && item.second.visit != visit && isUnder(item.first, prefix)) {
+            result.push_back(item.first);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Marks a path and everything below it as no longer staged.
+ * @param prefix The path relative to the staging area.
+ */
+void StatIndex::unstage(const std::string& prefix) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& item : entries_) {
+        if (item.second.staged && isUnder(item.first, prefix)) {
+            item.second.staged = false;
+            dirty_ = true;
+        }
+    }
+}
+
+/**
+ * @brief Marks every path as no longer staged, e.g. after a commit emptied the staging area.
+ */
+void StatIndex::unstageAll() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto& item : entries_) {
+        if (item.second.staged) {
+            item.second.staged = false;
+            dirty_ = true;
+        }
+    }
+}
+
+/**
+ * @brief Lists the top-level names of every recorded path: what add() was ever given.
+ * @return std::vector<std::string> - The names, sorted.
+ */
+std::vector<std::string> StatIndex::roots() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<std::string> result;
+    for (const auto& item : entries_) {
+        result.push_back(item.first.substr(0, item.first.find('/')));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+/**
+ * @brief Checks whether a key is a path or lies below it.
+ */
+bool StatIndex::isUnder(const std::string& key, const std::string& prefix) {
+    if (key.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    return key.size() == prefix.size() || key[prefix.size()] == '/';
+}
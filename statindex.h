@@ -0,0 +1,88 @@
+#ifndef STATINDEX_H
+#define STATINDEX_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief The stat data used to tell whether a file changed since it was last hashed.
+ */
+struct FileStat
+{
+    int64_t mtime = 0;   // Modification time in nanoseconds
+    uint64_t size = 0;
+    uint64_t inode = 0;  // 0 where the platform has no inode numbers
+
+    static bool read(const fs::path& path, FileStat& stat);
+    static bool read(const char* path, FileStat& stat);
+    bool operator==(const FileStat& other) const;
+};
+
+/**
+ * @brief Persistent stat cache stored in .git/index.
+ *
+ * For every path of the staging area (relative to .git/staging, which is also the path
+ * relative to the repository root for files added from there) it records the stat data
+ * of the source file, the id of its content and whether that content is currently staged.
+ * add() uses it to skip reading and hashing files whose stat data did not change.
+ *
+ * Entries whose modification time is not older than the moment the index was saved are
+ * "racily clean" (the file may have changed within the same timestamp) and are never trusted.
+ * Several processes may share the index (the GUI and the CLI): load() reads it again
+ * whenever the file changed since this process last loaded or saved it.
+ */
+class StatIndex
+{
+public:
+    enum class Match {
+        Unknown,  // The file must be hashed
+        Hashed,   // The id is known, the reference must still be written
+        Staged    // The file is already staged with this content
+    };
+
+    explicit StatIndex(const fs::path& file = ".git/index");
+
+    void load();
+    void save();
+
+    Match lookup(const std::string& key, const FileStat& stat, std::string& id);
+    void record(const std::string& key, const FileStat& stat, const std::string& id, bool staged);
+    void refresh(const std::string& key, const FileStat& stat, const std::string& id);
+    bool recordedId(const std::string& key, std::string& id) const;
+
+    uint32_t startVisit();
+    bool hasStagedUnder(const std::string& prefix) const;
+    std::vector<std::string> unvisitedStagedUnder(const std::string& prefix, uint32_t visit) const;
+    void unstage(const std::string& prefix);
+    void unstageAll();
+    std::vector<std::string> roots() const;
+
+private:
+    struct Entry
+    {
+        FileStat stat;
+        std::string id;
+        bool staged = false;
+        uint32_t visit = 0;  // Not persisted: last add() that saw the entry
+    };
+
+    static bool isUnder(const std::string& key, const std::string& prefix);
+
+    fs::path file_;
+    bool loaded_ = false;
+    FileStat loadedStat_;  // Of the file as last loaded or saved; all zero when it was missing
+    bool dirty_ = false;
+    int64_t savedAt_ = 0;
+    uint32_t visit_ = 0;
+    std::unordered_map<std::string, Entry> entries_;
+    mutable std::shared_mutex mutex_;
+};
+
+#endif // STATINDEX_H
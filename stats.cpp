@@ -0,0 +1,266 @@
+#include <stats.h>
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// One cache line per value, so threads updating different counters do not contend
+struct alignas(64) PaddedCounter
+{
+    std::atomic<uint64_t> value{0};
+};
+
+PaddedCounter counterValues[Stats::counterCount];
+PaddedCounter phaseValues[Stats::phaseCount];
+
+std::mutex reportsMutex;
+std::vector<Stats::OperationReport> finished;
+
+double seconds(uint64_t nanoseconds) {
+    return nanoseconds / 1e9;
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+}
+
+namespace Stats {
+
+/**
+ * @brief Increments a counter.
+ * @param counter The counter.
+ * @param amount The increment.
+ */
+void add(Counter counter, uint64_t amount) {
+    counterValues[static_cast<std::size_t>(counter)].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds time to a phase.
+ * @param phase The phase.
+ * @param nanoseconds The time spent in it by one thread.
+ */
+void addTime(Phase phase, uint64_t nanoseconds) {
+    phaseValues[static_cast<std::size_t>(phase)].value.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the peak resident memory of the process.
+ * @return uint64_t - The peak in bytes, 0 where it is not available.
+ */
+uint64_t peakMemoryBytes() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Returns the name of a counter, as used in the reports.
+ */
+const char* counterName(Counter counter) {
+    switch (counter) {
+    case Counter::FilesScanned:
+        return "files_scanned";
+    case Counter::BytesRead:
+        return "bytes_read";
+    case Counter::BytesHashed:
+        return "bytes_hashed";
+    case Counter::BytesWritten:
+        return "bytes_written";
+    case Counter::LockWaitNanos:
+        return "lock_wait_ns";
+    case Counter::LockContentions:
+        return "lock_contentions";
+    case Counter::Count:
+        break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Returns the name of a phase, as used in the reports.
+ */
+const char* phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::Traversal:
+        return "traversal";
+    case Phase::Hashing:
+        return "hashing";
+    case Phase::Compression:
+        return "compression";
+    case Phase::Io:
+        return "io";
+    case Phase::Metadata:
+        return "metadata";
+    case Phase::Count:
+        break;
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Reads all the counters and phase times.
+ * @return Snapshot - Their current values.
+ */
+Snapshot Snapshot::take() {
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < counterCount; ++i) {
+        snapshot.counters[i] = counterValues[i].value.load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < phaseCount; ++i) {
+        snapshot.phaseNanos[i] = phaseValues[i].value.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+/**
+ * @brief Returns what changed since an earlier snapshot.
+ */
+Snapshot Snapshot::operator-(const Snapshot& earlier) const {
+    Snapshot difference;
+    for (std::size_t i = 0; i < counterCount; ++i) {
+        difference.counters[i] = counters[i] - earlier.counters[i];
+    }
+    for (std::size_t i = 0; i < phaseCount; ++i) {
+        difference.phaseNanos[i] = phaseNanos[i] - earlier.phaseNanos[i];
+    }
+    return difference;
+}
+
+/**
+ * @brief Starts measuring an operation.
+ * @param name The name of the operation (add, commit, revert...).
+ */
+Operation::Operation(std::string name)
+    : name_(std::move(name)), start_(Snapshot::take()), started_(std::chrono::steady_clock::now()) {
+}
+
+/**
+ * @brief Records the report of the operation.
+ */
+Operation::~Operation() {
+    OperationReport report;
+    report.name = std::move(name_);
+    report.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    report.totals = Snapshot::take() - start_;
+    report.peakMemoryBytes = peakMemoryBytes();
+
+    std::lock_guard<std::mutex> lock(reportsMutex);
+    finished.push_back(std::move(report));
+}
+
+/**
+ * @brief Returns the reports of the operations finished so far.
+ * @return std::vector<OperationReport> - The reports, oldest first.
+ */
+std::vector<OperationReport> reports() {
+    std::lock_guard<std::mutex> lock(reportsMutex);
+    return finished;
+}
+
+/**
+ * @brief Forgets the reports of the finished operations.
+ */
+void clearReports() {
+    std::lock_guard<std::mutex> lock(reportsMutex);
+    finished.clear();
+}
+
+/**
+ * @brief Formats reports as a human readable breakdown.
+ * @param reports The reports.
+ * @return std::string - One block per operation.
+ */
+std::string formatText(const std::vector<OperationReport>& reports) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(3);
+    for (const OperationReport& report : reports) {
+        const Snapshot& totals = report.totals;
+        text << report.name << ": " << report.wallSeconds << " s wall, peak memory "
+             << std::setprecision(1) << report.peakMemoryBytes / 1048576.0 << " MiB\n" << std::setprecision(3);
+        text << "  files scanned  " << totals.counters[static_cast<std::size_t>(Counter::FilesScanned)] << "\n";
+        text << "  bytes read     " << totals.counters[static_cast<std::size_t>(Counter::BytesRead)] << "\n";
+        text << "  bytes hashed   " << totals.counters[static_cast<std::size_t>(Counter::BytesHashed)] << "\n";
+        text << "  bytes written  " << totals.counters[static_cast<std::size_t>(Counter::BytesWritten)] << "\n";
+        text << "  lock wait      " << seconds(totals.counters[static_cast<std::size_t>(Counter::LockWaitNanos)])
+             << " s (" << totals.counters[static_cast<std::size_t>(Counter::LockContentions)] << " contended)\n";
+        text << "  phases (thread-seconds):";
+        for (std::size_t i = 0; i < phaseCount; ++i) {
+            text << " " << phaseName(static_cast<Phase>(i)) << " " << seconds(totals.phaseNanos[i]);
+        }
+        text << "\n";
+    }
+    return text.str();
+}
+
+/**
+ * @brief Formats reports as JSON, for tracking them between releases.
+ * @param reports The reports.
+ * @return std::string - A JSON document with one object per operation.
+ */
+std::string formatJson(const std::vector<OperationReport>& reports) {
+    std::ostringstream json;
+    json << std::setprecision(9);
+    json << "{\n  \"version\": 1,\n  \"operations\": [";
+    for (std::size_t r = 0; r < reports.size(); ++r) {
+        const OperationReport& report = reports[r];
+        json << (r == 0 ? "\n" : ",\n");
+        json << "    {\"name\": " << jsonString(report.name) << ", \"wall_seconds\": " << report.wallSeconds
+             << ", \"peak_memory_bytes\": " << report.peakMemoryBytes << ",\n     \"counters\": {";
+        for (std::size_t i = 0; i < counterCount; ++i) {
+            json << (i == 0 ? "" : ", ") << "\"" << counterName(static_cast<Counter>(i)) << "\": "
+                 << report.totals.counters[i];
+        }
+        json << "},\n     \"phase_seconds\": {";
+        for (std::size_t i = 0; i < phaseCount; ++i) {
+            json << (i == 0 ? "" : ", ") << "\"" << phaseName(static_cast<Phase>(i)) << "\": "
+                 << seconds(report.totals.phaseNanos[i]);
+        }
+        json << "}}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+/**
+ * @brief Writes reports as JSON to a file.
+ * @param path The file to (re)write.
+ * @param reports The reports.
+ */
+void writeJson(const std::string& path, const std::vector<OperationReport>& reports) {
+    std::ofstream output(path, std::ios::trunc);
+    output << formatJson(reports);
+    output.close();
+    if (!output) {
+        throw std::runtime_error("Error writing statistics file: " + path);
+    }
+}
+
+}
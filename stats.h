@@ -0,0 +1,134 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Process-wide performance counters, phase timers and per-operation reports.
+ *
+ * Counters and phase times are relaxed atomics, cheap enough to stay on in the hot
+ * paths. Phase times are summed over all the threads that worked in that phase, so with
+ * the thread pool they can exceed the wall time of the operation. An Operation records
+ * what changed between its construction and its destruction.
+ */
+namespace Stats {
+
+enum class Counter {
+    FilesScanned,
+    BytesRead,
+    BytesHashed,
+    BytesWritten,
+    LockWaitNanos,
+    LockContentions,
+    Count
+};
+
+enum class Phase {
+    Traversal,
+    Hashing,
+    Compression,
+    Io,
+    Metadata,
+    Count
+};
+
+const std::size_t counterCount = static_cast<std::size_t>(Counter::Count);
+const std::size_t phaseCount = static_cast<std::size_t>(Phase::Count);
+
+void add(Counter counter, uint64_t amount = 1);
+void addTime(Phase phase, uint64_t nanoseconds);
+uint64_t peakMemoryBytes();
+
+const char* counterName(Counter counter);
+const char* phaseName(Phase phase);
+
+/**
+ * @brief Values of all the counters and phase times at one moment.
+ */
+struct Snapshot
+{
+    uint64_t counters[counterCount] = {};
+    uint64_t phaseNanos[phaseCount] = {};
+
+    static Snapshot take();
+    Snapshot operator-(const Snapshot& earlier) const;
+};
+
+/**
+ * @brief What one add, commit, revert... cost.
+ */
+struct OperationReport
+{
+    std::string name;
+    double wallSeconds = 0;
+    Snapshot totals;
+    uint64_t peakMemoryBytes = 0;
+};
+
+/**
+ * @brief Adds the time spent in its scope to a phase.
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Phase phase) : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        addTime(phase_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Records an OperationReport for its scope.
+ */
+class Operation
+{
+public:
+    explicit Operation(std::string name);
+    ~Operation();
+
+    Operation(const Operation&) = delete;
+    Operation& operator=(const Operation&) = delete;
+
+private:
+    std::string name_;
+    Snapshot start_;
+    std::chrono::steady_clock::time_point started_;
+};
+
+/**
+ * @brief Locks a mutex, counting the time spent waiting when it is contended.
+ */
+template <typename Mutex>
+std::unique_lock<Mutex> timedLock(Mutex& mutex) {
+    std::unique_lock<Mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        add(Counter::LockWaitNanos, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+        add(Counter::LockContentions);
+    }
+    return lock;
+}
+
+std::vector<OperationReport> reports();
+void clearReports();
+std::string formatText(const std::vector<OperationReport>& reports);
+std::string formatJson(const std::vector<OperationReport>& reports);
+void writeJson(const std::string& path, const std::vector<OperationReport>& reports);
+
+}
+
+#endif // STATS_H
@@ -0,0 +1,112 @@
+#include <miniversioncontrol.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    if (!condition) {
+        ++failures;
+        std::cerr << "commit: " << what << std::endl;
+    }
+}
+
+void writeText(const fs::path& path, const std::string& text) {
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path());
+    }
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+/**
+ * @brief Stages a file the way older versions did: "1234", the content, then the
+ * FNV-1a checksum of both.
+ */
+void stageFullCopy(const fs::path& path, const std::string& content) {
+    std::string stored = "1234" + content;
+    uint32_t checksum = 2166136261U;
+    for (char ch : stored) {
+        checksum ^= static_cast<uint32_t>(ch);
+        checksum *= 16777619;
+    }
+    char checksumBytes[sizeof(checksum)];
+    std::memcpy(checksumBytes, &checksum, sizeof(checksum));
+    stored.append(checksumBytes, sizeof(checksum));
+    writeText(".git/staging" / path, stored);
+}
+
+std::string readText(const fs::path& path) {
+    std::ifstream input(path, std::ios::binary);
+    std::ostringstream text;
+    text << input.rdbuf();
+    return text.str();
+}
+
+}
+
+int main() {
+    const fs::path repository = fs::temp_directory_path()
+        / ("committest_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(repository);
+    const fs::path previous = fs::current_path();
+    fs::current_path(repository);
+
+    try {
+        MiniVersionControl vcs;
+        vcs.init();
+
+        // Older versions staged full copies of the files
+        const std::string large(100000, 'x');
+        stageFullCopy("old.txt", "staged by an older version\n");
+        stageFullCopy("sub/large.txt", large);
+        stageFullCopy("sub/empty.txt", "");
+        writeText("new.txt", "staged as a reference\n");
+        vcs.add("new.txt");
+
+        vcs.commit("legacy staging area");
+        std::vector<std::string> versions = vcs.listVersions();
+        expect(versions.size() == 1, "the legacy staging area was not committed");
+        expect(fs::is_empty(".git/staging"), "the staging area was not emptied");
+
+        if (versions.size() == 1) {
+            const std::string commit = ".git/commits/" + versions.front();
+            std::vector<std::string> files = vcs.listVersionFiles(commit);
+            expect(files == std::vector<std::string>({"new.txt", "old.txt", "sub/empty.txt", "sub/large.txt"}),
+                   "the commit does not list the staged files");
+
+            fs::remove("new.txt");
+            vcs.revert(commit);
+            expect(readText("old.txt") == "staged by an older version\n", "old.txt was not restored");
+            expect(readText("sub/large.txt") == large, "sub/large.txt was not restored");
+            expect(fs::exists("sub/empty.txt") && fs::file_size("sub/empty.txt") == 0, "sub/empty.txt was not restored");
+            expect(readText("new.txt") == "staged as a reference\n", "new.txt was not restored");
+            for (const FileStatus& file : vcs.status()) {
+                expect(file.state == FileState::Unchanged,
+                       file.path + " is " + FileStatus::stateName(file.state) + " after the revert");
+            }
+        }
+    } catch (const std::exception& e) {
+        expect(false, e.what());
+    }
+
+    fs::current_path(previous);
+    fs::remove_all(repository);
+
+    if (failures > 0) {
+        std::cerr << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "commit: all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,11 @@
+# Checks that a staging area left by older versions, which held full copies rather than
+# references, still commits and reverts; exits with a non-zero status on failure, e.g.
+# "committest" from the build directory.
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../../core/core.pri)
+
+SOURCES += \
+    committest.cpp
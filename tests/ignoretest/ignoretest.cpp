@@ -0,0 +1,124 @@
+#include <ignorerules.h>
+
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+struct Case
+{
+    const char* path;
+    bool directory;
+    bool ignored;
+};
+
+/**
+ * @brief Compiles the patterns and checks whether each path is ignored as expected.
+ */
+void check(const char* name, std::initializer_list<const char*> patterns, std::initializer_list<Case> cases) {
+    IgnoreRules rules;
+    for (const char* pattern : patterns) {
+        rules.addPattern(pattern);
+    }
+    for (const Case& item : cases) {
+        bool ignored = rules.ignored(item.path, item.directory);
+        if (ignored != item.ignored) {
+            ++failures;
+            std::cerr << name << ": " << item.path << (item.directory ? "/" : "") << " should "
+                      << (item.ignored ? "" : "not ") << "be ignored" << std::endl;
+        }
+    }
+}
+
+}
+
+int main() {
+    check("comments and blanks", {"# build", "", "   "}, {
+        {"build", true, false},
+        {"# build", false, false},
+    });
+    check("names at any depth", {"node_modules", "*.o", "cache*", "a?c", "[0-9]x"}, {
+        {"node_modules", true, true},
+        {"src/node_modules", true, true},
+        {"src/node_modules/x/y.js", false, true},
+        {"main.o", false, true},
+        {"src/lib/main.o", false, true},
+        {"main.c", false, false},
+        {"cachefiles", true, true},
+        {"mycache", true, false},
+        {"abc", false, true},
+        {"abbc", false, false},
+        {"5x", false, true},
+        {"ax", false, false},
+    });
+    check("directories only", {"build/", "src/gen/"}, {
+        {"build", true, true},
+        {"build", false, false},
+        {"x/build/y.c", false, true},
+        {"src/gen", true, true},
+        {"x/src/gen", true, false},
+    });
+    check("anchored", {"/top.txt", "doc/**/*.pdf", "logs/**"}, {
+        {"top.txt", false, true},
+        {"src/top.txt", false, false},
+        {"doc/a.pdf", false, true},
+        {"doc/x/y/a.pdf", false, true},
+        {"x/doc/a.pdf", false, false},
+        {"logs", true, false},
+        {"logs/a/b", false, true},
+    });
+    check("negation", {"*.o", "!keep.o"}, {
+        {"a.o", false, true},
+        {"keep.o", false, false},
+        {"src/keep.o", false, false},
+    });
+    check("escapes and spaces", {"\\#hash", "\\!bang", "trail   "}, {
+        {"#hash", false, true},
+        {"!bang", false, true},
+        {"trail", false, true},
+    });
+    check("everything", {"*"}, {
+        {"foo", false, true},
+        {"foo", true, true},
+        {"a/b", false, true},
+    });
+    check("everything below the root", {"**/*"}, {
+        {"foo", false, true},
+        {"a/b/c", false, true},
+    });
+    check("everything but a whitelist", {"*", "!keep", "!*.md"}, {
+        {"other", false, true},
+        {"other", true, true},
+        {"keep", false, false},
+        {"keep", true, false},
+        {"README.md", false, false},
+        {"keep/inside", false, true},
+    });
+
+    // Thousands of plain patterns go through the exact, prefix and suffix indexes
+    IgnoreRules many;
+    for (int i = 0; i < 3000; ++i) {
+        many.addPattern("name" + std::to_string(i));
+        many.addPattern("*.ext" + std::to_string(i));
+        many.addPattern("dir" + std::to_string(i) + "/sub/");
+    }
+    for (const Case& item : {Case{"x/name2999", false, true}, Case{"a/b.ext17", false, true},
+                             Case{"a/b.ext3000", false, false}, Case{"dir42/sub", true, true},
+                             Case{"dir42/other", true, false}, Case{"x/dir42/sub", true, false}}) {
+        if (many.ignored(item.path, item.directory) != item.ignored) {
+            ++failures;
+            std::cerr << "many patterns: " << item.path << " should " << (item.ignored ? "" : "not ")
+                      << "be ignored" << std::endl;
+        }
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "ignore rules: all checks passed" << std::endl;
+    return 0;
+}
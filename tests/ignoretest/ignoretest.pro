@@ -0,0 +1,10 @@
+# Checks of the .minigitignore matching; exits with a non-zero status on the first
+# failing run, e.g. "ignoretest" from the build directory.
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+include(../../core/core.pri)
+
+SOURCES += \
+    ignoretest.cpp
@@ -0,0 +1,275 @@
+#include <threadpool.h>
+
+namespace {
+
+// Pool and deque index of the current thread when it is a worker.
+thread_local const void* currentPool = nullptr;
+thread_local std::size_t currentIndex = 0;
+
+}
+
+/**
+ * @brief Starts the worker threads.
+ * @param threads Number of workers; 0 uses the number of hardware threads.
+ */
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) {
+            threads = 4;
+        }
+    }
+
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+/**
+ * @brief Stops the workers once the queued tasks are done.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Returns the pool shared by all operations, sized to the hardware.
+ * @return ThreadPool& - The shared pool.
+ */
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+/**
+ * @brief Returns the number of worker threads.
+ * @return std::size_t - The number of workers.
+ */
+std::size_t ThreadPool::size() const {
+    return threads_.size();
+}
+
+/**
+ * @brief Queues a task.
+ *
+ * A worker pushes to its own deque, which keeps related work on the same core; other
+ * threads spread their tasks round-robin.
+ * @param task The task to run.
+ */
+void ThreadPool::submit(std::function<void()> task) {
+    std::size_t index = currentPool == this
+        ? currentIndex
+        : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    {
+        Queue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1);
+
+    bool helpers;
+    {
+        // Taking the lock orders the increment with a worker checking before sleeping
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        helpers = helpers_ > 0;
+    }
+    // A waiting thread may be the only one able to run it (a single worker blocked in a group)
+    if (helpers) {
+        wake_.notify_all();
+    } else {
+        wake_.notify_one();
+    }
+}
+
+/**
+ * @brief Runs one queued task on the calling thread, if any.
+ * @return bool - true if a task was run.
+ */
+bool ThreadPool::runPendingTask() {
+    std::size_t index = currentPool == this ? currentIndex : nextQueue_.load(std::memory_order_relaxed) % queues_.size();
+    std::function<void()> task;
+    if (!takeTask(index, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+/**
+ * @brief Runs queued tasks on the calling thread until a condition holds, sleeping when there is none.
+ *
+ * Whoever makes the condition true must call notifyWaiters() afterwards.
+ * @param done The condition; it is checked with the pool's sleep mutex held.
+ */
+void ThreadPool::helpUntil(const std::function<bool()>& done) {
+    std::size_t index = currentPool == this ? currentIndex : nextQueue_.load(std::memory_order_relaxed) % queues_.size();
+    std::function<void()> task;
+    while (!done()) {
+        if (takeTask(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        ++helpers_;
+        wake_.wait(lock, [this, &done] { return pending_.load() > 0 || done(); });
+        --helpers_;
+    }
+}
+
+/**
+ * @brief Wakes the threads sleeping in helpUntil() so they check their condition again.
+ */
+void ThreadPool::notifyWaiters() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        if (helpers_ == 0) {
+            return;
+        }
+    }
+    wake_.notify_all();
+}
+
+/**
+ * @brief Pops a task from a worker's own deque, or steals one from another worker.
+ * @param index The deque to look at first.
+ * @param task Receives the task.
+ * @return bool - true if a task was found.
+ */
+bool ThreadPool::takeTask(std::size_t index, std::function<void()>& task) {
+    if (pending_.load() == 0) {
+        return false;
+    }
+
+    {
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Blocking on the victim's lock (held for a push or pop only) means a counted task is
+    // never missed, so an idle worker can sleep until the next submit
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        Queue& victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Main loop of a worker: run tasks, steal when idle, sleep when there is no work.
+ * @param index The index of the worker.
+ */
+void ThreadPool::workerLoop(std::size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (takeTask(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        if (stopping_ && pending_.load() == 0) {
+            return;
+        }
+        wake_.wait(lock, [this] { return stopping_ || pending_.load() > 0; });
+    }
+}
+
+/**
+ * @brief Creates an empty group.
+ * @param pool The pool running the tasks.
+ */
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool), maxQueued_(pool.size() * 64) {
+}
+
+/**
+ * @brief Waits for the remaining tasks; errors are dropped since destructors cannot throw.
+ */
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+/**
+ * @brief Runs a task as part of the group.
+ *
+ * When many tasks of the group are queued and not started yet, the calling thread runs
+ * queued tasks first, which bounds the memory held by pending tasks on very large trees.
+ * Running tasks do not count, so a task may add tasks to its own group.
+ * @param task The task to run.
+ */
+void TaskGroup::run(std::function<void()> task) {
+    if (queued_.load() >= maxQueued_) {
+        pool_.helpUntil([this] { return queued_.load() < maxQueued_; });
+    }
+
+    queued_.fetch_add(1);
+    active_.fetch_add(1);
+    pool_.submit([this, task = std::move(task)] {
+        if (queued_.fetch_sub(1) == maxQueued_) {
+            pool_.notifyWaiters();
+        }
+        if (!failed_.load()) {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                failed_ = true;
+            }
+        }
+        // The group may be gone as soon as the count drops to zero
+        ThreadPool& pool = pool_;
+        if (active_.fetch_sub(1) == 1) {
+            pool.notifyWaiters();
+        }
+    });
+}
+
+/**
+ * @brief Waits until every task of the group ran, helping the pool meanwhile.
+ *
+ * Rethrows the first exception thrown by a task.
+ */
+void TaskGroup::wait() {
+    pool_.helpUntil([this] { return active_.load() == 0; });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        failed_ = false;
+        std::rethrow_exception(error);
+    }
+}
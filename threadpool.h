@@ -0,0 +1,90 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing thread pool shared by add, commit and revert.
+ *
+ * Each worker owns a deque protected by its own mutex: it pushes and pops its own tasks
+ * at the back and, when it runs dry, steals from the front of the other workers. Tasks
+ * submitted from outside the pool are spread round-robin over the deques. Nothing polls:
+ * idle workers and threads waiting in helpUntil() sleep until a task is submitted or
+ * notifyWaiters() is called.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static ThreadPool& shared();
+
+    std::size_t size() const;
+    void submit(std::function<void()> task);
+    bool runPendingTask();
+    void helpUntil(const std::function<bool()>& done);
+    void notifyWaiters();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void workerLoop(std::size_t index);
+    bool takeTask(std::size_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> nextQueue_{0};
+    std::atomic<bool> stopping_{false};
+    std::size_t helpers_ = 0;  // Threads in helpUntil(), guarded by sleepMutex_
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+};
+
+/**
+ * @brief A batch of tasks run on a ThreadPool that can be waited for as a whole.
+ *
+ * The first exception thrown by a task is rethrown by wait(); the tasks that did not
+ * start yet are skipped once a task failed. A thread waiting for the group runs pending
+ * pool tasks instead of blocking, so groups can be nested inside pool tasks.
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared());
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    ThreadPool& pool_;
+    const std::size_t maxQueued_;
+    std::atomic<std::size_t> queued_{0};   // Submitted, not started yet
+    std::atomic<std::size_t> active_{0};   // Submitted, not finished yet
+    std::atomic<bool> failed_{false};
+    std::mutex mutex_;
+    std::exception_ptr error_;
+};
+
+#endif // THREADPOOL_H
@@ -1,26 +1,11 @@
-QT       += core gui
+# The version control core is a static library without Qt; the GUI and the minigit
+# command line tool are built on top of it.
+TEMPLATE = subdirs
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+SUBDIRS += \
+    core \
+    gui \
+    cli
 
-CONFIG += c++17
-
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    main.cpp \
-    mainwindow.cpp \
-    miniversioncontrol.cpp
-
-HEADERS += \
-    mainwindow.h \
-    miniversioncontrol.h
-
-FORMS += \
-    mainwindow.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+gui.depends = core
+cli.depends = core
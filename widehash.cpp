@@ -0,0 +1,332 @@
+#include <widehash.h>
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define WIDEHASH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WIDEHASH_TARGET(name) __attribute__((target(name)))
+#else
+#define WIDEHASH_TARGET(name)
+#endif
+
+namespace {
+
+const uint64_t prime32 = 0x9E3779B1ULL;
+const uint64_t prime64a = 0x9E3779B185EBCA87ULL;
+const uint64_t prime64b = 0xC2B2AE3D27D4EB4FULL;
+
+// Stripe n of a block is keyed with secret[n .. n + 8), the scramble uses the last 8 words.
+const std::size_t secretWords = 24;
+
+constexpr uint64_t splitmix64(uint64_t& state) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr std::array<uint64_t, secretWords> makeSecret() {
+    std::array<uint64_t, secretWords> secret{};
+    uint64_t state = 0x4D696E6947495421ULL;
+    for (std::size_t i = 0; i < secretWords; ++i) {
+        secret[i] = splitmix64(state);
+    }
+    return secret;
+}
+
+alignas(32) constexpr std::array<uint64_t, secretWords> secret = makeSecret();
+
+inline uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t mul128fold64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t aLo = a & 0xffffffffULL, aHi = a >> 32;
+    uint64_t bLo = b & 0xffffffffULL, bHi = b >> 32;
+    uint64_t loLo = aLo * bLo, hiLo = aHi * bLo, loHi = aLo * bHi, hiHi = aHi * bHi;
+    uint64_t cross = (loLo >> 32) + (hiLo & 0xffffffffULL) + loHi;
+    uint64_t upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+    uint64_t lower = (cross << 32) | (loLo & 0xffffffffULL);
+    return lower ^ upper;
+#endif
+}
+
+inline uint64_t avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+void accumulateScalar(uint64_t* acc, const uint8_t* data, std::size_t stripes, std::size_t firstStripe) {
+    for (std::size_t s = 0; s < stripes; ++s) {
+        const uint8_t* p = data + s * WideHasher::stripeSize;
+        const uint64_t* key = secret.data() + firstStripe + s;
+        for (std::size_t i = 0; i < 8; ++i) {
+            uint64_t d = load64(p + 8 * i);
+            uint64_t k = d ^ key[i];
+            acc[i ^ 1] += d;
+            acc[i] += (k & 0xffffffffULL) * (k >> 32);
+        }
+    }
+}
+
+#if defined(WIDEHASH_X86)
+
+WIDEHASH_TARGET("sse2")
+void accumulateSse2(uint64_t* acc, const uint8_t* data, std::size_t stripes, std::size_t firstStripe) {
+    __m128i* vacc = reinterpret_cast<__m128i*>(acc);
+    for (std::size_t s = 0; s < stripes; ++s) {
+        const uint8_t* p = data + s * WideHasher::stripeSize;
+        const uint64_t* key = secret.data() + firstStripe + s;
+        for (std::size_t i = 0; i < 4; ++i) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + i);
+            __m128i k = _mm_xor_si128(d, _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 2 * i)));
+            __m128i kHigh = _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1));
+            __m128i product = _mm_mul_epu32(k, kHigh);
+            __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            vacc[i] = _mm_add_epi64(vacc[i], _mm_add_epi64(product, swapped));
+        }
+    }
+}
+
+WIDEHASH_TARGET("avx2")
+void accumulateAvx2(uint64_t* acc, const uint8_t* data, std::size_t stripes, std::size_t firstStripe) {
+    __m256i* vacc = reinterpret_cast<__m256i*>(acc);
+    for (std::size_t s = 0; s < stripes; ++s) {
+        const uint8_t* p = data + s * WideHasher::stripeSize;
+        const uint64_t* key = secret.data() + firstStripe + s;
+        for (std::size_t i = 0; i < 2; ++i) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p) + i);
+            __m256i k = _mm256_xor_si256(d, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + 4 * i)));
+            __m256i kHigh = _mm256_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1));
+            __m256i product = _mm256_mul_epu32(k, kHigh);
+            __m256i swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            vacc[i] = _mm256_add_epi64(vacc[i], _mm256_add_epi64(product, swapped));
+        }
+    }
+}
+
+bool cpuHasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+#endif // WIDEHASH_X86
+
+void scramble(uint64_t* acc) {
+    const uint64_t* key = secret.data() + secretWords - 8;
+    for (std::size_t i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * prime32;
+    }
+}
+
+uint64_t mergeAccumulators(const uint64_t* acc, std::size_t keyOffset, uint64_t start) {
+    uint64_t result = start;
+    for (std::size_t i = 0; i < 4; ++i) {
+        result += mul128fold64(acc[2 * i] ^ secret[keyOffset + 2 * i], acc[2 * i + 1] ^ secret[keyOffset + 2 * i + 1]);
+    }
+    return avalanche(result);
+}
+
+}
+
+/**
+ * @brief Creates a hasher using the fastest implementation supported by the CPU.
+ */
+WideHasher::WideHasher() : WideHasher(bestImplementation()) {
+}
+
+/**
+ * @brief Creates a hasher using a given implementation (mostly for benchmarks).
+ * @param implementation The implementation; unsupported ones fall back to the scalar one.
+ */
+WideHasher::WideHasher(Implementation implementation) : accumulate_(accumulateScalar) {
+#if defined(WIDEHASH_X86)
+    if (isSupported(implementation)) {
+        if (implementation == Implementation::Avx2) {
+            accumulate_ = accumulateAvx2;
+        } else if (implementation == Implementation::Sse2) {
+            accumulate_ = accumulateSse2;
+        }
+    }
+#else
+    (void)implementation;
+#endif
+    reset();
+}
+
+/**
+ * @brief Returns the fastest implementation supported by the CPU.
+ * @return Implementation - The implementation used by default.
+ */
+WideHasher::Implementation WideHasher::bestImplementation() {
+    static const Implementation best = isSupported(Implementation::Avx2) ? Implementation::Avx2
+                                     : isSupported(Implementation::Sse2) ? Implementation::Sse2
+                                     : Implementation::Scalar;
+    return best;
+}
+
+/**
+ * @brief Checks whether an implementation can run on this CPU.
+ * @param implementation The implementation to check.
+ * @return bool - true if it is supported.
+ */
+bool WideHasher::isSupported(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::Scalar:
+        return true;
+#if defined(WIDEHASH_X86)
+    case Implementation::Sse2:
+        return true;
+    case Implementation::Avx2: {
+        static const bool hasAvx2 = cpuHasAvx2();
+        return hasAvx2;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Returns a printable name for an implementation.
+ * @param implementation The implementation.
+ * @return const char* - Its name.
+ */
+const char* WideHasher::implementationName(Implementation implementation) {
+    switch (implementation) {
+    case Implementation::Scalar:
+        return "scalar";
+    case Implementation::Sse2:
+        return "sse2";
+    case Implementation::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Puts the hasher back in its initial state.
+ */
+void WideHasher::reset() {
+    acc_[0] = prime32;
+    acc_[1] = prime64a;
+    acc_[2] = prime64b;
+    acc_[3] = 0x165667B19E3779F9ULL;
+    acc_[4] = 0x85EBCA77C2B2AE63ULL;
+    acc_[5] = 0x27D4EB2F165667C5ULL;
+    acc_[6] = prime64a ^ prime64b;
+    acc_[7] = 0x61C8864E7A143579ULL;
+    buffered_ = 0;
+    total_ = 0;
+}
+
+/**
+ * @brief Accumulates whole blocks, scrambling the accumulators after each of them.
+ * @param data Pointer to the blocks.
+ * @param blocks Number of blocks.
+ */
+void WideHasher::consumeBlocks(const uint8_t* data, std::size_t blocks) {
+    for (std::size_t b = 0; b < blocks; ++b) {
+        accumulate_(acc_, data + b * blockSize, blockSize / stripeSize, 0);
+        scramble(acc_);
+    }
+}
+
+/**
+ * @brief Adds a chunk of data to the hash.
+ * @param data Pointer to the bytes.
+ * @param size Number of bytes.
+ */
+void WideHasher::update(const char* data, std::size_t size) {
+    const uint8_t* input = reinterpret_cast<const uint8_t*>(data);
+    total_ += size;
+
+    if (buffered_ > 0) {
+        std::size_t take = blockSize - buffered_;
+        if (take > size) {
+            take = size;
+        }
+        std::memcpy(buffer_ + buffered_, input, take);
+        buffered_ += take;
+        input += take;
+        size -= take;
+        if (buffered_ < blockSize) {
+            return;
+        }
+        consumeBlocks(buffer_, 1);
+        buffered_ = 0;
+    }
+
+    std::size_t blocks = size / blockSize;
+    consumeBlocks(input, blocks);
+    input += blocks * blockSize;
+    size -= blocks * blockSize;
+
+    std::memcpy(buffer_, input, size);
+    buffered_ = size;
+}
+
+/**
+ * @brief Returns the 128-bit hash of all the data added so far and resets the hasher.
+ * @return Digest - The hash.
+ */
+Digest WideHasher::finish() {
+    alignas(32) uint64_t acc[8];
+    std::memcpy(acc, acc_, sizeof(acc));
+
+    // The tail is zero padded to whole stripes; the length is mixed in below
+    std::size_t stripes = (buffered_ + stripeSize - 1) / stripeSize;
+    std::memset(buffer_ + buffered_, 0, stripes * stripeSize - buffered_);
+    accumulate_(acc, buffer_, stripes, 0);
+
+    uint64_t low = mergeAccumulators(acc, 0, total_ * prime64a);
+    uint64_t high = mergeAccumulators(acc, 8, ~total_ * prime64b);
+
+    Digest digest;
+    digest.size = 16;
+    for (std::size_t i = 0; i < 8; ++i) {
+        digest.bytes[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+        digest.bytes[8 + i] = static_cast<uint8_t>(low >> (56 - 8 * i));
+    }
+
+    reset();
+    return digest;
+}
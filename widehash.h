@@ -0,0 +1,50 @@
+#ifndef WIDEHASH_H
+#define WIDEHASH_H
+
+#include <checksum.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fast 128-bit hash used for object ids and stored file trailers.
+ *
+ * The input is processed in 64-byte stripes feeding eight 64-bit accumulators with
+ * 32x32->64 multiplications, which map directly to SSE2/AVX2 lanes. The best
+ * implementation supported by the CPU is picked at runtime; all of them produce the
+ * same digest.
+ */
+class WideHasher : public Hasher
+{
+public:
+    enum class Implementation { Scalar, Sse2, Avx2 };
+
+    WideHasher();
+    explicit WideHasher(Implementation implementation);
+
+    HashAlgorithm algorithm() const override { return HashAlgorithm::Wide128; }
+    void update(const char* data, std::size_t size) override;
+    Digest finish() override;
+    using Hasher::update;
+
+    static Implementation bestImplementation();
+    static bool isSupported(Implementation implementation);
+    static const char* implementationName(Implementation implementation);
+
+    static const std::size_t stripeSize = 64;
+    static const std::size_t blockSize = 16 * stripeSize;
+
+private:
+    using AccumulateFunction = void (*)(uint64_t* acc, const uint8_t* data, std::size_t stripes, std::size_t firstStripe);
+
+    void reset();
+    void consumeBlocks(const uint8_t* data, std::size_t blocks);
+
+    AccumulateFunction accumulate_;
+    alignas(32) uint64_t acc_[8];
+    uint8_t buffer_[blockSize];
+    std::size_t buffered_ = 0;
+    uint64_t total_ = 0;
+};
+
+#endif // WIDEHASH_H